@@ -0,0 +1,5806 @@
+/* MULTOUT.C (double prec) */
+/* release version */
+/* copyright 1992,1993,1994,1995,1996 by David L. Woodruff and David M. Rocke */
+/* AS IS */
+/* THERE IS NO WARRANTY OF ANY KIND */
+/* This software may be freely distributed for non-commercial use. */
+
+/* Compilation Notes: */
+/* 1. This is a single file C program using only standard libraries */
+/* 2. You will need the -lm linker switch on most Unix and related systems */
+/* 3. You will almost surely need to use a large memory model on a 16 bit PC */
+
+/* Other Notes: */
+/* 0. This program assumes that the data are in general position */
+/* 1. see the function Info_Exit() for usage instructions */
+/* 2. see the paper "Idenfication of Outliers in Multivariate Data" */
+/*    by Rocke and Woodruff for detailed explanations */
+/* 3. the program gencross.c can generate test data */
+/* 4. The optional parms file is for experts only; see Load_Parms() */
+/* 5. If the outlier detection phase is too slow, */
+/*    you can increase the simulation tolerance (the last parm) */
+/* 6. Singularities in the data are not handled very well (see 0.)*/
+/* 7. send questions to dlwoodruff@ucdavis.edu; (916)752-0515 */
+/* 8. Simulated cutoffs can be kept between runs (-cache dir) and a */
+/*    built-in table covers common (n,p) (-table); see Rej_Cutoff() */
+
+#define BANNER "multout version 3.03.1\nCopyright 1992,93,94,95,96 by David L. Woodruff and David M. Rocke\n"
+
+/* Release Notes: */
+/* 
+Differences between 2.00.04 and 3.00
+1. The program outputs an M-Estimate of location and shape before beginning
+   the simulations for outlier cutoff and the file is closed. Hence, the
+   program can be killed during the simulations and useful output will
+   be present.
+2. The program outputs the final estimate of location and shape used to 
+   generate the robust distances.
+*/
+/*3.01 
+1. One error message preceded by *error* 
+2. exit(1) if singularity is encountered 
+3. iterations is now an optional command line arg
+*/
+/* 3.02
+1. changes in singularity messages
+*/
+/* 3.03 changes in comments */
+
+#define _GNU_SOURCE      /* for fopencookie */
+#include <stdio.h>       /* magical incantations */
+#include <stdlib.h>
+#include <malloc.h>
+#include <math.h>
+#include <assert.h>
+#include <memory.h>
+#include <search.h>
+#include <float.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#ifdef _OPENMP
+#   include <omp.h>
+#endif
+#ifdef HAVE_ZLIB
+#   include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#   include <zstd.h>
+#endif
+#include <stdarg.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include "multout.h"
+
+/* the library: each thread runs its own analysis, so the globals are */
+/* thread local (TLS); each call of the interface in multout.h swaps */
+/* them in from the caller's struct MultOut and back out (Call_Enter). */
+/* printf goes to the analysis's log, exit() returns from the call with */
+/* an error code, and the heap is tracked so that a run can be freed; */
+/* so are open files, which a call that fails closes (Call_Leave) */
+#define TLS __thread
+int Log_Printf(const char *Fmt, ...);
+void Fail(int Code) __attribute__((noreturn));
+void *Heap_Alloc(size_t n);
+void *Heap_Calloc(size_t n, size_t Size);
+void *Heap_Realloc(void *p, size_t n);
+void Heap_Free(void *p);
+#define printf Log_Printf
+#define exit(s) Fail(s)
+#define malloc(n) Heap_Alloc(n)
+#define calloc(n,s) Heap_Calloc(n,s)
+#define realloc(p,n) Heap_Realloc(p,n)
+#define free(p) Heap_Free(p)
+FILE *File_Track(FILE *f);
+FILE *File_Adopt(int fd, FILE *f);
+int File_Close(FILE *f);
+int Fd_Track(int fd);
+int Fd_Close(int fd);
+#define fopen(n,m) File_Track(fopen(n,m))
+#define fdopen(fd,m) File_Adopt(fd, fdopen(fd,m))
+#define fclose(f) File_Close(f)
+#define open(...) Fd_Track(open(__VA_ARGS__))
+#define close(fd) Fd_Close(fd)
+#ifdef _OPENMP
+#   define Omp_Level() omp_get_level()
+#else
+#   define Omp_Level() 0
+#endif
+#define MSG_LEN 512
+struct Heap;
+TLS struct Heap *CallHeap = NULL;       /* the analysis's allocations */
+TLS FILE *CallLog = NULL;               /* its log (NULL: none) */
+TLS int CallLevel = 0;                  /* Omp_Level() of the call */
+TLS jmp_buf *CallJump = NULL;           /* where Fail returns to */
+TLS int CallCode = MO_OK;               /* and with what */
+TLS char Msg[MSG_LEN];                  /* the last paragraph logged */
+TLS int MsgLen = 0, MsgNew = 0;         /*   its length, and if it ended */
+TLS int MsgHold = 0;                    /*   keep it (Info_Exit) */
+
+/* the threads of a run's parallel regions cannot be unwound to */
+/* CallJump: in one of them, Fail notes the error for the whole team */
+/* (Region_Fail) and ends the thread's TASK, and REGION_ALLCHK just */
+/* notes a failed allocation; the work after it is skipped (the later */
+/* TASKs, and what REGION_FAILED guards), and once the region is over */
+/* Region_Check fails the call.  A TASK is the whole body of a small */
+/* function, as what it changes in local variables is lost if it fails */
+struct RegionErr {
+  volatile int Code;                    /* MO_OK, or Fail's code */
+  char Msg[MSG_LEN];                    /* the failing thread's Msg */
+};
+TLS struct RegionErr CallRegion;        /* the calling thread's, */
+TLS struct RegionErr *RegionErr = NULL; /*   shared by its teams */
+TLS jmp_buf *TaskJump = NULL;           /* the end of the thread's TASK */
+void Region_Fail(int Code);
+void Region_Check();
+#define TASK(...) {jmp_buf TaskEnd; \
+    if (!RegionErr->Code) {if (!setjmp(TaskEnd)) {TaskJump = &TaskEnd; __VA_ARGS__}} \
+    TaskJump = NULL;}
+#define REGION_ALLCHK(x) if (x == NULL) {printf ("allocation error\n"); Region_Fail(1);}
+#define REGION_FAILED (RegionErr->Code != MO_OK)
+
+/*------------------------------------------------------------------*/
+void Usage()
+/* give the user some hints */
+{
+  printf("Usage: multout [options] infile outfile [iterations [parmsfile]]\n");
+  printf("       multout [options] -batch manifest index\n");
+  printf("       multout [options] -score model infile outfile\n");
+  printf("       multout [options] -serve socket model ...\n");
+  printf("       multout [options] -client socket model infile outfile\n\n");
+  printf(" where infile contains: p n\n"); 
+  printf("                        data record one (p data elements)\n");
+  printf("                        data record two\n");
+  printf("                            . . . \n");
+  printf("and iterations is an integer controlling the time spent.\n");
+  printf("For light contamination use 1 iteration; for heavy,");
+  printf(" try (n)(p) or more.\n");
+  printf("If it is not specified, (n)(p) is used.\n");
+  printf("\nOptions:\n");
+  printf("  -cache dir   keep simulated outlier cutoffs in dir for reuse\n");
+  printf("               (the environment variable MULTOUT_CACHE also works)\n");
+  printf("  -table       use the built-in cutoff table when it covers (n,p)\n");
+  printf("  -threads n   number of threads for the cutoff simulation\n");
+  printf("  -pool        pool the simulated tails of all rounds for the cutoff\n");
+  printf("  -prec r      simulate until the 95%% confidence interval of the\n");
+  printf("               cutoff is within r (relative) instead of using the\n");
+  printf("               simulation tolerance; e.g. -prec 0.02\n");
+  printf("  -vr          variance reduced cutoff simulation (importance\n");
+  printf("               sampled probes), for cut fractions of 0.001 or less\n");
+  printf("  -approx      closed form (scaled F) cutoff; no simulation at all\n");
+  printf("  -check       simulate, but also report the closed form cutoff\n");
+  printf("  -seed s      random number seed (instead of reading SEED.DAT)\n");
+  printf("  -verify      check the checksum of a binary matrix infile\n");
+  printf("  -echo file   write the data echo of the report to file as a\n");
+  printf("               binary matrix instead of as text\n");
+  printf("  -results f   also write the per point results (index, distance,\n");
+  printf("               weight, outlier flag, J set membership) and the\n");
+  printf("               estimates to f as a binary columnar file\n");
+  printf("  -model f     also write the fitted model to f\n");
+  printf("  -score m     score the rows of infile against the model m: the\n");
+  printf("               distance and outlier flag of each go to outfile (a\n");
+  printf("               binary matrix if its name ends in .bin)\n");
+  printf("               An infile of - scores rows from stdin as they\n");
+  printf("               arrive, a line of values each\n");
+  printf("  -cols list   use only these columns of infile (one based, in\n");
+  printf("               file order), e.g. -cols 1,4,7-9\n");
+  printf("  -collapse    count duplicate points instead of stopping: each\n");
+  printf("               distinct point is used once with its frequency\n");
+  printf("               (half samples are then half of the distinct points,\n");
+  printf("               not half of n, which changes the breakdown point)\n");
+  printf("  -stream      out-of-core mode for binary matrix infiles larger\n");
+  printf("               than memory: the file is read in passes and one\n");
+  printf("               partition cell at a time (uses the -approx cutoff)\n");
+  printf("  -cells k     partition cells searched in stream mode (default 10)\n");
+  printf("  -sections l  report only the sections in the comma separated list\n");
+  printf("               l of mean, cov, dist, flags, data, parms (default all;\n");
+  printf("               flags without dist lists just the potential outliers)\n");
+  printf("  -batch file  run the jobs listed in file, one per line (infile\n");
+  printf("               outfile [iterations [parmsfile]]), several at once,\n");
+  printf("               and write a summary of them to index\n");
+  printf("  -group c     analyse each group of rows with the same value in\n");
+  printf("               column c separately: the reports go to outfile.value\n");
+  printf("               and a summary of the groups to outfile\n");
+  printf("  -jobs k      batch jobs or groups run at once, or the threads of\n");
+  printf("               -serve (default one per processor)\n");
+  printf("  -serve s     keep the model files in memory, reloading any that\n");
+  printf("               change, and score requests for them on the Unix\n");
+  printf("               domain socket s\n");
+  printf("  -client s    score infile against the model served on s\n");
+  printf("\nThe infile can also be a binary matrix file (mulcross -b), and it\n");
+  printf("can be gzip or zstd compressed. A report named *.gz or *.zst is\n");
+  printf("written compressed, and an outfile of - is stdout.\n");
+  printf("\nExample: multout suspect.dat suspect.out 10000\n");
+}
+
+/*------------------------------------------------------------------*/
+void Info_Exit()
+/* give the user some hints, then exit */
+{
+  MsgHold = 1;          /* the error is whatever came before the hints */
+  Usage();
+  exit(MO_USAGE);
+}
+/*------------------------------------------------------------------*/
+
+/* parms */
+TLS int Lambda;                         /* target partition size */
+TLS float Cut1, Cut2;                   /* for outlier ID */
+TLS float SimTol;
+TLS int ParmsSet = 0;                   /* MO_Set_Parms gave these four */
+TLS int SetLambda, SetTrace;            /*   in place of the defaults */
+TLS float SetCut, SetSimTol;
+TLS char *CacheDir = NULL;              /* NULL: no persistent cutoff cache */
+TLS int UseCutTable = 0;                /* consult the built-in cutoff table */
+TLS int Threads = 0;                    /* 0: let OpenMP decide */
+TLS int PoolTails = 0;                  /* pool simulated tails over rounds */
+TLS float CutPrec = 0.;                 /* >0: relative CI half width goal */
+TLS double CutHalf = 0.;                /* 95% CI half width of the cutoff */
+TLS int VarRed = 0;                     /* variance reduced simulation */
+#define SIMULATE 0                      /* CutMode values: */
+#define APPROX 1                        /*   closed form first cutoff */
+#define CHECK 2                         /*   simulate, compare closed form */
+TLS int CutMode = SIMULATE;
+TLS int VerifyData = 0;                 /* check binary input checksums */
+TLS char *EchoFile = NULL;              /* binary data echo, not text */
+#define R_MEAN 1                        /* report sections (-sections): */
+#define R_COV 2
+#define R_DIST 4                        /*   every point's distance */
+#define R_FLAGS 8                       /*   outlier marks */
+#define R_DATA 16                       /*   the data echo */
+#define R_PARMS 32
+#define R_ALL 63
+TLS int Sections = R_ALL;
+TLS FILE *ReportOut = NULL;             /* the report, for outfile "-" */
+TLS int StreamMode = 0;                 /* out-of-core: see Stream_Open */
+TLS long StreamCells = 0;               /* cells searched (0: default) */
+TLS double ApproxCut = 0.;              /* the closed form value */
+TLS long CutBlocks = 0;                 /* simulated samples behind it */
+TLS char *CutoffSource = "simulation";  /* where the first cutoff came from */
+TLS double FirstCut = 0.;               /* and what it was */
+TLS double FinalCut = 0.;               /* the second stage cutoff */
+TLS char *ResultsFile = NULL;           /* -results: columnar result file */
+TLS char *ModelFile = NULL;             /* -model: the fitted model */
+TLS double Secs[4];                     /* wall clock: load, search, */
+                                        /*   cutoff, outlier ID */
+TLS int Collapse = 0;                   /* -collapse: duplicates get weights */
+TLS char *ColSpec = NULL;               /* -cols: the columns to use */
+
+/* define the algorithm begin used */
+#define BaseSubSampleSize (int)(XCnt/2)       /* whence we "lap" */
+/* define the means of evaluating a partition as SCRIT or MVECRIT */
+
+/*#include "std.c"*/
+
+/* to allow compilation of the same code on the DECstations */
+/* set host ULTRIX or PC */
+#define PC 1
+#define ULTRIX 2
+
+#define HOST ULTRIX
+/* version 6: Ultrix really means OSF/1 */
+#if HOST == ULTRIX
+#   define far                          /* no need for memory kludges */
+#   define _fmalloc malloc              /* ditto */
+#   define _ffree free
+#endif
+
+#define True -1 			/* for use in */
+#define False 0 			/* setting vars only  */
+
+#define SEEDFILE "SEED.DAT"		/* to allow variations in seed */
+#define DEFAULT_SEED 1103854129         /* the library's, for MO_Run */
+#define CACHEFILE "multout.cut"         /* cutoff cache, inside CacheDir */
+#define CUTOFF_VERSION "rej5"           /* change when Sq_Rej_Dist changes */
+#define CI_ROUNDS 10                    /* fewest rounds (batches) for a CI */
+
+#define ALLCHK(x) if (x == NULL) {printf ("allocation error\n"); exit(1);}
+#define NTOL (double)0.00001            /* newton tolerance */
+#define WTOL (double)0.001              /* weight convergence tolerance */
+/*#define LTOL 1./(double)(XCnt*VectLen)*/  /* lambda tolerance */
+#define LTOL 1./(double)VectLen            /* lambda tolerance */ /*12/21/92*/
+#define NTIMEOUT 100                    /* max newton iters */
+#define GMULT 1.2                       /* controls ghost precision */
+#define dabs(x) (((x) < 0.) ? -(x) : (x))
+
+/* shared parms */
+TLS int Trace;			  /* controls debug trace dump info */
+TLS long ItersAllowed;
+
+/* global data */
+TLS int VectLen;			  /* number of attributes */
+TLS int XCnt;			  /* number of observations */
+TLS double *X;			  /* The observations */
+#define XRow(i) (X+(i-1)*VectLen)
+#define Xof(i,j) *(X+(i-1)*VectLen+j-1) /* X[i,j] */
+TLS double InstanceID = 0.;   /* to hash an instance ID using Diag of data */
+/* with -cols, X holds only some of the file's columns (see Select_Cols) */
+TLS int FileCols;			  /* columns in the file */
+TLS int *ColAt = NULL;		  /* file column -> column of X, or -1 */
+TLS int *ColOf = NULL;		  /* column of X -> file column (one based) */
+/* with -collapse, each row of X stands for Freq of the data's points */
+TLS int *Freq = NULL;		  /* NULL: every row counts once */
+#define Freqof(i) (Freq ? *(Freq+(i)-1) : 1)   /* Freq[i] */
+TLS int *RowOf;			  /* where each row was first in the data */
+TLS long NPoints;			  /* the sum of Freq */
+
+/* the J set is defined by non-zero JBit indicators */
+TLS int *JBits;			  /* indicators for J set (squander bits) */
+TLS int *BestJBits;			  /* best XJ seen so far */
+TLS int *OnesList, *ZerosList;	  /* indexes of bits set and zero */
+TLS double *XBarJ;			  /* x bar values for the J set */
+#define XBarJof(i) *(XBarJ+i-1)   /* XBarJ[i] */
+TLS double *XJ;			  /* data matrix corresp. to J set */
+#define XJof(i,j) *(XJ+(i-1)*VectLen+j-1) /* XJ[i,j] */
+TLS int *XJFreq;			  /* Freq for the rows of XJ */
+#define XJFreqof(i) (Freq ? *(XJFreq+(i)-1) : 1)
+TLS double JWt;			  /* points in the J set (Form_ZJ) */
+TLS double *ZJ;			  /* e concat XJ */
+#define ZJof(i,j) *(ZJ+(i-1)*(VectLen+1)+j-1) /* ZJ[i,j] */
+
+/* covariance matrix, rectangular space to facilitate GJ inversion */
+/* the inverse is going to be in the right half of the C matrix, so */
+/* space is not allocated, just a macro to get at the data */
+TLS double *C;			  /* COLUMN MAJOR covariance matrix */
+#define Cof(i,j) (*(C+(i-1)+(j-1)*VectLen))  /* C[i,j] */
+TLS double *A;			  /* ZZt */
+#define Aof(i,j) (*(A+(i-1)+(j-1)*(VectLen+1)))  /* A[i,j] */
+TLS double Determinant;    /* the product of the pivots, in this case */
+#define C_1of(i,j) *(C+VectLen*VectLen+(i-1)+(j-1)*VectLen)	/* C-1[i,j] */
+#define A_1of(i,j) *(A+(VectLen+1)*(VectLen+1)+(i-1)+(j-1)*(VectLen+1))
+TLS long SingularCnt=0;		  /* count the number of Det=0 seen */
+
+/* many of these vectors are global only to make dynamic allocation easy */
+/* the so-called sqresiduals vector is the squared mahalanobis distances */
+TLS double *SqResiduals;   /* squared distances, zero based */
+TLS double *kSqSpace;  /* for sorting in compute_k */
+TLS double *dTilde;    /* modified distances (used in s estimation) */
+TLS double *wVector;   /* weights vector stored to save comp. & test converg.*/
+TLS double *OldwVector;    /* last iteration's wieght vector */
+TLS double Sumw, Sumv; /* save some time in M iterations */
+TLS double mJ2;	       /* the left hand side of Rouss...(1.24) */
+TLS double c1=0., b0=0.;    /* "constants" for S estimation " */
+TLS double M=0.;       /* "constant" for t-biweight */
+TLS double ActualBP;   /* breakdown point implied by c and b0 <= RequestedBP */
+TLS double *uAu;       /* local to the descent routine */
+TLS double *MBar, *MC; /* the M-estimate, as ID_Good found it */
+TLS double *MFit;      /*   and its scatter, not inverted (p by p) */
+TLS double *FitC;      /* the scatter (not inverted) the distances are from */
+/* also need a record for the times when we want to know who is at the dist */
+struct ResidRec{
+    double SqMahalDist; 	  /* distance to the point */
+    int SampleNum;		  /* index into X */
+};
+TLS struct ResidRec *ResidRecs;	  /* to be used whenever needed */
+TLS struct ResidRec *kRecs;	  /* for sorting in compute_k with Freq */
+
+/* Random Number generator declarations */
+/* Philox4x32-10 (Salmon et al., SC11): the k-th block of 4 words of */
+/* stream (seed, space, index) is a fixed function of its counter, so any */
+/* stream can be started anywhere, in any thread, in any order */
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+#define RS_MAIN 0         /* stream spaces: the estimation */
+#define RS_SIM 1          /*   cutoff simulation blocks */
+#define RS_PERM 2         /*   stream mode cell permutation */
+struct RStream {
+    uint32_t Key[2];      /* the run seed */
+    uint32_t Id[2];       /* counter words 2 and 3: space and index */
+    uint64_t Ctr;         /* next block (counter words 0 and 1) */
+    uint32_t Buf[4];      /* current block */
+    int Left;             /* words of Buf not yet used */
+};
+TLS struct RStream Rng;           /* the estimation's stream */
+TLS long SeedSave;                /* the run seed, also the run's ID */
+TLS int SeedSet = 0;              /* SeedSave came from -seed */
+
+/* a self-contained set of the vectors used by the M iteration, so that */
+/* simulated samples can be processed side by side; the member names */
+/* match the globals, so functions that copy them into locals can use */
+/* the usual access macros unchanged */
+struct SimSpace {
+    int XCnt;              /* sample size */
+    double *X;             /* the sample, ROW MAJOR like X */
+    double *XBarJ;         /* iterated mean */
+    double *C;             /* covariance and its inverse, like C */
+    double *SqResiduals;   /* squared distances */
+    double *kSqSpace;      /* for sorting in Space_Compute_k */
+    struct ResidRec *kRecs;    /*   and with Freq (only for the data) */
+    double *dTilde;
+    double *wVector, *OldwVector;
+    double Sumw, Sumv;
+    double Determinant;
+    struct RStream Rng;    /* this sample's random number stream */
+    int Ghost;             /* points taken to lie beyond all distances */
+                           /* (they count only in the rank used for k) */
+    int *Freq;             /* row weights (only for the data: see Freq) */
+};
+
+/* minimization variables */
+TLS double ObjectiveValue;		  /* to be minimized */
+TLS double BestObjectiveValue;	  /* to keep score */
+
+/* enhanced algorithm declarations */
+#   define HALFWAY (VectLen + 1) / 2 + XCnt / 4  /*between p+1 and 1/2 samp*/
+
+/* forward declarations */
+double Compute_k();
+void Set_c_and_b0();
+double rho(double d);
+void Standardize_X();
+void Use_Algo_Rej_Code(struct SimSpace *S);
+void Pre_Check_Data();
+int Compare_Resids(const void *arg1, const void *arg2);
+
+TLS int i_i;  /* to be used by copy macro */
+#define Copy(x,y,z) for (i_i=0; i_i<(z); i_i++) x[i_i] = y[i_i]
+
+/* out-of-core (-stream) mode: the data stay in the mapped binary matrix */
+/* file, which the kernel pages in and drops as it likes; X holds just */
+/* one partition cell. Passes over all of the rows are split into */
+/* STREAM_PARTS fixed ranges whose sums are added in order, so the */
+/* results do not depend on the thread count */
+#define STREAM_PARTS 256
+#define STREAM_ROWS 4096        /* distances listed at a time */
+#define STREAM_CELLS 10         /* default number of cells searched */
+struct Stream {
+  char *Buf; size_t Len;        /* the mapped file */
+  char *v;                      /* its first value */
+  int Dtype;                    /* MAT_F64 or MAT_F32 (rows in order) */
+  long n;                       /* rows (XCnt is the cell size) */
+  int Half;                     /* bits in each half of a row index */
+  long Parts, Cells;            /* partition cells, and those searched */
+  double Sumw, Sumv;            /* Stream_Moments results: */
+  double MaxWDelta;
+  long Cnt;                     /*   rows with non-zero weight */
+  double *Sx, *Sxx;             /*   weighted sums about the mean */
+};
+TLS struct Stream Strm;
+#define AllRows (StreamMode ? Strm.n : (long)XCnt)
+#define AllPoints (Freq ? NPoints : AllRows)    /* counting duplicates */
+
+TLS int MappedHeap = 0;  /* Map_File had to read the file into the heap */
+TLS char *KeptMap = NULL;  /* a mapping kept as the data (X or Strm) */
+TLS size_t KeptLen;
+TLS FILE *OpenReport = NULL;  /* the report, while it is open */
+TLS int CutRunning = 0;    /* the cutoff thread (see First_Stage) */
+TLS pthread_t CutThread;
+TLS int Finished = 0;      /* the run got to the end */
+TLS char *Room = NULL;     /* the block Make_Room cut up, */
+TLS int RoomXCnt, RoomP;   /*   and for what XCnt and VectLen */
+
+/* the analysis state: the options (and Make_Room's block) last as long */
+/* as the context, the rest is cleared for each run (see Begin_Run); */
+/* every parallel region starts its threads with the master's copy: */
+/* copyin(MO_STATE) */
+#define MO_OPTIONS(V) V(CacheDir) V(UseCutTable) V(Threads) V(PoolTails) \
+  V(CutPrec) V(VarRed) V(CutMode) V(VerifyData) V(EchoFile) V(Sections) \
+  V(ReportOut) V(StreamMode) V(StreamCells) V(ResultsFile) V(ModelFile) \
+  V(Collapse) \
+  V(ColSpec) V(SeedSave) V(SeedSet) V(ParmsSet) V(SetLambda) V(SetTrace) \
+  V(SetCut) V(SetSimTol) V(Room) V(RoomXCnt) V(RoomP)
+#define MO_RUN(V) V(Lambda) V(Cut1) V(Cut2) V(SimTol) V(Trace) \
+  V(ItersAllowed) V(CutHalf) V(ApproxCut) V(CutBlocks) V(CutoffSource) \
+  V(FirstCut) V(FinalCut) V(Secs) V(VectLen) V(XCnt) V(X) V(InstanceID) \
+  V(FileCols) V(ColAt) V(ColOf) V(Freq) V(RowOf) V(NPoints) V(JBits) \
+  V(BestJBits) V(OnesList) V(ZerosList) V(XBarJ) V(XJ) V(XJFreq) V(JWt) \
+  V(ZJ) V(C) V(A) V(Determinant) V(SingularCnt) V(SqResiduals) \
+  V(kSqSpace) V(dTilde) V(wVector) V(OldwVector) V(Sumw) V(Sumv) V(mJ2) \
+  V(c1) V(b0) V(M) V(ActualBP) V(uAu) V(MBar) V(MC) V(ResidRecs) V(kRecs) \
+  V(Rng) \
+  V(ObjectiveValue) V(BestObjectiveValue) V(i_i) V(Strm) V(MappedHeap) \
+  V(KeptMap) V(KeptLen) V(OpenReport) V(CutRunning) V(CutThread) \
+  V(Finished) V(FitC) V(MFit)
+#define MO_COMMA(v) v,
+#define MO_STATE MO_OPTIONS(MO_COMMA) MO_RUN(MO_COMMA) CallHeap, CallLog, CallLevel, \
+  RegionErr
+
+/*---------------------------------------------------------------------------*/
+void Philox_Blocks(uint32_t *Out, int Blocks, const struct RStream *R)
+/* Out[4b..4b+3] = Philox4x32-10 of counter (R->Ctr + b, R->Id) */
+/* under key R->Key; the blocks are independent, so this loop vectorizes */
+{
+  int b, r;
+  uint64_t n, p0, p1;
+  uint32_t x0, x1, x2, x3, k0, k1;
+
+  for (b=0; b<Blocks; b++) {
+    n = R->Ctr + (uint64_t)b;
+    x0 = (uint32_t)n; x1 = (uint32_t)(n >> 32);
+    x2 = R->Id[0]; x3 = R->Id[1];
+    k0 = R->Key[0]; k1 = R->Key[1];
+    for (r=0; r<10; r++) {
+      p0 = (uint64_t)PHILOX_M0 * x0;
+      p1 = (uint64_t)PHILOX_M1 * x2;
+      x0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0; x1 = (uint32_t)p1;
+      x2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1; x3 = (uint32_t)p0;
+      k0 += PHILOX_W0; k1 += PHILOX_W1;
+    }
+    Out[4*b] = x0; Out[4*b+1] = x1; Out[4*b+2] = x2; Out[4*b+3] = x3;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+void RS_Init(struct RStream *R, long Seed, uint32_t Space, uint32_t Index)
+/* start stream (Seed, Space, Index) at its first word */
+{
+  R->Key[0] = (uint32_t)Seed; R->Key[1] = (uint32_t)((uint64_t)Seed >> 32);
+  R->Id[0] = Index; R->Id[1] = Space;
+  R->Ctr = 0;
+  R->Left = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+void RS_Words(struct RStream *R, uint32_t *w, int cnt)
+/* the next cnt words of R; whole blocks go straight into w */
+{
+  int i = 0, Blocks;
+
+  while (i < cnt && R->Left) w[i++] = R->Buf[4 - R->Left--];
+  Blocks = (cnt - i) / 4;
+  if (Blocks) {
+    Philox_Blocks(w + i, Blocks, R);
+    R->Ctr += (uint64_t)Blocks;
+    i += 4 * Blocks;
+  }
+  if (i < cnt) {
+    Philox_Blocks(R->Buf, 1, R);
+    R->Ctr++;
+    R->Left = 4;
+    while (i < cnt) w[i++] = R->Buf[4 - R->Left--];
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+double URan(struct RStream *R)
+/*return a uniform 0,1 rv from stream R*/
+{
+   uint32_t w;
+
+   RS_Words(R, &w, 1);
+   return(((double)w + 0.5) / 4294967296.);
+}
+
+/*--------------------------------------------------------------------------*/
+double Norm(double mu, double sd, struct RStream *z)
+/* return a normal deviate with mean mu and std dev sd,
+   use stream z */
+/* just waste a deviate... */
+
+{
+double v1,v2,r;
+
+   do {
+     v1 = 2.0 * URan(z) - 1.;
+     v2 = 2.0 * URan(z) - 1.;
+     r = v1*v1 + v2*v2;
+   } while (r >= 1.0);
+   return(mu + sd * (v1 * sqrt(-2.0 * log(r)/r)));
+}
+
+/*--------------------------------------------------------------------------*/
+/* batch normal deviates by the ziggurat method (Marsaglia and Tsang 2000, */
+/* in Doornik's 2005 form: 128 layers, driven by (0,1) uniforms) */
+/* Zig_Init must be called once before Norm_Fill */
+#define ZIG_C 128                   /* layers */
+#define ZIG_R 3.442619855899        /* where the tail starts */
+#define ZIG_V 9.91256303526217e-3   /* area of each layer */
+#define ZIG_BATCH 256               /* deviates per fast path pass */
+double ZigX[ZIG_C+1];               /* layer edges; ZigX[0] is V/f(R) */
+double ZigR[ZIG_C];                 /* ZigX[i+1]/ZigX[i], the box part */
+
+void Zig_Init()
+{
+  int i;
+  double f = exp(-0.5 * ZIG_R * ZIG_R);
+
+  ZigX[0] = ZIG_V / f;
+  ZigX[1] = ZIG_R;
+  ZigX[ZIG_C] = 0.;
+  for (i=2; i<ZIG_C; i++) {
+    ZigX[i] = sqrt(-2. * log(ZIG_V / ZigX[i-1] + f));
+    f = exp(-0.5 * ZigX[i] * ZigX[i]);
+  }
+  for (i=0; i<ZIG_C; i++) ZigR[i] = ZigX[i+1] / ZigX[i];
+}
+
+/*--------------------------------------------------------------------------*/
+double Zig_Slow(int i, double u, struct RStream *z)
+/* finish a deviate that missed the box of layer i at position u */
+{
+  double x, y, f0, f1;
+
+  for (;;) {
+    if (fabs(u) < ZigR[i]) return u * ZigX[i];
+    if (i == 0) {                   /* the tail beyond ZIG_R */
+      do {
+        x = log(URan(z)) / ZIG_R;
+        y = log(URan(z));
+      } while (-2. * y < x * x);
+      return u < 0. ? x - ZIG_R : ZIG_R - x;
+    }
+    x = u * ZigX[i];                /* the wedge */
+    f0 = exp(-0.5 * (ZigX[i] * ZigX[i] - x * x));
+    f1 = exp(-0.5 * (ZigX[i+1] * ZigX[i+1] - x * x));
+    if (f1 + URan(z) * (f0 - f1) < 1.) return x;
+    u = 2. * URan(z) - 1.;
+    i = (int)(URan(z) * ZIG_C);
+  }
+}
+
+/*--------------------------------------------------------------------------*/
+void Norm_Fill(double *x, int cnt, struct RStream *z)
+/* fill x[0..cnt-1] with standard normal deviates from stream z */
+/* one word per deviate: the low 7 bits pick the layer and the other 25 */
+/* the position; the words come in a batch, then the box test is a */
+/* branch free loop the compiler can vectorize; only the ~1% of misses */
+/* go through Zig_Slow */
+{
+  uint32_t w[ZIG_BATCH];
+  double u[ZIG_BATCH];
+  int k[ZIG_BATCH], Miss[ZIG_BATCH];
+  int i, m, Base;
+
+  for (Base = 0; Base < cnt; Base += m) {
+    m = cnt - Base < ZIG_BATCH ? cnt - Base : ZIG_BATCH;
+    RS_Words(z, w, m);
+    for (i=0; i<m; i++) {
+      u[i] = ((double)(w[i] >> 7) + 0.5) / 16777216. - 1.;
+      k[i] = (int)(w[i] & (ZIG_C - 1));
+    }
+    for (i=0; i<m; i++) {
+      x[Base+i] = u[i] * ZigX[k[i]];
+      Miss[i] = fabs(u[i]) >= ZigR[k[i]];
+    }
+    for (i=0; i<m; i++)
+      if (Miss[i]) x[Base+i] = Zig_Slow(k[i], u[i], z);
+  }
+}
+
+/*-------------------------------------------------------------------------*/
+/* fast text input: the file is mapped (or read whole, if it cannot be) */
+/* and parsed in place; strtod is used only when the fast path cannot */
+/* give the correctly rounded value */
+#define IsSpace(c) ((c) == ' ' || (c) == '\n' || (c) == '\t' || (c) == '\r')
+#define IsDigit(c) ((c) >= '0' && (c) <= '9')
+double Pow10[23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+  1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/*-------------------------------------------------------------------------*/
+char *Map_File(char *Name, size_t *Len)
+/* the contents of file Name (not NUL terminated); NULL if unreadable */
+/* the pages are private and writable, so they can serve as X itself */
+{
+  int fd;
+  struct stat st;
+  char *Buf;
+  size_t Got;
+  ssize_t r;
+
+  if ((fd = open(Name, O_RDONLY)) < 0) return NULL;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    *Len = (size_t)st.st_size;
+    if (*Len == 0) {close(fd); return "";}
+    Buf = mmap(NULL, *Len, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (Buf != MAP_FAILED) {
+#     ifdef MADV_SEQUENTIAL
+        madvise(Buf, *Len, MADV_SEQUENTIAL);
+#     endif
+      close(fd);
+      return Buf;
+    }
+  }
+  /* not a regular file (or no mmap): read it all */
+  *Len = 1 << 20; Got = 0;
+  Buf = malloc(*Len); ALLCHK(Buf)
+  while ((r = read(fd, Buf + Got, *Len - Got)) > 0)
+    if ((Got += (size_t)r) == *Len) {
+      *Len *= 2;
+      Buf = realloc(Buf, *Len); ALLCHK(Buf)
+    }
+  close(fd);
+  *Len = Got;
+  MappedHeap = True;
+  return Buf;
+}
+
+/*-------------------------------------------------------------------------*/
+void Unmap_File(char *Buf, size_t Len)
+{
+  if (MappedHeap) {free(Buf); MappedHeap = False;}
+  else if (Len) munmap(Buf, Len);
+}
+
+/*-------------------------------------------------------------------------*/
+/* compressed input: gzip and zstd files are recognized by their magic */
+/* bytes and inflated, a block at a time, into the heap (zlib and zstd */
+/* are used if the Makefile found them: HAVE_ZLIB, HAVE_ZSTD) */
+#define GZ_FILE 1
+#define ZSTD_FILE 2
+#define ZCHUNK (1 << 24)        /* most bytes per inflate call */
+
+/*-------------------------------------------------------------------------*/
+int Compressed(char *Buf, size_t Len)
+/* GZ_FILE, ZSTD_FILE or 0, from the first bytes of Buf */
+{
+  unsigned char *b = (unsigned char *)Buf;
+
+  if (Len >= 2 && b[0] == 0x1F && b[1] == 0x8B) return GZ_FILE;
+  if (Len >= 4 && b[0] == 0x28 && b[1] == 0xB5 && b[2] == 0x2F && b[3] == 0xFD)
+    return ZSTD_FILE;
+  return 0;
+}
+
+/*-------------------------------------------------------------------------*/
+void Bad_Compressed(char *Name, char *Kind, const char *Why)
+{
+  printf("\n*error* %s: %s %s\n\n", Name, Kind, Why);
+  exit(1);
+}
+
+/*-------------------------------------------------------------------------*/
+char *Inflate_File(char *Name, char *Buf, size_t *Len)
+/* if Buf (from Map_File) is compressed, release it and return its */
+/* contents in the heap (*Len updated); else return Buf as it is */
+{
+  int Kind = Compressed(Buf, *Len);
+  char *Out;
+  size_t Cap, Got = 0;
+
+  if (!Kind) return Buf;
+  Cap = 4 * *Len + ZCHUNK;
+  Out = malloc(Cap); ALLCHK(Out)
+  if (Kind == GZ_FILE) {
+#   ifdef HAVE_ZLIB
+      z_stream z;
+      size_t In = 0;               /* bytes of Buf given to inflate */
+      int r;
+
+      memset(&z, 0, sizeof(z));
+      if (inflateInit2(&z, 15 + 16) != Z_OK) Bad_Compressed(Name, "gzip", "setup failed");
+      for (;;) {
+        if (z.avail_in == 0 && In < *Len) {
+          z.next_in = (Bytef *)Buf + In;
+          z.avail_in = (uInt)(*Len - In < ZCHUNK ? *Len - In : ZCHUNK);
+          In += z.avail_in;
+        }
+        if (Got == Cap) {
+          Cap *= 2;
+          Out = realloc(Out, Cap); ALLCHK(Out)
+        }
+        z.next_out = (Bytef *)Out + Got;
+        z.avail_out = (uInt)(Cap - Got < ZCHUNK ? Cap - Got : ZCHUNK);
+        Got += z.avail_out;
+        r = inflate(&z, Z_NO_FLUSH);
+        Got -= z.avail_out;
+        if (r == Z_STREAM_END) {
+          if (z.avail_in == 0 && In == *Len) break;
+          inflateReset(&z);         /* another member follows */
+        } else if (r == Z_BUF_ERROR) {
+          if (z.avail_in == 0 && In == *Len) Bad_Compressed(Name, "gzip", "data is truncated");
+        } else if (r != Z_OK) Bad_Compressed(Name, "gzip", "data is corrupt");
+      }
+      inflateEnd(&z);
+#   else
+      Bad_Compressed(Name, "gzip", "input needs multout built with zlib");
+#   endif
+  } else {
+#   ifdef HAVE_ZSTD
+      ZSTD_DStream *z;
+      ZSTD_inBuffer in;
+      ZSTD_outBuffer out;
+      size_t r, Was;
+
+      if ((z = ZSTD_createDStream()) == NULL) Bad_Compressed(Name, "zstd", "setup failed");
+      ZSTD_initDStream(z);
+      in.src = Buf; in.size = *Len; in.pos = 0;
+      for (;;) {
+        if (Got == Cap) {
+          Cap *= 2;
+          Out = realloc(Out, Cap); ALLCHK(Out)
+        }
+        out.dst = Out; out.size = Cap; out.pos = Got;
+        Was = in.pos;
+        r = ZSTD_decompressStream(z, &out, &in);
+        if (ZSTD_isError(r)) Bad_Compressed(Name, "zstd", ZSTD_getErrorName(r));
+        if (r == 0 && in.pos == in.size) {Got = out.pos; break;}
+        if (out.pos == Got && in.pos == Was) Bad_Compressed(Name, "zstd", "data is truncated");
+        Got = out.pos;
+      }
+      ZSTD_freeDStream(z);
+#   else
+      Bad_Compressed(Name, "zstd", "input needs multout built with zstd");
+#   endif
+  }
+  Unmap_File(Buf, *Len);
+  *Len = Got;
+  MappedHeap = True;
+  return Out;
+}
+#undef ZCHUNK
+
+/*-------------------------------------------------------------------------*/
+char *Parse_Double(char *p, char *End, double *v)
+/* parse one number at p (no leading white space); return the character */
+/* after it, or NULL if the token is not a number */
+/* up to 19 significant digits and |exponent| <= 22 the value is exact */
+/* (Clinger's fast path); anything else goes to strtod */
+{
+  char *Start = p, *q;
+  char Tok[64];
+  uint64_t m = 0;
+  int Digits = 0, Any = 0, Dropped = 0, Neg = 0, Exp = 0, e, ENeg;
+  double d;
+
+  if (p < End && (*p == '-' || *p == '+')) Neg = *p++ == '-';
+  for (; p < End && IsDigit(*p); p++, Any = 1) {
+    if (Digits < 19) {
+      m = m * 10 + (uint64_t)(*p - '0');
+      if (m) Digits++;
+    } else {Exp++; Dropped |= *p != '0';}
+  }
+  if (p < End && *p == '.')
+    for (p++; p < End && IsDigit(*p); p++, Any = 1) {
+      if (Digits < 19) {
+        m = m * 10 + (uint64_t)(*p - '0');
+        if (m) Digits++;
+        Exp--;
+      } else Dropped |= *p != '0';
+    }
+  if (Any && p < End && (*p == 'e' || *p == 'E')) {
+    q = p + 1; ENeg = 0; e = 0;
+    if (q < End && (*q == '-' || *q == '+')) ENeg = *q++ == '-';
+    if (q < End && IsDigit(*q)) {
+      for (; q < End && IsDigit(*q); q++) if (e < 10000) e = e*10 + *q - '0';
+      Exp += ENeg ? -e : e;
+      p = q;
+    }
+  }
+  if (Any && (p == End || IsSpace(*p)) && !Dropped
+      && m <= ((uint64_t)1 << 53) && Exp >= -22 && Exp <= 22) {
+    d = (double)m;
+    d = Exp < 0 ? d / Pow10[-Exp] : d * Pow10[Exp];
+    *v = Neg ? -d : d;
+    return p;
+  }
+  /* the slow path: long mantissas and big exponents; strtod would also */
+  /* take hex, inf and nan, which are not data, and overflow to inf */
+  for (p = Start; p < End && !IsSpace(*p); p++)
+    if (!IsDigit(*p) && !strchr("+-.eE", *p)) return NULL;
+  if (p - Start >= (long)sizeof(Tok)) return NULL;
+  memcpy(Tok, Start, p - Start); Tok[p - Start] = 0;
+  *v = strtod(Tok, &q);
+  return q == Tok + (p - Start) && isfinite(*v) ? p : NULL;
+}
+
+/*-------------------------------------------------------------------------*/
+char *Parse_Int(char *p, char *End, int *v)
+/* like Parse_Double, for a non-negative int */
+{
+  long n = 0;
+  char *Start = p;
+
+  for (; p < End && IsDigit(*p); p++) if ((n = n*10 + *p - '0') > INT_MAX) return NULL;
+  if (p == Start || (p < End && !IsSpace(*p))) return NULL;
+  *v = (int)n;
+  return p;
+}
+
+/*-------------------------------------------------------------------------*/
+long Line_Of(char *Buf, char *p)
+/* line number of position p (for error messages only) */
+{
+  long Line = 1;
+
+  for (; Buf < p; Buf++) if (*Buf == '\n') Line++;
+  return Line;
+}
+
+/*-------------------------------------------------------------------------*/
+void Bad_Value(char *DATAFILE, char *Buf, char *End, char *p, long spot)
+/* report the value at p (value number spot) and exit */
+{
+  char *q;
+
+  for (q = p; q < End && q - p < 40 && !IsSpace(*q); q++);
+  printf("\n*error* %s line %ld: bad value \"%.*s\" for row %ld, column %ld\n\n",
+         DATAFILE, Line_Of(Buf, p), (int)(q - p), p,
+         spot / FileCols + 1, spot % FileCols + 1);
+  exit(1);
+}
+
+/*-------------------------------------------------------------------------*/
+void Select_Cols(int p)
+/* the file has p columns: set FileCols and VectLen, and with -cols the */
+/* ColAt and ColOf maps (ColSpec is a list like 1,4,7-9; the columns */
+/* are kept in file order) */
+{
+  char *q = ColSpec, *e;
+  long a, b, j;
+
+  FileCols = VectLen = p;
+  if (!ColSpec) return;
+  ColAt = malloc(p*sizeof(int)); ALLCHK(ColAt)
+  for (j=0; j<p; j++) ColAt[j] = -1;
+  do {
+    a = b = strtol(q, &e, 10);
+    if (e != q && *e == '-') b = strtol(q = e+1, &e, 10);
+    if (e == q || (*e && *e != ',') || a < 1 || b < a || b > p) {
+      printf("\n*error* -cols %s: columns must be in 1..%d, as in 1,4,7-9\n\n",
+             ColSpec, p);
+      exit(1);
+    }
+    for (j=a; j<=b; j++) ColAt[j-1] = 0;
+    q = e + 1;
+  } while (*e);
+  ColOf = malloc(p*sizeof(int)); ALLCHK(ColOf)
+  for (VectLen=j=0; j<p; j++)
+    if (!ColAt[j]) {ColOf[VectLen] = (int)j+1; ColAt[j] = VectLen++;}
+}
+
+/*-------------------------------------------------------------------------*/
+void Put_Cols(FILE *f)
+/* the -cols map, for the report */
+{
+  int j;
+
+  if (!ColOf) return;
+  fprintf(f,"Columns used (of %d in the file):", FileCols);
+  for (j=0; j<VectLen; j++) fprintf(f," %d", ColOf[j]);
+  fprintf(f,"\n");
+}
+
+/*-------------------------------------------------------------------------*/
+long Count_Values(char *p, char *End)
+/* the number of white space separated tokens in [p, End) */
+{
+  long n = 0;
+  int Prev = 1, Sp;      /* previous and this character are white space */
+
+  for (; p < End; p++) {
+    Sp = IsSpace(*p);
+    n += Prev & !Sp;
+    Prev = Sp;
+  }
+  return n;
+}
+
+/*-------------------------------------------------------------------------*/
+#define CHUNK_MIN (1 << 20)     /* smallest piece worth its own thread */
+void Parse_Values(char *DATAFILE, char *Buf, char *p, char *End, long Cnt)
+/* parse the Cnt values in [p, End) into X */
+/* the text is cut at newlines into chunks; the values in each chunk are */
+/* counted (in parallel), which gives each chunk's first index in X, and */
+/* then the chunks are parsed (in parallel) straight into place; with */
+/* -cols the values of unused columns are stepped over, not converted */
+{
+  int Chunks, c;
+  char **Cut;            /* chunk c is [Cut[c], Cut[c+1]) */
+  long *First;           /* index in X of chunk c's first value */
+  long *BadAt;           /* index of chunk c's first bad value, or -1 */
+  char **BadPos;         /* and where it is */
+  long spot;
+  char *q;
+
+  Chunks = (int)((End - p) / CHUNK_MIN);
+#ifdef _OPENMP
+  if (Chunks > 4 * omp_get_max_threads()) Chunks = 4 * omp_get_max_threads();
+#else
+  Chunks = 1;
+#endif
+  if (Chunks < 1) Chunks = 1;
+  Cut = malloc((Chunks+1) * sizeof(char *)); ALLCHK(Cut)
+  BadPos = malloc(Chunks * sizeof(char *)); ALLCHK(BadPos)
+  First = malloc((Chunks+1) * sizeof(long)); ALLCHK(First)
+  BadAt = malloc(Chunks * sizeof(long)); ALLCHK(BadAt)
+  Cut[0] = p; Cut[Chunks] = End;
+  for (c=1; c<Chunks; c++) {
+    q = p + (End - p) / Chunks * c;
+    if (q < Cut[c-1]) q = Cut[c-1];
+    q = memchr(q, '\n', End - q);
+    Cut[c] = q ? q + 1 : End;
+  }
+
+  First[0] = 0;
+# pragma omp parallel for schedule(dynamic) copyin(MO_STATE)
+  for (c=0; c<Chunks; c++) First[c+1] = Count_Values(Cut[c], Cut[c+1]);
+  for (c=0; c<Chunks; c++) First[c+1] += First[c];
+  if (First[Chunks] < Cnt) {
+    printf("\n*error* %s ends after %ld of its %ld values", DATAFILE,
+           First[Chunks], Cnt);
+    printf(" (row %ld, column %ld is missing)\n\n",
+           First[Chunks] / FileCols + 1, First[Chunks] % FileCols + 1);
+    exit(1);
+  }
+  if (First[Chunks] > Cnt) {          /* find value Cnt, the first extra */
+    for (c=0; First[c+1] <= Cnt; c++);
+    for (spot = First[c], q = Cut[c]; ; spot++) {
+      for (; IsSpace(*q); q++);
+      if (spot == Cnt) break;
+      for (; !IsSpace(*q); q++);
+    }
+    printf("\n*error* %s line %ld: more than the %d rows of %d values in the header\n\n",
+           DATAFILE, Line_Of(Buf, q), XCnt, FileCols);
+    exit(1);
+  }
+
+# pragma omp parallel for schedule(dynamic) private(spot, q) copyin(MO_STATE)
+  for (c=0; c<Chunks; c++) {
+    long Row = First[c] / FileCols;     /* of value spot (with -cols) */
+    int Col = (int)(First[c] % FileCols);
+
+    BadAt[c] = -1;
+    for (spot = First[c], q = Cut[c]; ; spot++) {
+      for (; q < Cut[c+1] && IsSpace(*q); q++);
+      if (q == Cut[c+1]) break;
+      if (!ColAt) BadPos[c] = Parse_Double(q, Cut[c+1], X+spot);
+      else if (ColAt[Col] < 0) {
+        for (BadPos[c] = q; BadPos[c] < Cut[c+1] && !IsSpace(*BadPos[c]); BadPos[c]++);
+      } else BadPos[c] = Parse_Double(q, Cut[c+1], X + Row*VectLen + ColAt[Col]);
+      if (ColAt && ++Col == FileCols) {Col = 0; Row++;}
+      if (BadPos[c] == NULL) {
+        BadAt[c] = spot; BadPos[c] = q;
+        break;
+      }
+      q = BadPos[c];
+    }
+  }
+  for (c=0; c<Chunks; c++)
+    if (BadAt[c] >= 0) Bad_Value(DATAFILE, Buf, End, BadPos[c], BadAt[c]);
+  free(Cut); free(BadPos); free(First); free(BadAt);
+}
+#undef CHUNK_MIN
+
+/*-------------------------------------------------------------------------*/
+/* binary matrix files: a 64 byte header, then the values in native */
+/* byte order (the header says which way round and how they are laid out) */
+/* mulcross -b writes them; Load_Data reads either kind of file */
+#define MAT_MAGIC "MOUTMAT1"
+#define MAT_ORDER 0x01020304U   /* reads differently on the other byte order */
+#define MAT_F64 1               /* Dtype: double */
+#define MAT_F32 2               /*        float */
+#define MAT_ROWS 0              /* Layout: row major (like X) */
+#define MAT_COLS 1              /*         column major */
+struct MatHeader {
+  char Magic[8];                /* MAT_MAGIC (no NUL) */
+  uint32_t Order;               /* MAT_ORDER */
+  uint32_t Dtype, Layout;
+  uint32_t p;                   /* columns */
+  uint64_t n;                   /* rows */
+  uint64_t Offset;              /* of the first value (64) */
+  uint64_t Checksum;            /* Mat_Checksum of the values */
+  char Pad[16];                 /* zero */
+};
+
+/*-------------------------------------------------------------------------*/
+uint64_t Mat_Checksum(char *v, size_t Len)
+/* FNV-1a, 64 bits, taken over 8 byte words (then a 4 byte tail) */
+{
+  uint64_t h = 0xCBF29CE484222325ULL, w;
+  uint32_t t;
+  size_t i;
+
+  for (i=0; i+8<=Len; i+=8) {
+    memcpy(&w, v+i, 8);
+    h = (h ^ w) * 0x100000001B3ULL;
+  }
+  if (i+4 <= Len) {
+    memcpy(&t, v+i, 4);
+    h = (h ^ t) * 0x100000001B3ULL;
+  }
+  return h;
+}
+
+/*-------------------------------------------------------------------------*/
+void Write_Matrix(char *Name, double *V, int p, int n)
+/* write the n by p row major V as a binary matrix file */
+{
+  struct MatHeader H;
+  FILE *f;
+  size_t Bytes = (size_t)p * n * sizeof(double);
+
+  memset(&H, 0, sizeof(H));
+  memcpy(H.Magic, MAT_MAGIC, 8);
+  H.Order = MAT_ORDER;
+  H.Dtype = MAT_F64; H.Layout = MAT_ROWS;
+  H.p = (uint32_t)p; H.n = (uint64_t)n;
+  H.Offset = sizeof(H);
+  H.Checksum = Mat_Checksum((char *)V, Bytes);
+  if ((f = fopen(Name, "wb")) == NULL
+      || fwrite(&H, sizeof(H), 1, f) != 1
+      || fwrite(V, 1, Bytes, f) != Bytes || fclose(f)) {
+    printf("Could not write %s\n", Name);
+    exit(1);
+  }
+}
+
+/*-------------------------------------------------------------------------*/
+int Mat_Header(char *DATAFILE, char *Buf, size_t Len, struct MatHeader *H)
+/* if Buf holds a binary matrix file, check its header (and, with */
+/* -verify, its checksum), copy the header into H and return True */
+{
+  size_t Size;
+
+  if (Len < sizeof(*H) || memcmp(Buf, MAT_MAGIC, 8)) return False;
+  memcpy(H, Buf, sizeof(*H));
+  if (H->Order != MAT_ORDER) {
+    printf("\n*error* %s was written with the other byte order\n\n", DATAFILE);
+    exit(1);
+  }
+  if ((H->Dtype != MAT_F64 && H->Dtype != MAT_F32)
+      || (H->Layout != MAT_ROWS && H->Layout != MAT_COLS) || H->p < 1
+      || H->p > INT_MAX || (H->n > INT_MAX && !StreamMode)
+      || H->Offset < sizeof(*H) || H->Offset % 8) {
+    printf("\n*error* %s has a bad binary matrix header\n\n", DATAFILE);
+    exit(1);
+  }
+  Size = (H->Dtype == MAT_F64 ? sizeof(double) : sizeof(float)) * H->p * H->n;
+  if (H->Offset + Size != Len) {
+    printf("\n*error* %s has %lu bytes but its header calls for %lu\n\n",
+           DATAFILE, (unsigned long)Len, (unsigned long)(H->Offset + Size));
+    exit(1);
+  }
+  if (VerifyData && Mat_Checksum(Buf + H->Offset, Size) != H->Checksum) {
+    printf("\n*error* %s fails its checksum\n\n", DATAFILE);
+    exit(1);
+  }
+  return True;
+}
+
+/*-------------------------------------------------------------------------*/
+int Load_Binary(char *DATAFILE, char *Buf, size_t Len)
+/* if Buf holds a binary matrix file, set up X, VectLen and XCnt from it */
+/* and return True; doubles in row major order are used where they lie */
+/* (X points into the private mapping, which is then kept), anything */
+/* else is converted into the heap and Buf is released */
+{
+  struct MatHeader H;
+  size_t Cnt, i;
+  char *v;
+
+  if (!Mat_Header(DATAFILE, Buf, Len, &H)) return False;
+  Select_Cols((int)H.p); XCnt = (int)H.n;
+  Cnt = (size_t)H.p * H.n;
+  v = Buf + H.Offset;
+  if (H.Dtype == MAT_F64 && H.Layout == MAT_ROWS && !ColOf) {
+    X = (double *)v;                /* no copy */
+    if (!MappedHeap) {KeptMap = Buf; KeptLen = Len;}
+    return True;
+  }
+  X = malloc((size_t)VectLen * H.n * sizeof(double)); ALLCHK(X)
+  if (ColOf) {                      /* just the columns used */
+    for (i=0; i<(size_t)VectLen * H.n; i++) {   /* i indexes X */
+      size_t r = i / VectLen, c = ColOf[i % VectLen] - 1;
+      size_t At = H.Layout == MAT_ROWS ? r * H.p + c : c * H.n + r;
+      X[i] = H.Dtype == MAT_F64 ? ((double *)v)[At] : ((float *)v)[At];
+    }
+  } else for (i=0; i<Cnt; i++)      /* i indexes the file */
+    X[H.Layout == MAT_ROWS ? i : (i % H.n) * H.p + i / H.n]
+      = H.Dtype == MAT_F64 ? ((double *)v)[i] : ((float *)v)[i];
+  Unmap_File(Buf, Len);
+  return True;
+}
+
+/*-------------------------------------------------------------------------*/
+void Stream_Open(char *DATAFILE, char *Buf, size_t Len)
+/* keep the (binary, row major) file mapped as the data; VectLen is set */
+/* but XCnt waits for Stream_Cells */
+{
+  struct MatHeader H;
+
+  if (!Mat_Header(DATAFILE, Buf, Len, &H)) {
+    printf("\n*error* -stream needs a binary matrix file (see mulcross -b)\n\n");
+    exit(1);
+  }
+  if (H.Layout != MAT_ROWS) {
+    printf("\n*error* -stream needs a row major binary matrix; %s is column major\n\n",
+           DATAFILE);
+    exit(1);
+  }
+  Strm.Buf = Buf; Strm.Len = Len;
+  if (!MappedHeap) {KeptMap = Buf; KeptLen = Len;}
+  Strm.v = Buf + H.Offset;
+  Strm.Dtype = (int)H.Dtype;
+  Strm.n = (long)H.n;
+  Select_Cols((int)H.p); XCnt = 0;
+  for (Strm.Half = 1; Strm.n > 1L << 2*Strm.Half; Strm.Half++);
+  Strm.Sx = malloc(VectLen*sizeof(double)); ALLCHK(Strm.Sx)
+  Strm.Sxx = malloc(VectLen*VectLen*sizeof(double)); ALLCHK(Strm.Sxx)
+}
+
+/*-------------------------------------------------------------------------*/
+void Data_Ready(char *DATAFILE)
+/* the steps after X (or Strm), VectLen, XCnt and SeedSave are set */
+{
+    RS_Init(&Rng, SeedSave, RS_MAIN, 0);
+
+    Set_c_and_b0();
+    if (!StreamMode) Pre_Check_Data();
+    if (!StreamMode && XCnt <= VectLen) {   /* -collapse can leave too few */
+      printf("\n*error* only %d distinct points in %s; more than %d are needed\n\n",
+             XCnt, DATAFILE, VectLen);
+      exit(1);
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void Read_Data(char *DATAFILE)
+/* make and load the Data matrix */
+/* the input file is assumed to be line records with the first two */
+/* values the integer vector length and the number of observations */
+/* X array is ROW MAJOR!!! */
+/* the value count must match the header exactly */
+/* binary matrix files (see Load_Binary) are recognized by their magic */
+/* gzip and zstd files are inflated first (see Inflate_File) */
+/* in stream mode the file must be binary and is only mapped */
+{
+    char *Buf, *End, *p;          /* the file contents and position */
+    size_t Len;
+    long Cnt;			  /* number of values */
+
+    if ((Buf = Map_File(DATAFILE, &Len)) == NULL) {
+	printf("\nCould not open %s for read\n\n",DATAFILE);
+	Info_Exit();
+    }
+    if (StreamMode && Compressed(Buf, Len)) {
+      printf("\n*error* -stream needs %s uncompressed\n\n", DATAFILE);
+      exit(1);
+    }
+    if (StreamMode && Collapse) {
+      printf("\n*error* -collapse cannot be used with -stream\n\n");
+      exit(1);
+    }
+    Buf = Inflate_File(DATAFILE, Buf, &Len);
+    if (StreamMode) Stream_Open(DATAFILE, Buf, Len);
+    else if (!Load_Binary(DATAFILE, Buf, Len)) {
+      End = Buf + Len;
+      for (p = Buf; p < End && IsSpace(*p); p++);
+      if ((p = Parse_Int(p, End, &VectLen)) != NULL) {
+        for (; p < End && IsSpace(*p); p++);
+        p = Parse_Int(p, End, &XCnt);
+      }
+      if (!p || VectLen < 1) {
+        printf("\n*error* %s must begin with p and n (two positive integers)\n\n",
+               DATAFILE);
+        Info_Exit();
+      }
+      Select_Cols(VectLen);
+      if (XCnt > 0) {
+        Cnt = (long)FileCols * XCnt;
+        X = malloc((size_t)VectLen*XCnt*sizeof(double));
+        ALLCHK(X)
+        Parse_Values(DATAFILE, Buf, p, End, Cnt);
+      }
+      Unmap_File(Buf, Len);
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void Load_Data(char *DATAFILE)
+/* Read_Data, then the seed and the checks on the data */
+{
+    FILE *f;			  /* seed file */
+    int r;                        /* for error detection */
+
+    Read_Data(DATAFILE);
+    if (AllRows <= VectLen) {
+      printf("\n*error* For vectors of length %d, there must be at least %d points\n\n",
+		VectLen, VectLen+1);
+	Info_Exit();
+    }
+    if (!SeedSet) {             /* else it came from -seed */
+      if ((f = fopen(SEEDFILE,"r")) == NULL) {
+	printf("\nCould not open the seed file %s for read\n",SEEDFILE);
+        printf("This file should contain an integer between 1 and 100000.\n");
+        exit(1);
+      }
+      r = fscanf(f,"%ld",&SeedSave);
+      if (r != 1) {
+	printf("\nCould not read the seed from %s\n",SEEDFILE);
+        printf("This file should contain an integer between 1 and 100000.\n");
+        exit(1);
+      }
+      fclose(f);
+    }
+    Data_Ready(DATAFILE);
+}
+
+/*-------------------------------------------------------------------------*/
+void Dump_Data(char *msg)
+/* dump the X array */
+{
+    int row, col;
+
+    printf("Dump of X data array %s\n",msg);
+    for (row=1; row<=XCnt; row++) {
+	for (col=1; col<=VectLen; col++) printf("%E ",Xof(row,col));
+	printf("\n");
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/* the global data structures: each is (its name, the number of elements) */
+#define ROOM(V) V(JBits, XCnt) V(OnesList, XCnt) V(ZerosList, XCnt) \
+  V(BestJBits, XCnt) V(XBarJ, VectLen) V(XJ, (size_t)XCnt*VectLen) \
+  V(XJFreq, XCnt) V(ZJ, (size_t)XCnt*(VectLen+1)) \
+  V(C, VectLen*VectLen*2) V(A, (VectLen+1)*(VectLen+1)*2) \
+  V(SqResiduals, XCnt) V(kSqSpace, XCnt) V(dTilde, XCnt) V(wVector, XCnt) \
+  V(OldwVector, XCnt) V(ResidRecs, XCnt) V(kRecs, XCnt) V(uAu, XCnt+1)
+#define ROOM_LEN(v, Cnt) (((size_t)(Cnt)*sizeof(*v) + 15) & ~(size_t)15)
+
+void Make_Room()
+/* allocate space for global data structures */
+/* everything is made, no matter what you are doing .... */
+/* (all in one block, which the context keeps: the next run reuses it */
+/* if its n and p are the same) */
+{
+    size_t At = 0;
+#   define ROOM_ADD(v, Cnt) At += ROOM_LEN(v, Cnt);
+#   define ROOM_CUT(v, Cnt) v = (void *)(Room + At); At += ROOM_LEN(v, Cnt);
+
+    if (!Room || RoomXCnt != XCnt || RoomP != VectLen) {
+      free(Room);
+      ROOM(ROOM_ADD)
+      Room = malloc(At);
+      ALLCHK(Room)
+      RoomXCnt = XCnt; RoomP = VectLen;
+      At = 0;
+    }
+    ROOM(ROOM_CUT)
+}
+
+/*-------------------------------------------------------------------------*/
+void Check_Bits(int JCnt, char *msg)
+/* debug tool */
+{
+   int OPos, ZPos;  /* to loop through substring lists */
+   int i, locj;     /* to loop through JBits */
+
+    locj = 0;
+    for (i=0; i<XCnt; i++) locj += *(JBits+i);
+    if (locj != BaseSubSampleSize) {
+        printf("There are only %d bits rather than %d in J\n",locj,BaseSubSampleSize);
+        printf("%s\n",msg);
+        for (i=0; i<XCnt; i++) printf("%d ",*(JBits+i)); printf("\n");
+        exit(1);
+    }
+    for (OPos=0; OPos < JCnt; OPos++) if (!(*(JBits+*(OnesList+OPos)))) {
+        printf("zero bit Opos=%d, jbit pos is %d\n",OPos, *(OnesList+OPos));
+        printf("%s\n",msg);
+        exit(1);
+    }
+    for (ZPos=0; ZPos < JCnt; ZPos++) if ((*(JBits+*(ZerosList+ZPos)))) {
+        printf("one bit Zpos=%d, jbit pos is %d\n",ZPos, *(ZerosList+ZPos));
+        printf("%s\n",msg);
+        exit(1);
+    }
+    printf("bits OK: %s\n",msg);
+    for (i=0; i<XCnt; i++) printf("%d ",*(JBits+i)); printf("\n");
+}
+
+/*-------------------------------------------------------------------------*/
+void Create_SubString_Lists(const int JCnt)
+/* Update sub-string lists for ones and zeros in JBits	*/
+/* no need to clear first */
+/* JCnt is the size of the sub-sample */
+/* (this isn't as useful in genetic.c because we may never use them...)*/
+{
+    int row,oh=0,zee=0;			/* to loop */
+
+    for (row=0; row<XCnt; row++)
+	if (*(JBits+row)) *(OnesList+oh++) = row; else *(ZerosList+zee++)=row;
+}
+
+/*-------------------------------------------------------------------------*/
+void Form_XJ()
+/* put rows in XJ corresponding to the J set indexes */
+/* note that the indicator set is zero based; also note row data vectors*/
+{
+    int Xrow, XJrow, col;		 /* to loop */
+
+    XJrow = 1;
+    for (Xrow = 1; Xrow <= XCnt; Xrow++) {
+	if (*(JBits+Xrow-1)) {
+	    for (col = 1; col <= VectLen; col++)
+		XJof(XJrow, col) = Xof(Xrow, col);
+	    if (Freq) *(XJFreq+XJrow-1) = Freqof(Xrow);
+	    /* the row index is in the J set */
+	    XJrow++;
+	}
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void Form_ZJ(double *X)
+/* put rows in ZJ corresponding to the J set indexes */
+/* note that the indicator set is zero based; also note row data vectors*/
+/* X is provided as an argument to allow for ghost images */
+/* weighted rows are scaled by sqrt(Freq), so ZJ'ZJ counts them Freq times */
+{
+    int Zrow, ZJrow, col;		 /* to loop */
+    double r;				 /* the row's scale */
+
+    ZJrow = 1;
+    JWt = 0.;
+    for (Zrow = 1; Zrow <= XCnt; Zrow ++) {
+	if (*(JBits+Zrow-1)) {
+	    JWt += Freqof(Zrow);
+	    r = Freq ? sqrt((double)Freqof(Zrow)) : 1.;
+	    ZJof(ZJrow, 1) = r;
+	    for (col = 2; col <= VectLen+1; col++)
+		ZJof(ZJrow, col) = r * Xof(Zrow, col-1);
+	    /* the row index is in the J set */
+	    ZJrow++;
+	}
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void Dump_XJ(const int JCnt, char *msg)
+/* dump the bit map and the rows */
+/* JCnt is the size of the sub-sample */
+{
+    int row,col;	   /* to loop */
+
+    printf("J set and corresp. data matrix %s\n",msg);
+    for (row=0; row<XCnt; row++) printf("%2d",*(JBits+row));
+    printf("\n\n");
+    for (row=1; row<=JCnt; row++) {
+	for (col=1; col<=VectLen; col++) printf("%7E ",XJof(row,col));
+	printf("\n");
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void Dump_ZJ(const int JCnt, char *msg)
+/* dump the bit map and the rows */
+/* JCnt is the size of the sub-sample */
+{
+    int row,col;	   /* to loop */
+
+    printf("J set and corresp. ZJ:  %s\n",msg);
+    for (row=0; row<XCnt; row++) printf("%2d",*(JBits+row));
+    printf("\n\n");
+    for (row=1; row<=JCnt; row++) {
+	for (col=1; col<=VectLen+1; col++) printf("%7E ",ZJof(row,col));
+	printf("\n");
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void Compute_XBarJ(const int JCnt)
+/* compute XBarJ values (observations are "row" vectors) */
+/* JCnt is the size of the sub-sample */
+/* very simple (with weights, JCnt rows stand for more points) */
+{
+    int row, col;		    /* to loop */
+    double Wt = 0.;		    /* points in XJ */
+#   define XBCOL *(XBarJ+col-1)	  /* typing aid */
+
+    for (row=1; row<=JCnt; row++) Wt += XJFreqof(row);
+    for (col=1; col<=VectLen; col++) {
+	XBCOL = XJFreqof(1) * XJof(1,col);
+	for (row=2; row<=JCnt; row++) XBCOL += XJFreqof(row) * XJof(row,col);
+	XBCOL = XBCOL / Wt;
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void Dump_XBarJ(char *msg)
+/* display the estimate of the center */
+{
+    int col;		    /* to loop */
+
+    printf("Dump of Mean for current J set: %s\n",msg);
+    for (col=1; col <= VectLen; col++) printf("  %E\n", XBarJof(col));
+}
+
+/*-------------------------------------------------------------------------*/
+void Randomize_JBits(const int JCnt)
+/* produce random J bit settings */
+/* URan is to (0,1) not [0,1]; JBits is zero based */
+/* JCnt is the size of the sub-sample */
+{
+    int setsofar=0;	       /* keep track of number set */
+    int spot;		       /* element to consider setting */
+
+    memset(JBits, 0, (XCnt)*sizeof(int));
+
+    while (setsofar < JCnt) {
+	spot = (int)(URan(&Rng) * XCnt);
+	if (!(*(JBits+spot))) {
+	    ++setsofar;
+	    ++(*(JBits+spot));
+	}
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void Form_C(const int JCnt)
+/* form the covariance matrix for XJ */
+/* JCnt is the size of the sub-sample */
+
+{
+    int i, j;		       /* current cell in C */
+    int k;		       /* to loop through samples */
+    double Wt = 0.;	       /* points in XJ */
+
+    for (k=1; k<=JCnt; k++) Wt += XJFreqof(k);
+    for (i=1; i<=VectLen; i++) {
+	for (j=1; j<=i; j++) {
+	    Cof(i,j) = 0;
+	    for (k=1; k<=JCnt; k++) {
+		Cof(i,j) += XJFreqof(k) * (XJof(k,i) - XBarJof(i))
+			  * (XJof(k,j) - XBarJof(j));
+	    }
+	    Cof(i,j) = Cof(i,j) / (Wt - 1.);
+	}
+    }
+    for (i=1; i<=VectLen;i++) for (j=i+1; j<=VectLen;j++) Cof(i,j) = Cof(j,i);
+}
+
+/*-------------------------------------------------------------------------*/
+void Form_A(const int JCnt)
+/* form the ZJ * Trans(ZJ) */
+/* JCnt is size of half sample */
+{
+    int i, j;		       /* current cell in C */
+    int k;		       /* to loop through samples */
+
+    for (i=1; i<=VectLen+1; i++) {
+	for (j=1; j<=i; j++) {
+	    Aof(i,j) = 0;
+	    for (k=1; k<=JCnt; k++) {
+		Aof(i,j) += ZJof(k,i) * ZJof(k,j);
+	    }
+	}
+    }
+    for (i=1; i<=VectLen+1;i++) for (j=i+1; j<=VectLen+1;j++) Aof(i,j) = Aof(j,i);
+}
+
+/*-------------------------------------------------------------------------*/
+void Dump_C(char *msg)
+/* dump the C matrix (COLUMN MAJOR storage, but output the usual way) */
+{
+    int i,j;	/* to loop */
+    printf("Entire rectangle: %s\n",msg);
+    for (i=0; i<VectLen; i++) {
+	for (j=0; j<2*VectLen; j++) printf("%.2E ",*(C+i+j*VectLen));
+	printf("|\n");
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+void InvertC(double *C, int VectLen, double *Determinant)
+/* things are getting a bit hacked up here..... */
+/* assume C is VectLen by VectLen */
+/* C must have room for another square on the right */
+/* do Gauss-Jordon Elimination on C*x(j) = e(j); Strang 29 */
+/* see also page 38 (no use exchanging rows since PDS) */
+/* keep a running product of the pivots as the determinant of C */
+/* (later, try to do something more efficient (e.g. use Symm)) */
+/* COLUMN MAJOR arrays, look out... */
+/* pivots are left in original C space, result is on ``right'' side */
+
+{
+    /* "locals" */
+    int pivotrow, row, col;	/* to loop */
+    double Pivot;		/* C[pivotrow, pivotrow]	*/
+    double m;			/* multiplier */
+
+    /* put I in the right half */
+    for (row=1; row <= VectLen; row++)
+	for (col = VectLen+1; col <= 2*VectLen; col++)
+	    if (col == row+VectLen) Cof(row,col) = 1.; else Cof(row,col) = 0.;
+
+    /* forward elimination */
+    *Determinant = 1;   /* running product */
+    for (pivotrow = 1; pivotrow < VectLen; pivotrow++) {
+	if (Cof(pivotrow,pivotrow) <= 0.0) {
+	    /*printf("bad pivot at row %d, you lose\n",pivotrow);*/
+	    *Determinant = 0;
+	    return;
+	}
+	else { /* non-zero pivot in C[row,row] */
+	    Pivot = Cof(pivotrow, pivotrow);   /* two uses for pivot */
+	    for (row = pivotrow+1; row <= VectLen; row++) {
+		m = Cof(row, pivotrow) / Pivot;
+		for (col = pivotrow; col <= VectLen+pivotrow; col++) { 
+                    /* assumes no zero pivots shuffles!!!*/
+		    Cof(row,col) = Cof(row,col) - m * Cof(pivotrow,col);
+		}
+	    }
+	}
+	*Determinant *= Pivot;
+
+    }
+    *Determinant *= Cof(VectLen, VectLen);
+    if (!*Determinant) {return;}
+
+    /* back substitution, pivots are non-zero, so use them */
+    for (pivotrow = 2; pivotrow <=VectLen; pivotrow++){
+	Pivot = Cof(pivotrow, pivotrow);
+	for (row = 1; row < pivotrow; row++) {
+	    if (Cof(row,pivotrow)) {
+		m = Cof(row,pivotrow) / Pivot;
+		for (col = pivotrow; col <= VectLen+pivotrow; col++) {
+		    Cof(row,col) = Cof(row,col) - m*Cof(pivotrow, col);
+		}
+	    }
+	}
+    }
+
+    /* finally, divide the rows in the inverse by the pivots */
+    for (row = 1; row <= VectLen; row++)
+	for (col = VectLen+1; col <= 2*VectLen; col++)
+	    Cof(row, col) = Cof(row,col) / Cof(row,row);
+}
+
+/*-------------------------------------------------------------------------*/
+void InvertA(double *A, int VL, double *Determinant)
+/* things are getting a bit hacked up here..... */
+/* (what is needed is a few moments to write a general invert.... */
+/* this is hideous (we pass in VL+1 or else.... */
+/* see InvertC for details*/
+{
+    /* "locals" */
+    int pivotrow, row, col;	/* to loop */
+    double Pivot;		/* A[pivotrow, pivotrow]	*/
+    double m;			/* multiplier */
+
+    /* put I in the right half */
+    for (row=1; row <= VL; row++)
+	for (col = VL+1; col <= 2*VL; col++)
+	    if (col == row+VL) Aof(row,col) = 1; else Aof(row,col) = 0;
+
+    /* forward elimination */
+    *Determinant = 1;   /* running product */
+    for (pivotrow = 1; pivotrow < VL; pivotrow++) {
+	if (!Aof(pivotrow,pivotrow)) {
+	    /* printf("zero pivot at row %d, you lose\n",pivotrow); */
+	    *Determinant = 0;
+	    return;
+	}
+	else {
+	    /* non-zero pivot in A[row,row] */
+	    Pivot = Aof(pivotrow, pivotrow);   /* two uses for pivot */
+	    for (row = pivotrow+1; row <= VL; row++) {
+		m = Aof(row, pivotrow) / Pivot;
+		for (col = pivotrow; col <= VL+pivotrow; col++) { /* assumes no zero pivots shuffles!!!*/
+		    Aof(row,col) = Aof(row,col) - m * Aof(pivotrow,col);
+		}
+	    }
+	}
+	*Determinant *= Pivot;
+
+    }
+    *Determinant *= Aof(VL, VL);
+    if (!*Determinant) return;
+
+    /* back substitution, pivots are non-zero, so use them */
+    for (pivotrow = 2; pivotrow <=VL; pivotrow++){
+	Pivot = Aof(pivotrow, pivotrow);
+	for (row = 1; row < pivotrow; row++) {
+	    if (Aof(row,pivotrow)) {
+		m = Aof(row,pivotrow) / Pivot;
+		for (col = pivotrow; col <= VL+pivotrow; col++) {
+		    Aof(row,col) = Aof(row,col) - m*Aof(pivotrow, col);
+		}
+	    }
+	}
+    }
+
+    /* finally, divide the rows in the inverse by the pivots */
+    for (row = 1; row <= VL; row++)
+	for (col = VL+1; col <= 2*VL; col++)
+	    Aof(row, col) = Aof(row,col) / Aof(row,row);
+}
+
+/*-------------------------------------------------------------------------*/
+int Compare_doubles(const void *arg1, const void *arg2)
+/* compare *arg1 and *arg2 as per qsort needs */
+/* assume that doubles can never really be equal */
+{
+    if (*(double*)arg1 < *(double*)arg2) return(-1); else return(1);
+}
+
+/*-------------------------------------------------------------------------*/
+void Global_Space(struct SimSpace *S)
+/* describe the global vectors as a SimSpace (nothing is copied) */
+{
+    S->XCnt = XCnt; S->X = X; S->XBarJ = XBarJ; S->C = C;
+    S->SqResiduals = SqResiduals; S->kSqSpace = kSqSpace; S->dTilde = dTilde;
+    S->kRecs = kRecs;
+    S->wVector = wVector; S->OldwVector = OldwVector;
+    S->Sumw = Sumw; S->Sumv = Sumv; S->Determinant = Determinant;
+    S->Rng = Rng;
+    S->Ghost = 0;
+    S->Freq = Freq;
+}
+
+/*-------------------------------------------------------------------------*/
+void Make_Sim_Space(struct SimSpace *S, int n)
+/* allocate a workspace for samples of size n (VectLen must be set) */
+{
+    S->XCnt = n;
+    S->X = malloc((size_t)n*VectLen*sizeof(double)); ALLCHK(S->X)
+    S->XBarJ = malloc(VectLen*sizeof(double)); ALLCHK(S->XBarJ)
+    S->C = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(S->C)
+    S->SqResiduals = malloc(n*sizeof(double)); ALLCHK(S->SqResiduals)
+    S->kSqSpace = malloc(n*sizeof(double)); ALLCHK(S->kSqSpace)
+    S->kRecs = NULL;                /* simulated samples have no Freq */
+    S->dTilde = malloc(n*sizeof(double)); ALLCHK(S->dTilde)
+    S->wVector = malloc(n*sizeof(double)); ALLCHK(S->wVector)
+    S->OldwVector = malloc(n*sizeof(double)); ALLCHK(S->OldwVector)
+    S->Sumw = S->Sumv = S->Determinant = 0.;
+    RS_Init(&S->Rng, SeedSave, RS_SIM, 0);
+    S->Ghost = 0;
+    S->Freq = NULL;
+}
+
+/*-------------------------------------------------------------------------*/
+void Free_Sim_Space(struct SimSpace *S)
+{
+    free(S->X); free(S->XBarJ); free(S->C);
+    free(S->SqResiduals); free(S->kSqSpace); free(S->dTilde);
+    free(S->wVector); free(S->OldwVector);
+}
+
+/*--------------------------------------------------------------------------*/
+void Space_Distance_Vector(struct SimSpace *S)
+/* Compute_Distance_Vector for the sample in S */
+{
+    double *X = S->X, *XBarJ = S->XBarJ, *C = S->C;
+    double *SqResiduals = S->SqResiduals;
+    int XCnt = S->XCnt;
+    double rowsum;	      /* to accumulate rightmost mult first */
+    int i;		      /* index into vector being formed */
+    int row, col;	      /* indexes for vector matrix mult. */
+			      /* (row and col refer to c-1) */
+
+    for (i=1; i<=XCnt; i++) {
+        *(SqResiduals+i-1) = 0.;
+	for (row = 1; row <= VectLen; row++) {
+	   rowsum = 0;
+	   for (col = 1; col <= VectLen; col++) {
+	     rowsum += (Xof(i,col) - XBarJof(col)) * C_1of(row,col);
+	   }
+	   *(SqResiduals+i-1) += rowsum * (Xof(i,row) - XBarJof(row));
+	}
+    }
+}
+
+/*--------------------------------------------------------------------------*/
+void Compute_Distance_Vector()
+/* compute a squared distance vector (called SqResiduals) for the current C_1
+ and sub-sample
+*/
+{
+    struct SimSpace G;
+
+    Global_Space(&G);
+    Space_Distance_Vector(&G);
+}
+
+/*-------------------------------------------------------------------------*/
+void Compute_mJ2()
+/* replace the word "median" with (n+p+1)/2 percentile */
+/* compute a vector that represents the argument to the med in 1.24 */
+/* then find sqrt of its median and place it in global mJ */
+/* note that the vector is declared globally for mindless dynamic allocation*/
+/* (Could form vectors to save a subtraction at the expense of an assignment*/
+/* and loop control; if you have a vector processor, you may want to do it) */
+{
+    Compute_Distance_Vector();
+    qsort(SqResiduals, XCnt, sizeof(double), Compare_doubles);
+    mJ2 = *(SqResiduals+(XCnt+VectLen+1)/2);
+}
+
+/*-------------------------------------------------------------------------*/
+double Mahalanobis_Dist(int SampNo)
+/* find the squared mahalanombis distance to the sample SampNo (not 0 based) */
+/* using the current C inverse and the current X bar */
+{
+    double rowsum;	      /* to accumulate rightmost mult first */
+    double RetVal=0.;	      /* to collect the distance (squared) */
+    int row, col;	      /* indexes for vector matrix mult. */
+			      /* (row and col refer to c inverse) */
+
+    for (row = 1; row <= VectLen; row++) {
+	rowsum = 0.;
+	for (col = 1; col <= VectLen; col++) {
+	    rowsum += (Xof(SampNo,col) - XBarJof(col)) * C_1of(row,col);
+	}
+	RetVal += rowsum * (Xof(SampNo,row) - XBarJof(row));
+    }
+    return RetVal;
+}
+
+/*-------------------------------------------------------------------------*/
+void Record_Best()
+/* the global variable ObjectiveValue < BestObjectiveValue so do some
+   bookkeeping */
+{
+    int i, cntj;                   /* to count bits */
+
+    BestObjectiveValue = ObjectiveValue;
+    Copy(BestJBits, JBits, XCnt);
+    cntj = 0;
+    for (i=0; i<XCnt; i++) cntj += *(JBits+i);
+    if (cntj != BaseSubSampleSize) {
+        printf("wrong number of bits in best %d\n",cntj);
+        for (i=0; i<XCnt; i++) printf("%d ",*(JBits+i));
+        exit(1);
+    }
+    if (Trace) printf("Objective Value Reduced to %14.9lf\n", ObjectiveValue);
+    if (Trace) {for (i=0; i<XCnt; i++) printf("%d ",*(JBits+i)); printf("\n");}
+}
+
+/*---------------------------------------------------------------------------*/
+void Process_JBits(const int JCnt)
+/* Given JBits, do all the calculations	*/
+{
+    int debcnt=0;  /* debug count */
+
+    Form_ZJ(X);
+    Form_A(JCnt);
+    InvertA(A, VectLen+1, &Determinant);
+    ObjectiveValue = Determinant;   /* LOOK! unscaled by 1/(n-h)^(p+1) */
+    /* with weights J sets differ in size, so compare det(A/JWt) */
+    if (Freq) ObjectiveValue /= pow(JWt, (double)(VectLen+1));
+    if (Determinant <= (double)0.0) {
+	printf("Singular Covariance matrix");
+	printf("Determinant = %E\n", Determinant);
+	Dump_ZJ(JCnt, "zero determinant");
+	printf("End of zero determinant dump\n");
+	ObjectiveValue = 10 * ObjectiveValue;  /* try to stay out */
+	SingularCnt++;
+//	return;
+        exit(1);
+    }
+
+    if (!ObjectiveValue) {
+	printf("Zero objective value\n");
+	printf("Determinant = %E, mJ2=%E\n", Determinant, mJ2);
+	Dump_XJ(JCnt, "Zero objective Value");
+	printf("End of zero objective value dump\n");
+	exit(1);
+    }
+    if (ObjectiveValue < BestObjectiveValue){
+	Record_Best();
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+double rho(double d)
+/* compute the rho function, use conditional compilition for more forms...*/
+/* assume that c is global */
+/* change this to a macro for slight speed up */
+{
+    double d2,c2,c4,d4,M2,M4;	/* intermediate calcs */
+    double retval;		/* debugging */
+
+   if (d > (M + c1)) return(M*M/2. + c1 * (5.*c1 + 16.*M)/30.);
+   else if (d >= M) {
+     d2 = d*d; d4 = d2*d2;
+     c2 = c1*c1; c4 = c2*c2;
+     M2 = M*M; M4 = M2*M2;
+     retval = M2/2. - M2 * (M4 - 5.*M2*c2 + 15.*c4)/(30.*c4)
+	      +d2*(0.5 + M4/(2*c4) - M2/c2)
+	      +d*d2*(4*M/(3*c2) - 4*M2*M/(3*c4))
+	      +d4*(3*M2/(2*c4) - 1/(2*c2))
+	      -4*M*d*d4/(5*c4) + d4*d2/(6*c4);
+     return(retval);
+   }
+   else return(d*d/2.);
+}
+
+/*---------------------------------------------------------------------------*/
+double psi(double d)
+/* compute the psi function, use conditional compilition for more forms...*/
+/* assume that c is global */
+/* change this to a macro for slight speed up */
+{
+    double inner;   /* intermediate calc */
+
+   if (d > (M + c1)) return(0.);
+   else if (d >= M) {
+     inner = 1. - ((d-M)/c1)*((d-M)/c1);
+     return(d * inner * inner);
+   } else return(d);
+}
+
+/*---------------------------------------------------------------------------*/
+double w(double d)
+/* compute the weight function, use conditional compilition for more forms...*/
+/* assume that c1 is global */
+/* change this to a macro for slight speed up */
+{
+    double inner;   /* intermediate calc */
+
+   if (d > (M + c1)) return(0.);
+   else if (d >= M) {
+     inner = 1 - ((d-M)/c1)*((d-M)/c1);
+     return(inner * inner);
+   } else return(1.);
+}
+
+/*---------------------------------------------------------------------------*/
+double Space_Compute_k(struct SimSpace *S)
+/* Compute_k for the sample in S (memcpy: the Copy macro is not reentrant) */
+/* with weights the rank counts each row Freq times */
+{
+    double *kSqSpace = S->kSqSpace;
+    int *Freq = S->Freq;
+    int XCnt = S->XCnt;
+    double k;                   /* newton converge on k (return val) */
+    struct ResidRec *R = S->kRecs;  /* the distances with their rows */
+    long Rank, Seen;
+    int i;
+
+    if (Freq) {
+        for (Rank=i=0; i<XCnt; i++) {
+            R[i].SqMahalDist = S->SqResiduals[i]; R[i].SampleNum = i;
+            Rank += Freq[i];
+        }
+        qsort(R, XCnt, sizeof(struct ResidRec), Compare_Resids);
+        Rank = (Rank+S->Ghost+VectLen+1)/2;
+        for (Seen=i=0; i<XCnt-1 && (Seen += Freq[R[i].SampleNum]) <= Rank; i++);
+        k = sqrt(R[i].SqMahalDist) / M;
+        return(k);
+    }
+    memcpy(kSqSpace, S->SqResiduals, XCnt*sizeof(double));
+    qsort(kSqSpace, XCnt, sizeof(double), Compare_doubles);
+    k = sqrt(*(kSqSpace+(XCnt+S->Ghost+VectLen+1)/2)) / M;
+    return(k);     
+}
+
+/*---------------------------------------------------------------------------*/
+double Compute_k()
+/* find the k value to enforce the constraint (see Rocke paper) */
+/* assumes the distances vector, SqResiduals, has been computed */
+{
+    struct SimSpace G;
+
+    Global_Space(&G);
+    return(Space_Compute_k(&G));
+}
+
+/*---------------------------------------------------------------------------*/
+void Space_wVector_and_Sums(struct SimSpace *S)
+/* (for s estimation iteration) find a k value and then adjust the distances*/
+/* Assume that b0 is global */
+/* the result is placed in the vector dTilde */
+/* note: cute math, fk = mean(rho(d/k)) and dfk = -mean(psi(d/k)*d/k^2)
+/* also pre-compute the results of calls to the w function */
+{
+    double *SqResiduals = S->SqResiduals, *dTilde = S->dTilde;
+    double *wVector = S->wVector;
+    int *Freq = S->Freq;
+    int XCnt = S->XCnt;
+    double Sumw, Sumv;
+    double k;                   /* newton converge on k*/
+    int i;                      /* to loop for sums */
+
+    k = Space_Compute_k(S);
+    Sumw = Sumv = 0.;
+    for (i=0; i<XCnt; i++) { 
+        *(wVector+i) = w((*(dTilde+i) = sqrt(*(SqResiduals+i))/k));
+        Sumw += Freqof(i+1) * (*(wVector+i));
+        Sumv += Freqof(i+1) * (*(wVector+i)) * (*(SqResiduals+i) / (k*k));
+    }
+    S->Sumw = Sumw; S->Sumv = Sumv;
+}
+
+/*---------------------------------------------------------------------------*/
+void Compute_wVector_and_Sums()
+/* Space_wVector_and_Sums on the globals */
+{
+    struct SimSpace G;
+
+    Global_Space(&G);
+    Space_wVector_and_Sums(&G);
+    Sumw = G.Sumw; Sumv = G.Sumv;
+}
+
+/*---------------------------------------------------------------------------*/
+void Space_M_Iterate(struct SimSpace *S)
+/* given a C matrix, iterate to an M estimate */
+/* note that this routines abuses many data structures, in particular,
+   XBarJ is used as the iterated mean and C is adjusted as well
+*/
+/* assumes that c and b0 have been set */
+{
+    double *X = S->X, *XBarJ = S->XBarJ, *C = S->C;
+    double *wVector = S->wVector, *OldwVector = S->OldwVector;
+    int *Freq = S->Freq;
+    int XCnt = S->XCnt;
+    int i,j,k;                        /* to loop */
+    double MaxWDelta;                 /* max delta of a wieight element */
+    long siters=0;                    /* to time out on iterations */
+
+    S->Sumw = 0;
+    for (i=0; i<XCnt; i++) *(OldwVector+i) = 1.;
+    do {
+        InvertC(C, VectLen, &S->Determinant);
+        if (S->Determinant <= 0.0) {
+            printf("Singular Covariance matrix\n");
+	        printf("Determinant = %E\n", S->Determinant);
+            printf("w vector\n");
+            for (j = 0; j <XCnt; j++) printf("%E ",*(wVector+j));
+            printf("\n");
+	        printf("End of zero determinant dump from M_Iterate\n");
+            exit(1);
+        }
+        Space_Distance_Vector(S);
+        Space_wVector_and_Sums(S);
+        for (j = 1; j <= VectLen; j++) {
+            XBarJof(j) = 0.;
+            for (i=0; i < XCnt; i++)
+                XBarJof(j) += Freqof(i+1) * (*(wVector+i)) * Xof(i+1,j);
+            XBarJof(j) = XBarJof(j) / S->Sumw;
+	    }
+        for (i=1; i<=VectLen; i++) { /* sorry about the use of k for i */
+	    for (j=1; j<=i; j++) {
+	        Cof(i,j) = 0;
+   	        for (k=1; k<=XCnt; k++) {
+		    Cof(i,j) += Freqof(k) * (*(wVector+k-1))
+                              * (Xof(k,i) - XBarJof(i))
+			      * (Xof(k,j) - XBarJof(j));
+	        }
+	        Cof(i,j) = VectLen * Cof(i,j) / S->Sumv;
+	    }
+        }
+        for (i=1; i<=VectLen;i++) 
+            for (j=i+1; j<=VectLen;j++) 
+                Cof(i,j) = Cof(j,i);
+        MaxWDelta = 0.;
+        for (i=0; i<XCnt; i++) {
+            if (dabs((*(wVector+i)) - (*(OldwVector+i))) > MaxWDelta)
+                MaxWDelta = dabs((*(wVector+i)) - (*(OldwVector+i)));
+            *(OldwVector+i) = *(wVector+i);
+	}
+        if (siters++ > (long)(1./(float)WTOL)) {
+            printf("Time out in M convergence, MaxWDelta = %lf, WTOL = %lf\n",
+                   MaxWDelta, WTOL);
+            break;
+	}
+    } while (MaxWDelta > WTOL); /* wgts converge */
+}
+
+/*---------------------------------------------------------------------------*/
+void M_Iterate()
+/* Space_M_Iterate on the globals */
+{
+    struct SimSpace G;
+
+    Global_Space(&G);
+    Space_M_Iterate(&G);
+    Sumw = G.Sumw; Sumv = G.Sumv; Determinant = G.Determinant;
+}
+
+/* --------------------------------------------------------------------------*/
+double xp(float p)
+/* return inverse of normal (approx. Abromowitz and Stegun 941 */
+{
+  double t;
+  if (p > (float)0.5) p = (float)1.-p;
+  t = sqrt(log(1/(p*p)));
+#define a0 2.30753
+#define a1 0.27061
+#define b1 0.99229
+#define b2 0.04481
+  return t - (a0 + a1*t) / (1+b1*t+b2*t*t);
+#undef a0
+#undef a1
+#undef b1
+#undef b2
+}
+
+/* --------------------------------------------------------------------------*/
+double ChiSq_1(int v, float x)
+/* return the x point of a v degree chi square (e.g., its inverse)*/
+/* (approx. Abromowitz and Stegun 932 */
+/* only above the median */
+{
+  double inner;
+  inner =  1. - 2./(9.*v) + xp(x) * sqrt((double)2./(double)(9.*v));
+  return v * inner * inner * inner;
+}
+
+/* --------------------------------------------------------------------------*/
+float ChiSq(int v, double D, double tol)
+/* return the v degree chi square by searching the inverse */
+{
+  int i=0;  /* debug... get rid of this */
+  float bot, top, mid;  /* for binary search */
+  double d;             /* mid dist */
+  bot = (float)0.5;
+  top = (float)1. - (float)tol;
+  if ((D > ChiSq_1(v, top)) || (D < ChiSq_1(v, bot))) {
+    printf("Cannot find chiSq(%d) for %lf (tol=%lf)\n", v, D, tol);
+    exit(1);
+  }
+  mid = (top+bot)/(float)2.;
+  while ((dabs((d = (double)ChiSq_1(v, mid))-D) > tol) && (++i<20)) {
+    if (d > D) top = mid; else bot = mid;
+    mid = (top + bot) / (float)2.;
+  }
+  return(mid);
+}
+
+
+/*---------------------------------------------------------------------------*/
+void Set_c_and_b0()
+/* set the values of c and M using rough approximations */
+/* ignore the requested breakdown point */
+/* no longer b0 because we are no longer using S */
+{    
+    double MPlusc;  /* F^-1(1-arp) */
+
+    MPlusc = ChiSq_1(VectLen, (float)0.999);
+    M = sqrt(ChiSq_1(VectLen, (float)(AllPoints+VectLen+1)/(float)(2*AllPoints)));
+    c1 = sqrt(MPlusc) - M;
+    ActualBP = 0.;  /* not used */
+}
+
+/*-------------------------------------------------------------------------*/
+int Compare_Resids(const void *arg1, const void *arg2)
+/* compare *arg1 and *arg2 as per qsort needs */
+/* assume that doubles can never really be equal */
+{
+  if (((struct ResidRec *)arg1)->SqMahalDist 
+      < ((struct ResidRec *)arg2)->SqMahalDist) 
+        return(-1); else return(1);
+}
+
+/*---------------------------------------------------------------------------*/
+void Sim_Block(struct SimSpace *S, int UseAlgo)
+/* draw a standard normal sample into S from S->Rng, estimate */
+/* location and shape and leave the squared distances in S->SqResiduals */
+{
+  double *X = S->X, *XBarJ = S->XBarJ, *C = S->C;
+  int XCnt = S->XCnt;
+  int row, col, i, j;
+
+  Norm_Fill(X, XCnt * VectLen, &S->Rng);
+  for (col=1; col<=VectLen; col++) {       /* Compute_XBarJ(n) */
+    XBarJof(col) = Xof(1,col);
+    for (row=2; row<=XCnt; row++) XBarJof(col) += Xof(row,col);
+    XBarJof(col) = XBarJof(col) / XCnt;
+  }
+  for (i=1; i<=VectLen; i++) {             /* Form_C(n) */
+    for (j=1; j<=i; j++) {
+      Cof(i,j) = 0;
+      for (row=1; row<=XCnt; row++)
+        Cof(i,j) += (Xof(row,i) - XBarJof(i)) * (Xof(row,j) - XBarJof(j));
+      Cof(i,j) = Cof(i,j) / (double)(XCnt - 1);
+    }
+  }
+  for (i=1; i<=VectLen;i++) for (j=i+1; j<=VectLen;j++) Cof(i,j) = Cof(j,i);
+  if (UseAlgo) Use_Algo_Rej_Code(S);
+  InvertC(C, VectLen, &S->Determinant);
+  Space_Distance_Vector(S);
+}
+
+/*---------------------------------------------------------------------------*/
+/* the upper tail of a stream of distances: a min-heap of the Cap largest */
+struct TailHeap {
+  int Cnt, Cap;          /* used and allocated */
+  double *v;             /* v[0] is the smallest value kept */
+};
+
+/*---------------------------------------------------------------------------*/
+void Tail_Init(struct TailHeap *H, int Cap)
+{
+  H->Cnt = 0; H->Cap = Cap;
+  H->v = malloc(Cap * sizeof(double)); ALLCHK(H->v)
+}
+
+/*---------------------------------------------------------------------------*/
+void Tail_Add(struct TailHeap *H, double d)
+/* offer d to the heap; it is kept if it is among the Cap largest so far */
+{
+  double *v = H->v;
+  int i, c;            /* hole and child */
+
+  if (H->Cnt < H->Cap) {               /* sift up */
+    for (i = H->Cnt++; i > 0 && v[(i-1)/2] > d; i = (i-1)/2) v[i] = v[(i-1)/2];
+    v[i] = d;
+  } else if (d > v[0]) {               /* replace the min and sift down */
+    for (i = 0; (c = 2*i+1) < H->Cnt; i = c) {
+      if (c+1 < H->Cnt && v[c+1] < v[c]) c++;
+      if (v[c] >= d) break;
+      v[i] = v[c];
+    }
+    v[i] = d;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+double Tail_Cut(double *v, int Cnt, int CutCnt)
+/* v holds (at least) the CutCnt+1 largest of a sample; return the cutoff */
+/* between the CutCnt largest and the rest, as the old full sort did */
+/* (v is reordered) */
+{
+  qsort(v, Cnt, sizeof(double), Compare_doubles);
+  return (v[Cnt-CutCnt] + v[Cnt-CutCnt-1]) / 2.;
+}
+
+/*---------------------------------------------------------------------------*/
+/* variance reduction for the cutoff simulation (VarRed)                    */
+/* The translated biweight gives tail points no weight, so a tail point of */
+/* a sample does not move the estimate: its distance behaves like that of */
+/* a fresh point measured against the estimate from the other n-1 points */
+/* (with one ghost point beyond them all in the rank that sets k).  So each */
+/* block fits n-1 points and then measures many cheap probe points drawn */
+/* from N(0, s^2 I), s > 1, so that they land in the tail; they come in */
+/* antithetic pairs x, -x and carry the likelihood ratio weight */
+/* s^p exp(-|x|^2 (1 - 1/s^2) / 2).  This is exact once the cutoff is */
+/* beyond M + c1 (cut fractions near 0.001 and below) and close above it. */
+/* (Negating a whole sample would be useless: the distances are affine */
+/* invariant, so the antithetic sample gives the very same distances.) */
+struct Probe {
+  double d;              /* squared distance */
+  double lr;             /* likelihood ratio weight */
+};
+
+/*---------------------------------------------------------------------------*/
+double Probe_Scale(float a)
+/* probe sd: put the mean squared radius at the chi square cutoff */
+{
+  double s2 = ChiSq_1(VectLen, (float)1.-a) / VectLen;
+
+  return s2 > 1. ? sqrt(s2) : 1.;
+}
+
+/*---------------------------------------------------------------------------*/
+void Sim_Probes(struct SimSpace *S, int m, double s, struct Probe *P)
+/* measure m (even) probe points against the estimate and C-1 in S */
+{
+  double *XBarJ = S->XBarJ, *C = S->C;
+  double *Dev, *x;          /* all the deviates, and this probe */
+  double r2, lr, sgn, rowsum;
+  int i, k, row, col;
+
+  Dev = malloc((size_t)(m/2) * VectLen * sizeof(double)); ALLCHK(Dev)
+  Norm_Fill(Dev, m/2 * VectLen, &S->Rng);
+  for (i=0, x=Dev; i<m; i+=2, x+=VectLen) {
+    r2 = 0.;
+    for (col=0; col<VectLen; col++) {
+      x[col] *= s;
+      r2 += x[col] * x[col];
+    }
+    lr = pow(s, (double)VectLen) * exp(-r2 * (1. - 1./(s*s)) / 2.);
+    for (k=0, sgn=1.; k<2; k++, sgn=-1.) {
+      P[i+k].d = 0.;
+      P[i+k].lr = lr;
+      for (row = 1; row <= VectLen; row++) {
+        rowsum = 0.;
+        for (col = 1; col <= VectLen; col++)
+          rowsum += (sgn*x[col-1] - XBarJof(col)) * C_1of(row,col);
+        P[i+k].d += rowsum * (sgn*x[row-1] - XBarJof(row));
+      }
+    }
+  }
+  free(Dev);
+}
+
+/*-------------------------------------------------------------------------*/
+int Compare_Probes(const void *arg1, const void *arg2)
+/* for qsort: decreasing distance */
+{
+  if (((struct Probe *)arg1)->d > ((struct Probe *)arg2)->d) return(-1);
+  else return(1);
+}
+
+/*---------------------------------------------------------------------------*/
+double Weighted_Tail_Cut(struct Probe *P, int Cnt, float a)
+/* the cutoff with weighted tail mass a (P is reordered); the same rule */
+/* as Tail_Cut when all the weights are one */
+{
+  double Mass = 0.;
+  int i;
+
+  qsort(P, Cnt, sizeof(struct Probe), Compare_Probes);
+  for (i=0; i<Cnt-1; i++)
+    if ((Mass += P[i].lr / Cnt) >= a) break;
+  return i < Cnt-1 ? (P[i].d + P[i+1].d) / 2. : P[Cnt-1].d;
+}
+
+/*---------------------------------------------------------------------------*/
+double t975(int df)
+/* upper 0.025 point of Student's t (Cornish-Fisher; fine for df >= 3) */
+{
+  double z = 1.959964, z3, z5, z7;
+
+  if (df < 1) return HUGE_VAL;
+  if (df == 1) return 12.706;
+  if (df == 2) return 4.303;
+  z3 = z*z*z; z5 = z3*z*z; z7 = z5*z*z;
+  return z + (z3 + z)/(4.*df) + (5.*z5 + 16.*z3 + 3.*z)/(96.*df*df)
+         + (3.*z7 + 19.*z5 + 17.*z3 - 15.*z)/(384.*df*df*df);
+}
+
+/*---------------------------------------------------------------------------*/
+void Sim_Task_Init(struct SimSpace *S, struct TailHeap *T, int n, int Keep,
+                   int VR)
+/* a thread's sample space and tail for the rounds of Sq_Rej_Dist */
+{
+  TASK(Make_Sim_Space(S, n);
+       Tail_Init(T, Keep);
+       if (VR) {S->XCnt = n-1; S->Ghost = 1;})
+}
+
+/*---------------------------------------------------------------------------*/
+void Sim_Task(struct SimSpace *S, struct TailHeap *T, uint32_t Block,
+              int UseAlgo, int Probes, double Scale, struct Probe *P)
+/* simulate block Block of Sq_Rej_Dist into the tail T, or with P, its */
+/* probes into P */
+{
+  int i;
+
+  TASK(RS_Init(&S->Rng, SeedSave, RS_SIM, Block);
+       Sim_Block(S, UseAlgo);
+       if (P) Sim_Probes(S, Probes, Scale, P);
+       else for (i=0; i<S->XCnt; i++) Tail_Add(T, S->SqResiduals[i]);)
+}
+
+/*---------------------------------------------------------------------------*/
+double Sq_Rej_Dist(int n, float a, float tol, int UseAlgo)
+/* useit controls use of the iterative estimator */
+/* find the distance to reject fraction a (for VectLen dimensions) */
+/* touches none of the data globals, so it can run beside the estimation */
+/* the blocks are independent: each gets its own SimSpace and its own */
+/* random stream (RS_SIM stream round * Blocks + block of the seed) */
+/* so the result does not depend on the number of threads */
+/* only the upper tail of each round is kept (in TailHeaps), so memory is */
+/* O(a * Blocks * n) and no full sort is needed; with PoolTails the */
+/* cutoff is read off the pooled tails of all rounds instead of being the */
+/* mean of the per-round cutoffs (only then are the tails kept, in a pool */
+/* that grows a round at a time) */
+/* the rounds are batches for a batch means 95% confidence interval on */
+/* the cutoff; its half width goes to CutHalf (zero with fewer than */
+/* CI_ROUNDS rounds, too few for the interval to mean much) and the */
+/* number of blocks used to CutBlocks.  If CutPrec > 0, tol is ignored: */
+/* rounds are made smaller and we stop once there are CI_ROUNDS of them */
+/* and the half width is below CutPrec * cutoff */
+/* with VarRed (and the iterative estimator) the rounds are made of */
+/* probes rather than sample points (see Sim_Probes), so the number of */
+/* blocks no longer grows like 1/(n a) */
+{
+  double sofar, oldsofar;  // these are cutoffs (sq distances)
+  double est, oldest;      /* current and previous estimates */
+  double *RoundCut;        /* per-round cutoffs (the batch means) */
+  double s2;               /* their sample variance */
+  double Half = HUGE_VAL;  /* CI half width */
+  int cnt, i;
+  int Blocks, Blk, Sector, CutCnt;
+  int MaxRounds;           /* give up after this many */
+  int Keep;                /* tail values kept per round */
+  struct TailHeap Round;   /* tail of the current round */
+  double *Pool = NULL;     /* with PoolTails, the tails of all rounds */
+  double *RoundMin = NULL; /*   so far and the smallest of each */
+  int PoolCap = 0;         /*   (rounds they have room for) */
+  int Stale = False;       /* a round tail may be too short for the pool */
+  int VR = VarRed && UseAlgo;
+  int Probes = 2 * n;      /* probes per block with VR */
+  double Scale = 0.;       /* and their sd */
+  struct Probe *Probe = NULL;
+
+  assert(n > VectLen);
+  CutHalf = 0.; CutBlocks = 0;
+  if (a<=0.) return HUGE_VAL;
+  if (a>=1.) return 0.;
+
+  Blocks = (int) (10./((float)n * a));  /* for small a */
+  if (Blocks < 40 || VR) Blocks = 40;
+  MaxRounds = 100;
+  if (CutPrec > 0. && Blocks >= 40) {
+    /* finer batches; each still expects at least 10 points in the tail */
+    i = Blocks;
+    Blocks = (int)ceil(10./((float)n * a));
+    if (Blocks < 10 || VR) Blocks = 10;
+    MaxRounds = MaxRounds * i / Blocks;
+  }
+  Sector = Blocks * n;
+  CutCnt = (int)(a * (float)Sector);
+  /* CutCnt+1 suffices for one round; the slack lets the pooled tail */
+  /* absorb rounds that put more than their share into the top */
+  Keep = CutCnt + 1 + (int)(4. * sqrt((double)CutCnt)) + 10;
+  if (Keep > Sector) Keep = Sector;
+  Tail_Init(&Round, Keep);
+  RoundCut = malloc((MaxRounds+1) * sizeof(double)); ALLCHK(RoundCut)
+  if (VR) {
+    Probe = malloc((size_t)Blocks * Probes * sizeof(struct Probe));
+    ALLCHK(Probe)
+    Scale = Probe_Scale(a);
+  }
+
+  cnt = 0;
+  sofar = oldsofar = est = oldest = 0.;
+  do {
+    Round.Cnt = 0;
+#   pragma omp parallel private(Blk, i) copyin(MO_STATE)
+    {
+      struct SimSpace S;             /* this thread's sample */
+      struct TailHeap T;             /* and its part of the round's tail */
+
+      memset(&S, 0, sizeof(S));
+      T.Cnt = 0; T.v = NULL;
+      Sim_Task_Init(&S, &T, n, Keep, VR);
+#     pragma omp for schedule(dynamic)
+      for (Blk = 0; Blk < Blocks; Blk++)
+        Sim_Task(&S, &T, (uint32_t)(cnt * Blocks + Blk), UseAlgo, Probes,
+                 Scale, VR ? Probe + (size_t)Blk*Probes : NULL);
+#     pragma omp critical
+      for (i=0; i<T.Cnt; i++) Tail_Add(&Round, T.v[i]);
+      free(T.v);
+      Free_Sim_Space(&S);
+    }
+    Region_Check();
+    if (VR) RoundCut[cnt] = Weighted_Tail_Cut(Probe, Blocks*Probes, a);
+    else {
+      if (PoolTails) {         /* the pool grows by doubling */
+        if (cnt == PoolCap) {
+          PoolCap = PoolCap ? 2 * PoolCap : 4;
+          Pool = realloc(Pool, (size_t)PoolCap * Keep * sizeof(double));
+          ALLCHK(Pool)
+          RoundMin = realloc(RoundMin, PoolCap * sizeof(double));
+          ALLCHK(RoundMin)
+        }
+        memcpy(Pool + (size_t)cnt*Keep, Round.v, Keep * sizeof(double));
+        RoundMin[cnt] = Round.v[0];
+      }
+      RoundCut[cnt] = Tail_Cut(Round.v, Keep, CutCnt);
+    }
+    oldsofar = sofar;
+    sofar += RoundCut[cnt];
+    oldest = est;
+    if (PoolTails && !VR) {
+      est = Tail_Cut(Pool, (cnt+1)*Keep, (cnt+1)*CutCnt);
+      for (i=0; i<=cnt; i++)   /* every round tail must reach below est */
+        if (RoundMin[i] >= est) Stale = True;
+    } else est = sofar/(cnt+1);
+    if (cnt > 0) {
+      for (s2 = 0., i=0; i<=cnt; i++)
+        s2 += (RoundCut[i] - sofar/(cnt+1)) * (RoundCut[i] - sofar/(cnt+1));
+      s2 /= cnt;
+      Half = t975(cnt) * sqrt(s2 / (cnt+1));
+    }
+    if (++cnt > MaxRounds) break;
+    if (Trace) printf ("ID sector cnt=%d, sofar=%lf, est=%lf +- %lf\n",
+                       cnt, sofar, est, Half);
+  } while (CutPrec > 0. ? (cnt < CI_ROUNDS) || (Half > CutPrec * est)
+                        : (cnt < 2) || (dabs(oldest - est) / est > tol));
+  if (Stale) 
+    printf("Warning: the pooled cutoff may be slightly low (short tails)\n");
+  if (CutPrec > 0. && Half > CutPrec * est)
+    printf("Warning: the cutoff precision %g was not reached in %d blocks\n",
+           CutPrec, cnt*Blocks);
+  CutHalf = cnt >= CI_ROUNDS ? Half : 0.;
+  CutBlocks = (long)cnt * Blocks;
+  free(Round.v); free(Pool); free(RoundMin); free(RoundCut); free(Probe);
+  return est;
+}
+
+/*---------------------------------------------------------------------------*/
+/* precomputed Sq_Rej_Dist(n, 0.01, 0.002, True) values (seed 1103854129) */
+/* rows are p, columns are n; zero means the (n,p) pair was not simulated */
+#define TBL_A (float)0.01
+#define TBL_NCNT 7
+#define TBL_PCNT 9
+int TblN[TBL_NCNT] = {50, 100, 200, 500, 1000, 2000, 5000};
+int TblP[TBL_PCNT] = {2, 3, 4, 5, 6, 8, 10, 15, 20};
+double TblCut[TBL_PCNT][TBL_NCNT] = {
+ {11.1066,  9.9088,  9.6218,  9.4379,  9.3415,  9.3564,  9.3372},
+ {13.5314, 12.2017, 11.6791, 11.4608, 11.3792, 11.3916, 11.3658},
+ {17.5777, 15.0311, 13.8757, 13.6155, 13.4774, 13.3919, 13.3264},
+ {20.6330, 16.7770, 15.8140, 15.4895, 15.2389, 15.1779, 15.1824},
+ {24.1804, 19.2700, 17.7919, 17.1006, 17.0174, 16.9371, 16.8952},
+ {32.2616, 24.8575, 21.7495, 20.6434, 20.3625, 20.1213, 20.0554},
+ {43.2250, 29.3293, 25.7566, 24.0244, 23.5976, 23.3952, 23.2883},
+ { 0.,     42.3884, 35.1409, 31.8657, 31.3096, 30.8968, 30.6812},
+ { 0.,     61.9713, 45.7968, 39.7156, 38.2823, 37.7564, 37.5129}
+};
+
+/*---------------------------------------------------------------------------*/
+double Table_Cutoff(int n, int p, float a)
+/* interpolate the built-in table; return 0 if (n,p,a) is not covered */
+/* bilinear in (1/n, p) on the ratio to the chi square point, which is */
+/* much flatter than the cutoff itself */
+{
+  int i, j;          /* grid cell is [TblP[i],TblP[i+1]] x [TblN[j],TblN[j+1]] */
+  double s, t;       /* position inside the cell */
+  double r[2][2];    /* corner ratios */
+  int di, dj;
+
+  if (a != TBL_A) return 0.;
+  if (n < TblN[0] || n > TblN[TBL_NCNT-1]) return 0.;
+  if (p < TblP[0] || p > TblP[TBL_PCNT-1]) return 0.;
+  for (i=0; i<TBL_PCNT-2 && TblP[i+1] < p; i++);
+  for (j=0; j<TBL_NCNT-2 && TblN[j+1] < n; j++);
+  for (di=0; di<2; di++) for (dj=0; dj<2; dj++) {
+    if (TblCut[i+di][j+dj] <= 0.) return 0.;
+    r[di][dj] = TblCut[i+di][j+dj] / ChiSq_1(TblP[i+di], (float)1.-a);
+  }
+  s = (double)(p - TblP[i]) / (double)(TblP[i+1] - TblP[i]);
+  t = (1./n - 1./TblN[j]) / (1./TblN[j+1] - 1./TblN[j]);
+  return ChiSq_1(p, (float)1.-a)
+         * ((1.-s)*(1.-t)*r[0][0] + (1.-s)*t*r[0][1]
+            + s*(1.-t)*r[1][0] + s*t*r[1][1]);
+}
+#undef TBL_A
+#undef TBL_NCNT
+#undef TBL_PCNT
+
+/*---------------------------------------------------------------------------*/
+/* closed form cutoffs (-approx): the scaled F form of Hardin and Rocke */
+/* (2005), "The distribution of robust distances", JCGS 14:928-946, */
+/* c (m-p+1)/(p m) d^2 ~ F(p, m-p+1), with m the "effective sample size" */
+/* of the estimate.  Their m (from Croux and Haesbroeck's asymptotics) is */
+/* for raw MCD distances and is far too small for the reweighted */
+/* M-estimate used here; the simulated table (TblCut) is matched to */
+/* within 2% rms and 5% at worst by c = 1 (the k scaling makes the */
+/* distances consistent) and m = APPROX_EFF * n. */
+#define APPROX_EFF 0.7
+/*---------------------------------------------------------------------------*/
+double Beta_I(double a, double b, double x)
+/* regularized incomplete beta function (Lentz continued fraction) */
+{
+  double bt, c, d, h, aa, del;
+  int m, m2;
+
+  if (x <= 0.) return 0.;
+  if (x >= 1.) return 1.;
+  bt = exp(lgamma(a+b) - lgamma(a) - lgamma(b) + a*log(x) + b*log(1.-x));
+  if (x > (a + 1.)/(a + b + 2.)) return 1. - Beta_I(b, a, 1.-x);
+  c = 1.; d = 1. - (a+b)*x/(a+1.);
+  if (dabs(d) < DBL_MIN) d = DBL_MIN;
+  d = 1./d; h = d;
+  for (m=1; m<500; m++) {
+    m2 = 2*m;
+    aa = m*(b-m)*x/((a-1.+m2)*(a+m2));
+    d = 1. + aa*d; if (dabs(d) < DBL_MIN) d = DBL_MIN;
+    c = 1. + aa/c; if (dabs(c) < DBL_MIN) c = DBL_MIN;
+    d = 1./d; h *= d*c;
+    aa = -(a+m)*(a+b+m)*x/((a+m2)*(a+1.+m2));
+    d = 1. + aa*d; if (dabs(d) < DBL_MIN) d = DBL_MIN;
+    c = 1. + aa/c; if (dabs(c) < DBL_MIN) c = DBL_MIN;
+    d = 1./d; del = d*c; h *= del;
+    if (dabs(del - 1.) < 1e-15) break;
+  }
+  return bt * h / a;
+}
+
+/*---------------------------------------------------------------------------*/
+double Inv_CDF(double (*cdf)(double, double, double), double a, double b,
+               double q)
+/* x with cdf(a, b, x) = q for an increasing cdf on (0, inf) by bisection */
+{
+  double lo = 0., hi = 1., mid;
+  int i;
+
+  while (cdf(a, b, hi) < q && hi < 1e300) hi *= 2.;
+  for (i=0; i<200 && hi - lo > 1e-12 * hi; i++) {
+    mid = (lo + hi) / 2.;
+    if (cdf(a, b, mid) < q) lo = mid; else hi = mid;
+  }
+  return (lo + hi) / 2.;
+}
+
+/*---------------------------------------------------------------------------*/
+double F_CDF(double d1, double d2, double x)
+{
+  return Beta_I(d1/2., d2/2., d1*x/(d1*x + d2));
+}
+
+/*---------------------------------------------------------------------------*/
+double Approx_Rej_Dist(double n, int p, float a)
+/* scaled F cutoff for rejecting fraction a (see above); takes microseconds */
+{
+  double m = APPROX_EFF * n;       /* estimated degrees of freedom */
+
+  if (a<=0.) return HUGE_VAL;
+  if (a>=1.) return 0.;
+  if (m < p + 1.) m = p + 1.;      /* keep the F denominator df positive */
+  return Inv_CDF(F_CDF, (double)p, m-p+1., 1.-a) * p * m / (m-p+1.);
+}
+
+/*---------------------------------------------------------------------------*/
+char *Cutoff_Version()
+/* cache key for the simulation code and the settings that change it */
+{
+  static TLS char Ver[32];
+
+  snprintf(Ver, sizeof(Ver), "%s%s%s%s", CUTOFF_VERSION,
+           PoolTails && !VarRed ? "p" : "", CutPrec > 0. ? "c" : "",
+           VarRed ? "v" : "");
+  return Ver;
+}
+
+/*---------------------------------------------------------------------------*/
+/* fcntl locks belong to the process, so its own threads take turns here */
+pthread_mutex_t CacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+int Lock_Cache(int fd, short how)
+/* block until we hold an fcntl lock of type how (or F_UNLCK) on fd */
+/* fcntl rather than flock so that the locks also work on NFS */
+/* (every lock must be undone with F_UNLCK, even if it failed) */
+{
+  struct flock fl;
+
+  if (how != F_UNLCK) pthread_mutex_lock(&CacheLock);
+  memset(&fl, 0, sizeof(fl));
+  fl.l_type = how;
+  fl.l_whence = SEEK_SET;      /* l_start = l_len = 0: the whole file */
+  if (how != F_UNLCK) return fcntl(fd, F_SETLKW, &fl);
+  fcntl(fd, F_SETLKW, &fl);
+  return pthread_mutex_unlock(&CacheLock);
+}
+
+/*---------------------------------------------------------------------------*/
+int Cache_Lookup(int n, int p, float a, float tol, int UseAlgo, double *Cut)
+/* look for a cutoff in the cache file; return True if one was found */
+/* lines are: version n p a tol usealgo cutoff [halfwidth blocks] */
+/* (tol is the precision goal if CutPrec is set) */
+{
+  char path[FILENAME_MAX];
+  char line[256], ver[64];
+  int fd, cn, cp, cu, found = False;
+  float ca, ct;
+  double cv, ch;
+  long cb;
+  FILE *f;
+
+  snprintf(path, sizeof(path), "%s/%s", CacheDir, CACHEFILE);
+  if ((fd = open(path, O_RDONLY)) < 0) return False;
+  if (Lock_Cache(fd, F_RDLCK) < 0 || !(f = fdopen(fd, "r"))) {
+    Lock_Cache(fd, F_UNLCK);
+    close(fd);
+    return False;
+  }
+  while (!found && fgets(line, sizeof(line), f)) {
+    ch = 0.; cb = 0;
+    if (sscanf(line, "%63s %d %d %f %f %d %lf %lf %ld",
+               ver, &cn, &cp, &ca, &ct, &cu, &cv, &ch, &cb) >= 7
+        && !strcmp(ver, Cutoff_Version()) && cn == n && cp == p
+        && ca == a && ct == tol && (cu != 0) == (UseAlgo != 0)) {
+      *Cut = cv;
+      CutHalf = ch; CutBlocks = cb;
+      found = True;
+    }
+  }
+  Lock_Cache(fd, F_UNLCK);
+  fclose(f);
+  return found;
+}
+
+/*---------------------------------------------------------------------------*/
+void Cache_Store(int n, int p, float a, float tol, int UseAlgo, double Cut)
+/* append a cutoff to the cache file; failure only costs a later resim */
+{
+  char path[FILENAME_MAX];
+  char line[256];
+  int fd, len;
+
+  mkdir(CacheDir, 0777);      /* usually it is already there */
+  snprintf(path, sizeof(path), "%s/%s", CacheDir, CACHEFILE);
+  if ((fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0666)) < 0) {
+    printf("Warning: could not write the cutoff cache %s\n", path);
+    return;
+  }
+  len = snprintf(line, sizeof(line), "%s %d %d %.9g %.9g %d %.17g %.9g %ld\n",
+                 Cutoff_Version(), n, p, (double)a, (double)tol,
+                 UseAlgo ? 1 : 0, Cut, CutHalf, CutBlocks);
+  if (Lock_Cache(fd, F_WRLCK) < 0 || write(fd, line, len) != len)
+    printf("Warning: could not write the cutoff cache %s\n", path);
+  Lock_Cache(fd, F_UNLCK);
+  close(fd);
+}
+
+int Memo_Find(int n, float a, float tol, float Goal, int UseAlgo, double *Cut);
+void Memo_Put(double Cut);
+
+/*---------------------------------------------------------------------------*/
+double Rej_Cutoff(int n, float a, float tol, int UseAlgo)
+/* Sq_Rej_Dist, but try the built-in table, the cutoffs this process has */
+/* already found (see Memo_Find) and the cutoff cache first */
+/* the simulated cutoff depends only on (n, p, a, tol, UseAlgo) */
+/* CutMode APPROX uses the closed form instead; CHECK uses the simulated */
+/* value but also reports how far the closed form is from it */
+{
+  double Cut;
+  float Goal = CutPrec > 0. ? CutPrec : tol;   /* what the cache keys on */
+
+  CutHalf = 0.; CutBlocks = 0;
+  if (CutMode != SIMULATE) ApproxCut = Approx_Rej_Dist(n, VectLen, a);
+  if (CutMode == APPROX) {
+    CutoffSource = "the scaled F approximation";
+    return ApproxCut;
+  }
+  if (UseCutTable && UseAlgo && (Cut = Table_Cutoff(n, VectLen, a)) > 0.) {
+    CutoffSource = "the built-in table";
+    return Cut;
+  }
+  if (Memo_Find(n, a, tol, Goal, UseAlgo, &Cut)) return Cut;
+  if (CacheDir && Cache_Lookup(n, VectLen, a, Goal, UseAlgo, &Cut))
+    CutoffSource = "the cutoff cache";
+  else {
+    Cut = Sq_Rej_Dist(n, a, tol, UseAlgo);
+    CutoffSource = "simulation";
+    if (CacheDir) Cache_Store(n, VectLen, a, Goal, UseAlgo, Cut);
+  }
+  Memo_Put(Cut);
+  return Cut;
+}
+
+/*---------------------------------------------------------------------------*/
+void Report_Approx_Check(FILE *f)
+/* CutMode CHECK: compare the closed form with the cutoff actually used */
+{
+  fprintf(f,"Self-check: scaled F approximation %.3E, %s %.3E (%+.1f%%)\n",
+          ApproxCut, CutoffSource, FirstCut, 
+          100. * (ApproxCut - FirstCut) / FirstCut);
+}
+
+/*---------------------------------------------------------------------------*/
+/* fast report formatting: the long parts of the report (the distance */
+/* listing and the data echo) are formatted here a line at a time and */
+/* written with fwrite into the report's large buffer */
+
+#define PUT_E_PREC 8            /* Put_E's largest precision */
+
+/*---------------------------------------------------------------------------*/
+char *Put_E(char *p, double v, int Prec)
+/* sprintf(p, "%.*E", Prec, v), returning the end: the value is scaled by */
+/* an exact power of ten and rounded; sprintf itself is used when that */
+/* could round differently (a remainder within 1e-6 of one half, far */
+/* exponents, zero, inf and nan) or Prec is over PUT_E_PREC */
+{
+  double a = dabs(v), s = 0., f;
+  uint64_t m;
+  int e, k, Try;
+  char Dig[PUT_E_PREC+1];
+
+  if (!(a >= 1e-300 && a <= 1e300) || Prec < 0 || Prec > PUT_E_PREC)
+    return p + sprintf(p, "%.*E", Prec, v);
+  e = (int)floor(log10(a));
+  for (Try=0; Try<3; Try++) {
+    if ((k = Prec - e) > 22 || k < -22) return p + sprintf(p, "%.*E", Prec, v);
+    s = k >= 0 ? a * Pow10[k] : a / Pow10[-k];
+    if (s < Pow10[Prec]) e--;
+    else if (s >= Pow10[Prec+1]) e++;
+    else break;
+  }
+  m = (uint64_t)s; f = s - (double)m;
+  if (Try == 3 || dabs(f - .5) < 1e-6) return p + sprintf(p, "%.*E", Prec, v);
+  if (f > .5) m++;
+  if (m == (uint64_t)Pow10[Prec+1]) {m /= 10; e++;}
+  for (k=Prec; k>=0; k--) {Dig[k] = (char)('0' + m % 10); m /= 10;}
+  if (v < 0.) *p++ = '-';
+  *p++ = Dig[0];
+  if (Prec) *p++ = '.';
+  for (k=1; k<=Prec; k++) *p++ = Dig[k];
+  *p++ = 'E';
+  *p++ = e < 0 ? '-' : '+';
+  if (e < 0) e = -e;
+  if (e >= 100) {*p++ = (char)('0' + e / 100); e %= 100;}
+  *p++ = (char)('0' + e / 10);
+  *p++ = (char)('0' + e % 10);
+  return p;
+}
+
+/*---------------------------------------------------------------------------*/
+char *Put_Int(char *p, long v, int Width)
+/* sprintf(p, "%*ld", Width, v), returning the end */
+{
+  char Dig[24];
+  unsigned long u = v < 0 ? -(unsigned long)v : (unsigned long)v;
+  int n = 0;
+
+  do Dig[n++] = (char)('0' + u % 10); while (u /= 10);
+  if (v < 0) Dig[n++] = '-';
+  for (; Width > n; Width--) *p++ = ' ';
+  while (n) *p++ = Dig[--n];
+  return p;
+}
+
+/*---------------------------------------------------------------------------*/
+void Put_Point(FILE *f, long Row, double d, int Out, int Times)
+/* one line of the distance listing (Row is one based); with only the */
+/* flags section, just the potential outliers are listed; Times > 1 is */
+/* a collapsed row's count */
+{
+  char Line[64], *p = Line;
+
+  if (!(Sections & R_DIST) && !Out) return;
+  *p++ = Out && (Sections & R_FLAGS) ? '*' : ' ';
+  memcpy(p, " point", 6); p += 6;
+  p = Put_Int(p, Row, 4);
+  *p++ = ':'; *p++ = ' ';
+  p = Put_E(p, d, 3);
+  if (Times > 1) {
+    memcpy(p, " (x", 3); p += 3;
+    p = Put_Int(p, Times, 1);
+    *p++ = ')';
+  }
+  *p++ = '\n';
+  fwrite(Line, 1, p - Line, f);
+}
+
+/*---------------------------------------------------------------------------*/
+void Put_Score(FILE *f, long Row, double d, int Flag)
+/* one line of a scores file: "%ld %.6E %d" */
+{
+  char Line[48], *p = Line;
+
+  p = Put_Int(p, Row, 1);
+  *p++ = ' ';
+  p = Put_E(p, d, 6);
+  *p++ = ' ';
+  *p++ = (char)('0' + Flag);
+  *p++ = '\n';
+  fwrite(Line, 1, p - Line, f);
+}
+
+/*---------------------------------------------------------------------------*/
+void Put_Row(FILE *f, double *x, char *Line)
+/* one line of the data echo ("%E " per value); Line has room for it */
+{
+  char *p = Line;
+  int j;
+
+  for (j=0; j<VectLen; j++) {p = Put_E(p, x[j], 6); *p++ = ' ';}
+  *p++ = '\n';
+  fwrite(Line, 1, p - Line, f);
+}
+#define ROW_CHARS (VectLen * 16 + 2)    /* Put_Row's Line size */
+
+/*---------------------------------------------------------------------------*/
+/* stream mode passes (see Stream_Open) */
+#define PartFirst(Part) ((Part) * Strm.n / STREAM_PARTS)   /* its first row */
+#define SELECT_BINS 4096        /* histogram bins (32 per octave) */
+#define SELECT_CAP (1L << 20)   /* most values Stream_Select will sort */
+
+/*---------------------------------------------------------------------------*/
+double *Stream_Row(long i, double *Tmp)
+/* row i (zero based) of the data: in the map for doubles, else in Tmp */
+/* (as is a row of just the -cols columns) */
+{
+  double *d;
+  float *f;
+  int j;
+
+  if (Strm.Dtype == MAT_F64) {
+    d = (double *)Strm.v + i * FileCols;
+    if (!ColOf) return d;
+    for (j=0; j<VectLen; j++) Tmp[j] = d[ColOf[j]-1];
+    return Tmp;
+  }
+  f = (float *)Strm.v + i * FileCols;
+  if (ColOf) for (j=0; j<VectLen; j++) Tmp[j] = f[ColOf[j]-1];
+  else for (j=0; j<VectLen; j++) Tmp[j] = f[j];
+  return Tmp;
+}
+
+/*---------------------------------------------------------------------------*/
+double *Data_Row(long i, double *Tmp)
+/* row i (zero based) of the data in either mode (see Stream_Row) */
+{
+  return StreamMode ? Stream_Row(i, Tmp) : XRow(i+1);
+}
+
+/*---------------------------------------------------------------------------*/
+double Sq_Dist(double *x, double *XBarJ, double *C, double *Dev)
+/* Mahalanobis_Dist for the row x, with the mean and inverse given */
+/* (Dev is left holding x - XBarJ) */
+{
+  double rowsum, RetVal = 0.;
+  int row, col;
+
+  for (col=1; col<=VectLen; col++) Dev[col-1] = x[col-1] - XBarJof(col);
+  for (row = 1; row <= VectLen; row++) {
+    rowsum = 0.;
+    for (col = 1; col <= VectLen; col++) rowsum += Dev[col-1] * C_1of(row,col);
+    RetVal += rowsum * Dev[row-1];
+  }
+  return RetVal;
+}
+
+/*---------------------------------------------------------------------------*/
+int Select_Bin(double d)
+/* histogram bin of a squared distance: 32 per octave from 2^-64 */
+{
+  int e, b;
+  double m = frexp(d, &e);       /* d = m 2^e, m in [.5,1) */
+
+  if (d <= 0.) return 0;
+  b = (e + 64) * 32 + (int)((2.*m - 1.) * 32.);
+  return b < 0 ? 0 : b >= SELECT_BINS ? SELECT_BINS-1 : b;
+}
+
+/*---------------------------------------------------------------------------*/
+double Stream_Select(long r)
+/* the r-th smallest (zero based) squared distance over all of the data, */
+/* from XBarJ with the inverse in C: one pass finds the histogram bin */
+/* holding it, a second keeps that bin's values and sorts them (if there */
+/* are too many it histograms the bin again and takes the midpoint of the */
+/* finer bin, which is within about 1e-6 of the value, relatively) */
+{
+  long *Hist, Before, Got = 0;
+  double *Keep = NULL, Lo, Hi, RetVal;
+  int b, Pass;
+
+  Hist = malloc(SELECT_BINS*sizeof(long)); ALLCHK(Hist)
+  Lo = Hi = 0.; b = -1;
+  for (Pass=1; Pass<=2; Pass++) {
+    memset(Hist, 0, SELECT_BINS*sizeof(long));
+#   pragma omp parallel copyin(MO_STATE)
+    {
+      long *Local, i, Part, j;
+      double *Dev, *Tmp, d;
+      int Bin;
+
+      Local = calloc(SELECT_BINS, sizeof(long)); REGION_ALLCHK(Local)
+      Dev = malloc(VectLen*sizeof(double)); REGION_ALLCHK(Dev)
+      Tmp = malloc(VectLen*sizeof(double)); REGION_ALLCHK(Tmp)
+#     pragma omp for schedule(dynamic)
+      for (Part=0; Part<STREAM_PARTS; Part++)
+        if (!REGION_FAILED) for (i=PartFirst(Part); i<PartFirst(Part+1); i++) {
+          d = Sq_Dist(Stream_Row(i, Tmp), XBarJ, C, Dev);
+          Bin = Select_Bin(d);
+          if (Pass == 1) Local[Bin]++;
+          else if (Bin != b) continue;
+          else if (Keep) {
+#           pragma omp atomic capture
+            j = Got++;
+            Keep[j] = d;
+          } else {
+            Bin = (int)((d - Lo) / (Hi - Lo) * SELECT_BINS);
+            Local[Bin < 0 ? 0 : Bin >= SELECT_BINS ? SELECT_BINS-1 : Bin]++;
+          }
+        }
+#     pragma omp critical
+      if (!REGION_FAILED) for (j=0; j<SELECT_BINS; j++) Hist[j] += Local[j];
+      free(Local); free(Dev); free(Tmp);
+    }
+    Region_Check();
+    if (Pass == 2 && Keep) break;
+    for (Before = 0, b = 0; Before + Hist[b] <= r; b++) Before += Hist[b];
+    r -= Before;
+    if (Pass == 2) break;
+    Lo = ldexp(1. + (b % 32) / 32., b / 32 - 65);
+    Hi = ldexp(1. + (b % 32 + 1) / 32., b / 32 - 65);
+    if (Hist[b] <= SELECT_CAP) {
+      Keep = malloc(Hist[b]*sizeof(double)); ALLCHK(Keep)
+    }
+  }
+  if (Keep) {
+    qsort(Keep, Got, sizeof(double), Compare_doubles);
+    RetVal = Keep[r];
+    free(Keep);
+  } else RetVal = Lo + (b + .5) * (Hi - Lo) / SELECT_BINS;
+  free(Hist);
+  return RetVal;
+}
+
+/*---------------------------------------------------------------------------*/
+double Stream_k()
+/* Compute_k over all of the data */
+{
+  return sqrt(Stream_Select((Strm.n+VectLen+1)/2)) / M;
+}
+
+/*---------------------------------------------------------------------------*/
+void Near_Add(double *D, long *I, int *Cnt, int K, double d, long i)
+/* keep the K smallest d seen (ascending in D, their rows in I) */
+{
+  int j;
+
+  if (*Cnt == K && d >= D[K-1]) return;
+  j = *Cnt < K ? (*Cnt)++ : K-1;
+  for (; j > 0 && D[j-1] > d; j--) {D[j] = D[j-1]; I[j] = I[j-1];}
+  D[j] = d; I[j] = i;
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_Nearest(int K, long *Near)
+/* the K rows (K <= XCnt) nearest XBarJ, with the inverse in C */
+{
+  double *D;
+  int Cnt = 0;
+
+  D = malloc(K*sizeof(double)); ALLCHK(D)
+# pragma omp parallel copyin(MO_STATE)
+  {
+    double *LD, *Dev, *Tmp;
+    long *LI, i, Part;
+    int LCnt = 0, j;
+
+    LD = malloc(K*sizeof(double)); REGION_ALLCHK(LD)
+    LI = malloc(K*sizeof(long)); REGION_ALLCHK(LI)
+    Dev = malloc(VectLen*sizeof(double)); REGION_ALLCHK(Dev)
+    Tmp = malloc(VectLen*sizeof(double)); REGION_ALLCHK(Tmp)
+#   pragma omp for schedule(dynamic)
+    for (Part=0; Part<STREAM_PARTS; Part++)
+      if (!REGION_FAILED) for (i=PartFirst(Part); i<PartFirst(Part+1); i++)
+        Near_Add(LD, LI, &LCnt, K, Sq_Dist(Stream_Row(i, Tmp), XBarJ, C, Dev), i);
+#   pragma omp critical
+    if (!REGION_FAILED) for (j=0; j<LCnt; j++) Near_Add(D, Near, &Cnt, K, LD[j], LI[j]);
+    free(LD); free(LI); free(Dev); free(Tmp);
+  }
+  Region_Check();
+  free(D);
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_Moments(double *OldBar, double *OldC, double Oldk, double k,
+                    double Lo, double Hi)
+/* one pass over the data, from XBarJ with the inverse in C, leaving */
+/* weighted sums about XBarJ in Strm: for k > 0 the weights are the M */
+/* iteration's, w(d/k), and MaxWDelta compares them with those from */
+/* OldBar, the inverse in OldC and Oldk (or with ones, if OldBar is NULL); */
+/* for k = 0 the weight is one for squared distances in (Lo, Hi), else 0 */
+{
+  int p = VectLen;
+  double AllSumw = 0., AllSumv = 0., AllMax = 0.;  /* Strm is thread */
+  long AllCnt = 0;                                 /* local (TLS) */
+
+  memset(Strm.Sx, 0, p*sizeof(double));
+  memset(Strm.Sxx, 0, p*p*sizeof(double));
+# pragma omp parallel copyin(MO_STATE)
+  {
+    double *Dev, *Tmp, *Sx, *Sxx, *x, d, wt, Old;
+    double Sumw, Sumv, MaxWDelta;
+    long i, Part, Cnt;
+    int j, l;
+
+    Dev = malloc(p*sizeof(double)); REGION_ALLCHK(Dev)
+    Tmp = malloc(p*sizeof(double)); REGION_ALLCHK(Tmp)
+    Sx = malloc(p*sizeof(double)); REGION_ALLCHK(Sx)
+    Sxx = malloc(p*p*sizeof(double)); REGION_ALLCHK(Sxx)
+#   pragma omp for ordered schedule(dynamic)
+    for (Part=0; Part<STREAM_PARTS; Part++) {
+      if (REGION_FAILED) continue;
+      Sumw = Sumv = MaxWDelta = 0.; Cnt = 0;
+      memset(Sx, 0, p*sizeof(double));
+      memset(Sxx, 0, p*p*sizeof(double));
+      for (i=PartFirst(Part); i<PartFirst(Part+1); i++) {
+        x = Stream_Row(i, Tmp);
+        if (k > 0.) {
+          Old = OldBar ? w(sqrt(Sq_Dist(x, OldBar, OldC, Dev)) / Oldk) : 1.;
+          d = Sq_Dist(x, XBarJ, C, Dev);
+          wt = w(sqrt(d) / k);
+          Sumv += wt * d / (k*k);
+          if (dabs(wt - Old) > MaxWDelta) MaxWDelta = dabs(wt - Old);
+        } else {
+          d = Sq_Dist(x, XBarJ, C, Dev);
+          wt = (d > Lo && d < Hi) ? 1. : 0.;
+        }
+        if (wt == 0.) continue;
+        Cnt++; Sumw += wt;
+        for (j=0; j<p; j++) {
+          Sx[j] += wt * Dev[j];
+          for (l=0; l<=j; l++) Sxx[j*p+l] += wt * Dev[j] * Dev[l];
+        }
+      }
+#     pragma omp ordered
+      {
+        AllSumw += Sumw; AllSumv += Sumv; AllCnt += Cnt;
+        if (MaxWDelta > AllMax) AllMax = MaxWDelta;
+        for (j=0; j<p; j++) Strm.Sx[j] += Sx[j];
+        for (j=0; j<p*p; j++) Strm.Sxx[j] += Sxx[j];
+      }
+    }
+    free(Dev); free(Tmp); free(Sx); free(Sxx);
+  }
+  Region_Check();
+  Strm.Sumw = AllSumw; Strm.Sumv = AllSumv;
+  Strm.MaxWDelta = AllMax; Strm.Cnt = AllCnt;
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_Estimate(double Scale)
+/* replace XBarJ and C by the weighted mean from the last Stream_Moments */
+/* and the weighted sums of squares about it over Scale */
+{
+  int i, j;
+
+  for (i=1; i<=VectLen; i++) {
+    for (j=1; j<=i; j++)
+      Cof(i,j) = (Strm.Sxx[(i-1)*VectLen+j-1]
+                  - Strm.Sx[i-1] * Strm.Sx[j-1] / Strm.Sumw) / Scale;
+  }
+  for (i=1; i<=VectLen; i++) for (j=i+1; j<=VectLen; j++) Cof(i,j) = Cof(j,i);
+  for (i=1; i<=VectLen; i++) XBarJof(i) += Strm.Sx[i-1] / Strm.Sumw;
+}
+
+/*---------------------------------------------------------------------------*/
+long Stream_Kept(double Cut)
+/* count the rows closer than Cut (squared), leaving their sums in Strm */
+{
+  Stream_Moments(NULL, NULL, 0., 0., -1., Cut);
+  return Strm.Cnt;
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_M_Iterate()
+/* M_Iterate over all of the data; the weights are not kept, so the last */
+/* iteration's are recomputed (from its mean, inverse and k) to test */
+/* convergence */
+{
+  double *OldBar, *OldC, Oldk = 0., k;
+  long siters=0;                    /* to time out on iterations */
+  int First = True;
+
+  OldBar = malloc(VectLen*sizeof(double)); ALLCHK(OldBar)
+  OldC = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(OldC)
+  do {
+    InvertC(C, VectLen, &Determinant);
+    if (Determinant <= 0.0) {
+      printf("Singular Covariance matrix\n");
+      printf("Determinant = %E\n", Determinant);
+      printf("End of zero determinant dump from Stream_M_Iterate\n");
+      exit(1);
+    }
+    k = Stream_k();
+    Stream_Moments(First ? NULL : OldBar, OldC, Oldk, k, 0., 0.);
+    memcpy(OldBar, XBarJ, VectLen*sizeof(double));
+    memcpy(OldC, C, VectLen*VectLen*2*sizeof(double));
+    Oldk = k; First = False;
+    Sumw = Strm.Sumw; Sumv = Strm.Sumv;
+    Stream_Estimate(Sumv / VectLen);
+    if (siters++ > (long)(1./(float)WTOL)) {
+      printf("Time out in M convergence, MaxWDelta = %lf, WTOL = %lf\n",
+             Strm.MaxWDelta, WTOL);
+      break;
+    }
+  } while (Strm.MaxWDelta > WTOL); /* wgts converge */
+  free(OldBar); free(OldC);
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_Forward()
+/* Forward over all of the data: the nearest p+1 .. 2p rows are fetched */
+/* into XJ; the half sample is not formed, its sums come from a pass */
+{
+  long *Near;
+  double *x, Lo;
+  int JCnt, i;
+
+  Near = malloc(2*VectLen*sizeof(long)); ALLCHK(Near)
+  for (JCnt=VectLen+1; JCnt <= 2*VectLen && JCnt <= XCnt; JCnt++) {
+    InvertC(C, VectLen, &Determinant);
+    Stream_Nearest(JCnt, Near);
+    for (i=0; i<JCnt; i++)
+      if ((x = Stream_Row(Near[i], XJ+i*VectLen)) != XJ+i*VectLen)
+        memcpy(XJ+i*VectLen, x, VectLen*sizeof(double));
+    Compute_XBarJ(JCnt);
+    Form_C(JCnt);
+  }
+  /* fill to half sample: ranks 1 to n/2, as Forward does */
+  InvertC(C, VectLen, &Determinant);
+  Lo = Stream_Select(0);
+  Stream_Moments(NULL, NULL, 0., 0., Lo,
+                 nextafter(Stream_Select(Strm.n/2), HUGE_VAL));
+  Stream_Estimate((double)(Strm.Cnt - 1));
+  free(Near);
+}
+
+/*---------------------------------------------------------------------------*/
+long Stream_Perm(long i)
+/* a keyed bijection of the row indexes 0..n-1: a four round Feistel */
+/* network (Philox rounds, stream space RS_PERM) on 2*Half bits, followed */
+/* along its cycle until it lands below n; cells are then random samples */
+/* without an n long permutation vector */
+{
+  struct RStream R;
+  uint32_t Out[4];
+  uint64_t L, Rt, t, Mask = ((uint64_t)1 << Strm.Half) - 1;
+  int Round;
+
+  do {
+    L = (uint64_t)i >> Strm.Half; Rt = (uint64_t)i & Mask;
+    for (Round=0; Round<4; Round++) {
+      RS_Init(&R, SeedSave, RS_PERM, (uint32_t)Round);
+      R.Ctr = Rt;
+      Philox_Blocks(Out, 1, &R);
+      t = L ^ ((Out[0] | (uint64_t)Out[1] << 32) & Mask);
+      L = Rt; Rt = t;
+    }
+    i = (long)(L << Strm.Half | Rt);
+  } while (i >= Strm.n);
+  return i;
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_Cells()
+/* size the cells as Search_Partitions will and make room in X for one */
+{
+  if ((Strm.Parts = Strm.n / Lambda) <= 0) Strm.Parts = 1;
+  XCnt = (int)(Strm.n / Strm.Parts);
+  X = malloc((size_t)XCnt*VectLen*sizeof(double)); ALLCHK(X)
+  Strm.Cells = StreamCells ? StreamCells : STREAM_CELLS;
+  if (Strm.Cells > Strm.Parts) Strm.Cells = Strm.Parts;
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_Load_Cell(long Part)
+/* read cell Part (rows Part*XCnt .. of the permutation) into X */
+{
+  double *x;
+  int j;
+
+# pragma omp parallel for private(x) copyin(MO_STATE)
+  for (j=1; j<=XCnt; j++)
+    if ((x = Stream_Row(Stream_Perm(Part*XCnt + j-1), XRow(j))) != XRow(j))
+      memcpy(XRow(j), x, VectLen*sizeof(double));
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_List(FILE *f)
+/* the distance listing of Write_Final_Results, STREAM_ROWS at a time */
+{
+  double *Dist;
+  long First;
+  int Cnt, j;
+
+  Dist = malloc(STREAM_ROWS*sizeof(double)); ALLCHK(Dist)
+  for (First=0; First<Strm.n; First+=STREAM_ROWS) {
+    Cnt = Strm.n - First < STREAM_ROWS ? (int)(Strm.n - First) : STREAM_ROWS;
+#   pragma omp parallel copyin(MO_STATE)
+    {
+      double *Dev, *Tmp;
+      int i;
+
+      Dev = malloc(VectLen*sizeof(double)); REGION_ALLCHK(Dev)
+      Tmp = malloc(VectLen*sizeof(double)); REGION_ALLCHK(Tmp)
+#     pragma omp for
+      for (i=0; i<Cnt; i++)
+        if (!REGION_FAILED) Dist[i] = Sq_Dist(Stream_Row(First+i, Tmp), XBarJ, C, Dev);
+      free(Dev); free(Tmp);
+    }
+    Region_Check();
+    for (j=0; j<Cnt; j++) Put_Point(f, First+j+1, Dist[j], Dist[j] >= FinalCut, 1);
+  }
+  free(Dist);
+}
+
+/*---------------------------------------------------------------------------*/
+void Stream_Echo(FILE *f)
+/* the data echo of Write_Final_Results: with -echo a copy of the input */
+/* file (already a binary matrix), else text a row at a time */
+{
+  FILE *g;
+  double *Tmp;
+  char *Line;
+  long i;
+
+  if (EchoFile) {                 /* all of the file's columns */
+    if ((g = fopen(EchoFile, "wb")) == NULL
+        || fwrite(Strm.Buf, 1, Strm.Len, g) != Strm.Len || fclose(g)) {
+      printf("Could not write %s\n", EchoFile);
+      exit(1);
+    }
+    fprintf(f,"\n\nComplete, Original Data: in %s (binary matrix)\n", EchoFile);
+    return;
+  }
+  Tmp = malloc(VectLen*sizeof(double)); ALLCHK(Tmp)
+  Line = malloc(ROW_CHARS); ALLCHK(Line)
+  fprintf(f,"\n\nComplete, Original Data:\n");
+  for (i=0; i<Strm.n; i++) Put_Row(f, Stream_Row(i, Tmp), Line);
+  free(Tmp); free(Line);
+}
+#undef PartFirst
+
+/*---------------------------------------------------------------------------*/
+void Keep_Fit()
+/* FitC: the scatter in C, which is about to be inverted for distances */
+{
+  int row, col;
+
+  if (!FitC) {FitC = malloc(VectLen*VectLen*sizeof(double)); ALLCHK(FitC)}
+  for (row=1; row<=VectLen; row++) for (col=1; col<=VectLen; col++)
+    FitC[(row-1)*VectLen + col-1] = Cof(row,col);
+}
+
+/*---------------------------------------------------------------------------*/
+float ID_Good(double CutPt1, float a1, float a2)
+/* on input, the distance vector must be ready to use */
+/* on output, set JBits set for nominally good points */
+/* return the cutoff distance */
+/* do a two step using a1 and a2 as fraction to reject; CutPt1 is the */
+/* first stage cutoff for a1 (from Rej_Cutoff) */
+/* in stream mode there are no distance vector or JBits: the distances */
+/* are recomputed in passes, and Strm keeps the sums of the points kept */
+/* the M-estimate (XBarJ and C with its inverse) is kept in MBar and MC, */
+/* with its scatter (from FitC) in MFit, and the scatter the final */
+/* distances are from in FitC */
+{
+  double CutPt2;  // cutoff for sq dist
+  int i;          // index
+  long n;         // temp data size
+
+  MBar = malloc(VectLen*sizeof(double)); ALLCHK(MBar)
+  MC = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(MC)
+  memcpy(MBar, XBarJ, VectLen*sizeof(double));
+  memcpy(MC, C, VectLen*VectLen*2*sizeof(double));
+  MFit = malloc(VectLen*VectLen*sizeof(double)); ALLCHK(MFit)
+  memcpy(MFit, FitC, VectLen*VectLen*sizeof(double));
+  FirstCut = CutPt1;
+  if (CutMode == CHECK && CallLog) Report_Approx_Check(CallLog);
+  n = 0;
+  if (StreamMode) n = Stream_Kept(CutPt1);
+  else for (i=0; i<XCnt; i++) 
+    if (SqResiduals[i] < CutPt1) {JBits[i] = 1; ++n;}
+    else JBits[i]=0;
+  if (Trace) printf("first cut uses %E and leaves %ld\n",CutPt1, n);
+  if (n <= VectLen) {
+    printf("Warning: too few points kept with cutoff fraction %f\n", a1);
+  } else if (StreamMode) {
+    Stream_Estimate((double)(n - 1));
+    Keep_Fit();
+    InvertC(C, VectLen, &Determinant);
+  } else {
+    Form_XJ();
+    Compute_XBarJ(n);
+    Form_C(n);
+    Keep_Fit();
+    InvertC(C, VectLen, &Determinant);
+    Compute_Distance_Vector();
+  } 
+  CutPt2 = ChiSq_1(VectLen, ((float)1.-a2));
+  CutPt2 
+    /= ChiSq(VectLen+2, 
+       ChiSq_1(VectLen, (float)(1.-a1)), (float)0.001)/(float)(1.-a1);
+  n = 0;
+  FinalCut = CutPt2;
+  if (StreamMode) n = Stream_Kept(CutPt2);
+  else for (i=0; i<XCnt; i++) {
+    if (Trace) printf("%d %f\n",i,(float)SqResiduals[i]);
+    if (SqResiduals[i] < CutPt2) {JBits[i] = 1; ++n;}
+    else JBits[i]=0;
+  }
+  if (Trace) printf("second cut uses %E and leaves %ld\n",CutPt2, n);
+  if (n <= VectLen) {
+    printf("WARNING: Too few points kept with cutoff fraction %f\n", a2);
+  }
+  return (float)CutPt2;
+}
+
+/*---------------------------------------------------------------------------*/
+double Comp_uAu(int uInd)
+/* to get give the determint multiplier
+   assume that the inverse of A is available
+   see Hawkins FSA paper for notation
+   As of Jan 27, 1994:
+*/
+{
+    double uau=0;                 /* intermediate vector x inverse prods */
+    double rowsumau;              /* to accumulate rightmost mult first */
+			          /* (row and col refer to c inverse) */
+    int p1, locuInd;
+    double *locA1Start;
+    int i,j;
+#define uauZof(i,j) (j==1 ? 1 : Xof(i,j-1))  /* inefficient */
+/*
+    for (row = 1; row <= VectLen+1; row++) {
+	rowsumau = A_1of(row,1);
+	for (col = 2; col <= VectLen+1; col++) {
+	    rowsumau += A_1of(row,col) * Xof(uInd,col-1);
+	}
+	uau += rowsumau * uauZof(uInd, row);       
+    }
+*/
+/* dangerous speed ups */
+locA1Start = A+(VectLen+1)*(VectLen+1);
+locuInd = uInd - 1;
+p1 = VectLen+1;
+#define locA1(i,j) *(locA1Start+i+j*p1)
+    for (i=0; i <= VectLen; i++) {
+        rowsumau = locA1(i,0);
+        for (j=1; j<=VectLen; j++) 
+            rowsumau += locA1(i,j) * *(X+locuInd*VectLen + j-1);
+	uau += rowsumau * uauZof(uInd, i+1);       
+    }
+    return(uau * Freqof(uInd));   /* for the row scaled as in ZJ */
+}
+#undef uauZof
+
+/*---------------------------------------------------------------------------*/
+double Swap_Fact(int GoodOut, int BadIn)
+/* give the determint multiplier that results from
+   taking goodout out of J and BadIn into J (less than one is good)
+   assume that the inverse of A is available
+   see Hawkins page 8 for notation
+*/
+#define Zof(i,j) (j==1 ? 1 : Xof(i,j-1)) /* inefficient */
+{
+    double retval;                /* for debugging */
+    double a1;                    /* avoid address calc */
+    double uau=0, vav=0, uav=0;   /* itermediate vector x inverse prods */
+    double rowsumav, rowsumau;    /* to accumulate rightmost mult first */
+    int row, col;	          /* indexes for vector matrix mult. */
+			          /* (row and col refer to c inverse) */
+
+    /* use Z (not X or ZJ) */
+    for (row = 1; row <= VectLen+1; row++) {
+	rowsumav = rowsumau = 0.;
+	for (col = 1; col <= VectLen+1; col++) {
+	    rowsumau += (a1=A_1of(row,col)) * Zof(GoodOut,col);
+	    rowsumav += a1 * Zof(BadIn,col);
+	}
+	uau += rowsumau * Zof(GoodOut, row);       
+	vav += rowsumav * Zof(BadIn, row);
+        uav += rowsumav * Zof(GoodOut, row);
+    }
+    if (Freq) {                   /* the rows as scaled in ZJ */
+        uau *= Freqof(GoodOut); vav *= Freqof(BadIn);
+        uav *= sqrt((double)Freqof(GoodOut) * Freqof(BadIn));
+    }
+    retval = (1-uau)*(1+vav) + (uav)*(uav);
+    return(retval);
+}
+#undef Zof
+/*---------------------------------------------------------------------------*/
+int Find_Best_Descent(int JCnt, int *GoodOut, int *BadIn)
+/* return false if there is not descent possible */
+/* uses sub string lists */
+/* return pointers to the best guys to move */
+/* A had better correspond to X  */
+/* This is way too messy.... */
+{
+    int OPos, ZPos;  /* to loop through substring lists */
+    double BestMoveFact=1.;  /* to find best (1. not HUGE_VAL....)*/
+    double MF;       /* avoid extra calls */
+    double Sc = 1.;  /* with weights, the change in det(A/JWt) for JWt */
+    int i;
+
+    for (i=1; i<=XCnt; i++) uAu[i] = Comp_uAu(i);
+
+    for (OPos=0; OPos < JCnt; OPos++) {
+        for (ZPos=0; ZPos < XCnt - JCnt; ZPos++) {
+          if (Freq)
+            Sc = pow(JWt / (JWt - Freqof(*(OnesList+OPos)+1)
+                            + Freqof(*(ZerosList+ZPos)+1)), (double)(VectLen+1));
+          if (Sc * (1-uAu[*(OnesList+OPos)+1]) * (1+uAu[*(ZerosList+ZPos)+1])
+            < BestMoveFact) {
+            /* calling the entire Swap_Fact is a slight waste of time... */
+            if ((MF = Sc * Swap_Fact(*(OnesList+OPos)+1, *(ZerosList+ZPos)+1))
+                 < BestMoveFact) {
+                BestMoveFact = MF;
+                *GoodOut = *(OnesList+OPos)+1;
+                *BadIn = *(ZerosList+ZPos)+1;
+                if (Trace) printf("%d out, %d in is current best\n",
+                           *(OnesList+OPos)+1, *(ZerosList+ZPos)+1);
+	    }
+          }
+        }
+    }
+    if (Trace) printf("Best Move has MF=%E\n", BestMoveFact);
+    if (BestMoveFact < 1.) return(True); else return(False);
+}
+
+/*-------------------------------------------------------------------------*/
+void Do_One_Descent(int JCnt)
+/* simple descent to a local min */
+{
+    int GoodOut, BadIn;        /* to swap */
+
+    while (Find_Best_Descent(JCnt, &GoodOut, &BadIn)) {
+        *(JBits+GoodOut-1) = 0; *(JBits+BadIn-1) = 1;
+        if (Trace) printf("swap %d %d %E\n", GoodOut, BadIn, Determinant);
+        Create_SubString_Lists(JCnt);  /* could update ...*/
+        Process_JBits(JCnt);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+void Get_XBarJ(int JCnt, double *XBarJ)
+/* x bar for the current J set, using only local variables (except J) */
+/* perhaps used by ghost image programs */
+{
+   int row, col;     /* to loop */
+   
+    for (col=1; col<=VectLen; col++) {
+	XBarJof(col) = 0.;
+	for (row=1; row<=XCnt; row++) 
+            if (*(JBits+row-1)) XBarJof(col) += Xof(row,col);
+	XBarJof(col) /=  JCnt;
+    }
+}
+
+#define T_T FLT_EPSILON
+/*-------------------------------------------------------------------------*/
+int Lex_Compare_Data_Recs(const void *arg1, const void *arg2)
+/* compare *arg1 and *arg2 as per qsort needs */
+/* assume that doubles can never really be equal */
+{
+  int i;
+  for (i=0; i<VectLen; i++) {
+    if (*((double *)arg1+i) < *((double *)arg2+i)-T_T) return(-1); 
+    if (*((double *)arg1+i) > *((double *)arg2+i)+T_T) return(1); 
+  }
+  return(0);
+}
+
+/*-------------------------------------------------------------------------*/
+/* duplicates are found by hashing: each coordinate is rounded to a grid */
+/* (offset by half a cell, so that values with few fraction bits sit mid */
+/* cell) and a row goes in the bucket of its cells; two rows within T_T of */
+/* each other can differ by one cell only in coordinates within T_T of a */
+/* cell edge, so a row probes every mix of its own and the neighbouring */
+/* cells on those (almost always just one). A column has DUP_SCALE cells */
+/* per unit, or fewer (by powers of two, so the scaling is exact) if its */
+/* values would need more than DUP_CELLS cells; large values then keep */
+/* all their fraction bits, and are near an edge only when they really */
+/* are within T_T of one */
+#define DUP_SCALE 8192.
+#define DUP_CELLS 1099511627776. /* 2^40 */
+#define DUP_EDGES 16            /* more edges than this: scan the rows */
+
+uint64_t Dup_Cell(int j, double q)
+/* the hash of cell q of coordinate j (splitmix64's finalizer) */
+{
+  uint64_t h;
+
+  q += 0.;                      /* no -0 */
+  memcpy(&h, &q, sizeof(h));
+  h ^= (uint64_t)(j + 1) * 0x9E3779B97F4A7C15ULL;
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+  return h ^ (h >> 31);
+}
+
+/*-------------------------------------------------------------------------*/
+uint64_t Dup_Hash(double *x, double *Cells, uint64_t *Delta, int *Edges)
+/* the bucket hash of row x, with Cells[j] cells per unit in coordinate */
+/* j; for each coordinate near a cell edge, Delta gets what moving to the */
+/* neighbouring cell adds to the hash */
+{
+  uint64_t h = 0, c;
+  double q, t, Near;
+  int j;
+
+  *Edges = 0;
+  for (j=0; j<VectLen; j++) {
+    t = x[j] * Cells[j] + .5;
+    q = floor(t);
+    h += (c = Dup_Cell(j, q));
+    t -= q;
+    Near = 2. * T_T * Cells[j];         /* with room for rounding */
+    if (t < Near) Delta[(*Edges)++] = Dup_Cell(j, q - 1.) - c;
+    else if (1. - t < Near) Delta[(*Edges)++] = Dup_Cell(j, q + 1.) - c;
+  }
+  return h;
+}
+
+/*-------------------------------------------------------------------------*/
+void Collapse_X(int *Dup, int *Row)
+/* replace the rows of X that Dup (from Pre_Check_Data) says repeat an */
+/* earlier row by a count in Freq for that row; X keeps the first of each */
+/* in place, in data order; Row is XCnt ints of work space */
+{
+  int i, u = 0;
+
+  Freq = malloc(XCnt*sizeof(int)); ALLCHK(Freq)
+  RowOf = malloc(XCnt*sizeof(int)); ALLCHK(RowOf)
+  for (i=0; i<XCnt; i++) {
+    if (Dup[i] >= 0) {          /* Row[Dup[i]] is already set */
+      Freq[Row[i] = Row[Dup[i]]]++;
+      continue;
+    }
+    if (u < i) memcpy(XRow(u+1), XRow(i+1), VectLen*sizeof(double));
+    Freq[u] = 1; RowOf[u] = i+1;
+    Row[i] = u++;
+  }
+  NPoints = XCnt;
+  if (u < XCnt) printf("%d duplicate points collapsed: %d distinct rows\n",
+                       XCnt - u, u);
+  XCnt = u;
+}
+
+/*-------------------------------------------------------------------------*/
+void Pre_Check_Data()
+/* this routine checks X for duplicates */
+/* if any are found, it gripes and dies (with -collapse, see Collapse_X) */
+/* a row is reported if an earlier one matches it, so X is left alone */
+{
+  uint64_t *Hash, Mask;
+  int *Head, *Next;
+  int *Dup;                             /* an earlier match, or -1 */
+  double *Cells;                        /* grid cells per unit, by column */
+  int i, j, Buckets;
+  int Duds = False;
+
+  for (Buckets=1; Buckets < 2*XCnt; Buckets *= 2);
+  Mask = Buckets - 1;
+  Cells = malloc(VectLen*sizeof(double)); ALLCHK(Cells)
+  for (j=1; j<=VectLen; j++) {
+    double Big = 0.;
+
+    for (i=1; i<=XCnt; i++) if (dabs(Xof(i,j)) > Big) Big = dabs(Xof(i,j));
+    for (Cells[j-1] = DUP_SCALE;
+         Big * Cells[j-1] > DUP_CELLS && Cells[j-1] > 1e-300;
+         Cells[j-1] /= 2.);
+  }
+  Hash = malloc(XCnt*sizeof(uint64_t)); ALLCHK(Hash)
+  Head = malloc(Buckets*sizeof(int)); ALLCHK(Head)
+  Next = malloc(XCnt*sizeof(int)); ALLCHK(Next)
+  Dup = malloc(XCnt*sizeof(int)); ALLCHK(Dup)
+# pragma omp parallel copyin(MO_STATE)
+  {
+    uint64_t *Delta;
+    int e;
+
+    Delta = malloc(VectLen*sizeof(uint64_t)); REGION_ALLCHK(Delta)
+#   pragma omp for schedule(static)
+    for (i=0; i<XCnt; i++)
+      if (!REGION_FAILED) Hash[i] = Dup_Hash(XRow(i+1), Cells, Delta, &e);
+#   pragma omp for schedule(static)
+    for (i=0; i<Buckets; i++) Head[i] = -1;
+#   pragma omp single
+    for (i=0; i<XCnt && !REGION_FAILED; i++) {
+      Next[i] = Head[Hash[i] & Mask];
+      Head[Hash[i] & Mask] = i;
+    }
+#   pragma omp for schedule(dynamic, 1024)
+    for (i=0; i<XCnt; i++) {
+      uint64_t h, s;
+      int r, k;
+
+      Dup[i] = -1;
+      if (REGION_FAILED) continue;
+      Dup_Hash(XRow(i+1), Cells, Delta, &e);
+      if (e > DUP_EDGES) {
+        for (r=0; r<i && Dup[i] < 0; r++)
+          if (!Lex_Compare_Data_Recs(XRow(r+1), XRow(i+1))) Dup[i] = r;
+        continue;
+      }
+      for (s=0; s < (1ULL << e) && Dup[i] < 0; s++) {
+        h = Hash[i];
+        for (k=0; k<e; k++) if (s >> k & 1) h += Delta[k];
+        for (r=Head[h & Mask]; r >= 0; r=Next[r])
+          if (r < i && Hash[r] == h
+              && !Lex_Compare_Data_Recs(XRow(r+1), XRow(i+1))) {
+            Dup[i] = r;
+            break;
+          }
+      }
+    }
+    free(Delta);
+  }
+  Region_Check();
+
+  if (Collapse) {
+    Collapse_X(Dup, Next);
+    free(Hash); free(Head); free(Next); free(Dup); free(Cells);
+    return;
+  }
+  for (i=1; i<=XCnt; i++) {
+    if (Dup[i-1] >= 0) {
+       if (!Duds) printf("\nERROR: Duplicate points\n");
+       Duds = True;
+       for (j=1; j<=VectLen; j++) printf("%lf ",Xof(i,j));
+       printf("\n");
+    }
+  }
+  if (Duds) {
+    printf("The program will terminate due to duplicate points.\n");
+    printf("If a point was included r times, it was displayed r-1 times.\n");
+    printf("The tolerance used in duplicate detections was %E\n",
+           (double)T_T);
+    exit(1);
+  }
+  free(Hash); free(Head); free(Next); free(Dup); free(Cells);
+}
+#undef DUP_SCALE
+#undef DUP_CELLS
+#undef DUP_EDGES
+#undef T_T
+
+/*-------------------------------------------------------------------------*/
+void Use_Algo_Rej_Code(struct SimSpace *S)
+/* the estimator used on the simulated samples */
+{
+  Space_M_Iterate(S);
+}
+
+/*----------------------------------------------------------------------------*/
+void Parms_Help(char *S)
+{
+  printf("\nThere was an error reading parameters from the file %s\n",S);
+  printf("The file should contain the partition multiplier (e.g. 5)\n");
+  printf("  the trace level (e.g. 0), the cut fraction (e.g. 0.01)\n");
+  printf("  and the simulation tolerance (e.g. 0.5)\n");
+  printf("Sample Contents:\n 5 0 0.01 0.5\n");  
+  exit(1);
+}
+
+/*----------------------------------------------------------------------------*/
+void Set_Default_Parms()
+/* establish values for algorithm parameters */
+{
+  Lambda = 5 * VectLen;
+  Trace = 0;
+  Cut1 = Cut2 = (float)0.01;
+  SimTol = (float)0.5;
+  if (ParmsSet) {               /* see MO_Set_Parms */
+    if (SetLambda) Lambda = SetLambda;
+    Trace = SetTrace;
+    Cut1 = Cut2 = SetCut;
+    SimTol = SetSimTol;
+  }
+} 
+
+/*----------------------------------------------------------------------------*/
+void Dump_Parms(FILE *f)
+{
+    fprintf(f,"Lambda Multiplier: %d; Trace: %d; \n", Lambda/VectLen, Trace);
+    fprintf(f,"Cut Fraction: %f; Simulation Tolerance: %f\n", Cut2, SimTol);
+    if (CutPrec > 0.) 
+      fprintf(f,"Cutoff Precision Goal: %f (replaces the tolerance)\n", CutPrec);
+}
+ 
+/*----------------------------------------------------------------------------*/
+void Load_Parms(char *PARMSFILE)
+/* establish values for algorithm parameters */
+{
+    FILE *f;	   /* input file stream record pointer */
+    int LambdaMult; /* allow partition size to vary w/dimension */
+    int r;
+    float Cut;
+
+    if ((f = fopen(PARMSFILE,"r")) == NULL) {
+       printf("\nCould not open the parms file specified: %s\n\n",PARMSFILE);
+       Info_Exit();
+    }
+    r = fscanf(f,"%d %d %f %f", &LambdaMult, &Trace, &Cut, &SimTol);
+    if (r != 4) Parms_Help(PARMSFILE);
+
+    fclose(f);
+    if (LambdaMult < 3) {
+        printf("Lambda mult is %d, but should be > 2\n",LambdaMult);
+        Parms_Help(PARMSFILE);
+    }
+    if ((Cut < 0) || (Cut > 1)) {
+      printf("The cut parm was %f but it must be between 0 and 1\n",Cut);
+      Parms_Help(PARMSFILE);
+    }
+    if (SimTol <= (float)0.0) {
+      printf("The simulation tolerance must be greater than 0\n");
+      Parms_Help(PARMSFILE);
+    }
+    
+    Cut1 = Cut2 = Cut;
+    Lambda = LambdaMult * VectLen;
+}
+
+/*-------------------------------------------------------------------------*/
+void Forward(int *JCnt)
+/* similar to atkinson algorithm */
+/* NOTE: we stop at 2p */
+{
+    int i;		      /* index into vector being formed */
+
+    for (*JCnt=VectLen+1; *JCnt <= 2*VectLen; (*JCnt)++) {
+        InvertC(C, VectLen, &Determinant);
+        Compute_Distance_Vector();
+        for (i=0; i<XCnt; i++) {
+          (ResidRecs+i)->SqMahalDist = *(SqResiduals+i);
+	  (ResidRecs+i)->SampleNum = i;
+        }
+        qsort(ResidRecs, XCnt, sizeof(struct ResidRec), Compare_Resids);
+        memset(JBits, 0, XCnt*sizeof(int));
+        for (i=0; i<*JCnt; i++) *(JBits+(ResidRecs+i)->SampleNum) = 1;
+        Form_XJ();
+        Compute_XBarJ(*JCnt);
+        Form_C(*JCnt);
+    }
+    /* fill to half sample (not very efficient) */
+    *JCnt = BaseSubSampleSize;
+    memset(JBits, 0, XCnt*sizeof(int));
+    for (i=1; i<= *JCnt; i++) *(JBits+(ResidRecs+i)->SampleNum) = 1;
+    Form_XJ();
+    Compute_XBarJ(*JCnt);
+    Form_C(*JCnt);
+    Create_SubString_Lists(*JCnt);
+}
+
+/**************************************************************************/
+int Partition_Main(long LocalItersAllowed)
+{
+    long IterCntr=0;			       /* to count iterations */
+    int i,BitsInBest;			       /* find out how big winner is*/
+    int JCnt;				       /* variable sub-sample size*/
+
+    JCnt = BaseSubSampleSize;
+    Randomize_JBits(JCnt);	/* to make a best */
+    Process_JBits(JCnt);
+    Create_SubString_Lists(JCnt);
+    Record_Best();	/* a best */
+    for (i=0; i<LocalItersAllowed; i++) {
+	IterCntr++;
+	Do_One_Descent(JCnt);
+	if (Trace) printf("Descent %ld Results in %.3E\n", IterCntr, ObjectiveValue);
+        Randomize_JBits(JCnt);
+        Process_JBits(JCnt);
+        Create_SubString_Lists(JCnt);
+    }
+    Copy(JBits, BestJBits, XCnt);
+    BitsInBest = 0; for (i=0; i<XCnt; i++) if (*(BestJBits+i)) ++BitsInBest;
+    Form_XJ();
+    Compute_XBarJ(BitsInBest);
+    if (Trace) Dump_XBarJ("For Best SubSample in Partition");
+}
+
+/*------------------------------------------------------------------*/
+void Generate_Permutation(int N, int *p)
+/* generate permutation of length N in p */
+/* p is zero based, but the permutation is not */
+{
+    int i,j;				 /* to loop */
+    int lspot;				 /* offset in l */
+    int *FullList;			 /* unpermuted */
+    int *l; 				 /* left to be used */
+
+    FullList = malloc(N * sizeof(int));
+    ALLCHK(FullList)
+    for (i=0; i<N; i++) *(FullList+i) = i+1;
+    l = malloc(N * sizeof(int));
+    ALLCHK(l)
+
+    Copy(l, FullList, N);
+    for (i=0; i < N; i++) {
+	lspot = (int)(URan(&Rng) * (float)(N - i));
+	*(p+i) = *(l+lspot);
+	for (j=lspot; j<N-i-1; j++) *(l+j) = *(l+j+1);
+    }
+    free(l); free(FullList);
+}
+
+/*------------------------------------------------------------------*/
+/* compressed reports: a report named *.gz or *.zst is written through */
+/* zlib or zstd behind an ordinary FILE (fopencookie), so the fprintf */
+/* calls do not change; each open adds a gzip member or zstd frame, */
+/* which zcat and zstdcat read as one stream */
+#ifdef HAVE_ZLIB
+ssize_t Gz_Write(void *c, const char *b, size_t n)
+{
+   return n ? gzwrite((gzFile)c, b, (unsigned)n) : 0;
+}
+
+int Gz_Close(void *c)
+{
+   return gzclose((gzFile)c) == Z_OK ? 0 : EOF;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+struct ZsOut {
+   FILE *f;                   /* the file proper */
+   ZSTD_CStream *z;
+   char *Buf; size_t Cap;     /* compressed bytes on their way to f */
+};
+
+ssize_t Zs_Write(void *c, const char *b, size_t n)
+{
+   struct ZsOut *o = c;
+   ZSTD_inBuffer in;
+   ZSTD_outBuffer out;
+
+   in.src = b; in.size = n; in.pos = 0;
+   while (in.pos < in.size) {
+     out.dst = o->Buf; out.size = o->Cap; out.pos = 0;
+     if (ZSTD_isError(ZSTD_compressStream(o->z, &out, &in))
+         || fwrite(o->Buf, 1, out.pos, o->f) != out.pos) return 0;
+   }
+   return n;
+}
+
+int Zs_Close(void *c)
+{
+   struct ZsOut *o = c;
+   ZSTD_outBuffer out;
+   size_t r;
+   int Bad = False;
+
+   do {
+     out.dst = o->Buf; out.size = o->Cap; out.pos = 0;
+     r = ZSTD_endStream(o->z, &out);
+     if (ZSTD_isError(r) || fwrite(o->Buf, 1, out.pos, o->f) != out.pos) Bad = True;
+   } while (r > 0 && !Bad);
+   if (fclose(o->f)) Bad = True;
+   ZSTD_freeCStream(o->z); free(o->Buf); free(o);
+   return Bad ? EOF : 0;
+}
+#endif
+
+#define REPORT_BUF (1 << 20)            /* report output buffer */
+
+/*------------------------------------------------------------------*/
+int Has_Suffix(char *s, char *Suf)
+{
+   size_t l = strlen(s), m = strlen(Suf);
+
+   return l > m && !strcmp(s + l - m, Suf);
+}
+
+/*------------------------------------------------------------------*/
+FILE *Report_Stream(char *Name, char *Mode, char *Bin)
+/* open the report file, through zlib or zstd for *.gz or *.zst */
+{
+   if (Has_Suffix(Name, ".gz")) {
+#    ifdef HAVE_ZLIB
+       cookie_io_functions_t io = {NULL, Gz_Write, NULL, Gz_Close};
+       gzFile z;
+
+       if ((z = gzopen(Name, Bin)) == NULL) return NULL;
+       return fopencookie(z, Mode, io);
+#    else
+       printf("\n*error* %s: gzip output needs multout built with zlib\n\n", Name);
+       exit(1);
+#    endif
+   }
+   if (Has_Suffix(Name, ".zst")) {
+#    ifdef HAVE_ZSTD
+       cookie_io_functions_t io = {NULL, Zs_Write, NULL, Zs_Close};
+       struct ZsOut *o;
+
+       o = malloc(sizeof(*o)); ALLCHK(o)
+       if ((o->f = fopen(Name, Bin)) == NULL) {free(o); return NULL;}
+       o->z = ZSTD_createCStream(); ALLCHK(o->z)
+       ZSTD_initCStream(o->z, 3);
+       o->Cap = ZSTD_CStreamOutSize();
+       o->Buf = malloc(o->Cap); ALLCHK(o->Buf)
+       return fopencookie(o, Mode, io);
+#    else
+       printf("\n*error* %s: zstd output needs multout built with zstd\n\n", Name);
+       exit(1);
+#    endif
+   }
+   return fopen(Name, Mode);
+}
+
+/*------------------------------------------------------------------*/
+FILE *Report_Open(char *Name, char *Mode)
+/* fopen(Name, Mode) for the report ("w" or "a"), compressing by suffix */
+/* and with a large buffer; "-" is ReportOut, the original stdout */
+{
+   char Bin[3];
+   FILE *f;
+
+   if (!strcmp(Name, "-")) return ReportOut;
+   Bin[0] = Mode[0]; Bin[1] = 'b'; Bin[2] = 0;
+   if ((f = Report_Stream(Name, Mode, Bin)) != NULL)
+     setvbuf(f, NULL, _IOFBF, REPORT_BUF);
+   return OpenReport = f;   /* closed by Call_Leave if the run fails */
+}
+
+/*------------------------------------------------------------------*/
+void Report_Close(FILE *f)
+{
+   if (f == OpenReport) OpenReport = NULL;
+   if (f == ReportOut) fflush(f);
+   else if (fclose(f)) {
+     printf("Could not finish writing the report\n");
+     exit(1);
+   }
+}
+
+/*------------------------------------------------------------------*/
+/* the columnar result file (-results): a header, the M-estimate and */
+/* the final location and scatter, then one column per quantity, each */
+/* starting on an 8 byte boundary, so that it can be mapped and used */
+/* in place; values are in native byte order, like binary matrices */
+#define RES_MAGIC "MOUTRES1"
+#define RES_MBAR 0              /* Off[] entries: M-estimate location */
+#define RES_MCOV 1              /*   and scatter (p by p) */
+#define RES_BAR 2               /*   location and scatter the final */
+#define RES_COV 3               /*   distances are taken from */
+#define RES_INDEX 4             /*   uint64 point number (one based) */
+#define RES_DIST 5              /*   double squared distance */
+#define RES_WEIGHT 6            /*   double w(d/k) */
+#define RES_FLAG 7              /*   uint8 1: potential outlier */
+#define RES_J 8                 /*   uint8 1: in the first stage J set */
+#define RES_COLS 9
+struct ResHeader {
+  char Magic[8];                /* RES_MAGIC (no NUL) */
+  uint32_t Order;               /* MAT_ORDER */
+  uint32_t p;
+  uint64_t n;
+  int64_t Seed;                 /* SeedSave */
+  double FirstCut, FinalCut;    /* squared distance cutoffs */
+  double k;                     /* scale of the weights */
+  double Secs[4];               /* wall clock: load, search, cutoff, ID */
+  uint64_t Off[RES_COLS];       /* where each block starts */
+  char Pad[32];                 /* zero */
+};
+
+/*------------------------------------------------------------------*/
+double Wall()
+/* wall clock seconds, for the result file's timings */
+{
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/*------------------------------------------------------------------*/
+void Res_Put(int fd, char *Name, void *v, size_t Len, uint64_t At)
+/* write Len bytes of v at offset At of the result file */
+{
+   ssize_t r;
+
+   while (Len) {
+     if ((r = pwrite(fd, v, Len, (off_t)At)) <= 0) {
+       printf("Could not write %s\n", Name);
+       exit(1);
+     }
+     v = (char *)v + r; Len -= (size_t)r; At += (uint64_t)r;
+   }
+}
+
+/*------------------------------------------------------------------*/
+void Write_Results(char *Name)
+/* the result file for the final XBarJ and FitC and the M-estimate kept */
+/* by ID_Good (MBar and MFit); the distances use the inverses in C and */
+/* MC. The columns are filled STREAM_ROWS rows at a time, so this works */
+/* in stream mode too */
+{
+   struct ResHeader H;
+   double *Dist, *DistM, *Wt, k;
+   uint64_t *Ind, At;
+   unsigned char *Flag, *J;
+   long First, n = AllRows;
+   int fd, Cnt, i, p = VectLen;
+
+   k = StreamMode ? Stream_k() : Compute_k();
+   memset(&H, 0, sizeof(H));
+   memcpy(H.Magic, RES_MAGIC, 8);
+   H.Order = MAT_ORDER;
+   H.p = (uint32_t)p; H.n = (uint64_t)n;
+   H.Seed = (int64_t)SeedSave;
+   H.FirstCut = FirstCut; H.FinalCut = FinalCut; H.k = k;
+   memcpy(H.Secs, Secs, sizeof(H.Secs));
+   At = sizeof(H);
+   H.Off[RES_MBAR] = At; At += p * sizeof(double);
+   H.Off[RES_MCOV] = At; At += (uint64_t)p * p * sizeof(double);
+   H.Off[RES_BAR] = At; At += p * sizeof(double);
+   H.Off[RES_COV] = At; At += (uint64_t)p * p * sizeof(double);
+   H.Off[RES_INDEX] = At; At += n * sizeof(uint64_t);
+   H.Off[RES_DIST] = At; At += n * sizeof(double);
+   H.Off[RES_WEIGHT] = At; At += n * sizeof(double);
+   H.Off[RES_FLAG] = At; At += (n + 7) & ~7L;
+   H.Off[RES_J] = At;
+
+   if ((fd = open(Name, O_WRONLY|O_CREAT|O_TRUNC, 0644)) < 0) {
+     printf("Could not open %s for write\n", Name);
+     exit(1);
+   }
+   Res_Put(fd, Name, &H, sizeof(H), 0);
+   /* InvertC has reduced the left halves of C and MC, so the scatters */
+   /* come from the copies taken before it ran */
+   Res_Put(fd, Name, MBar, p * sizeof(double), H.Off[RES_MBAR]);
+   Res_Put(fd, Name, MFit, (size_t)p * p * sizeof(double), H.Off[RES_MCOV]);
+   Res_Put(fd, Name, XBarJ, p * sizeof(double), H.Off[RES_BAR]);
+   Res_Put(fd, Name, FitC, (size_t)p * p * sizeof(double), H.Off[RES_COV]);
+
+   Dist = malloc(STREAM_ROWS*sizeof(double)); ALLCHK(Dist)
+   DistM = malloc(STREAM_ROWS*sizeof(double)); ALLCHK(DistM)
+   Wt = malloc(STREAM_ROWS*sizeof(double)); ALLCHK(Wt)
+   Ind = malloc(STREAM_ROWS*sizeof(uint64_t)); ALLCHK(Ind)
+   Flag = malloc(STREAM_ROWS); ALLCHK(Flag)
+   J = malloc(STREAM_ROWS); ALLCHK(J)
+   for (First=0; First<n; First+=STREAM_ROWS) {
+     Cnt = n - First < STREAM_ROWS ? (int)(n - First) : STREAM_ROWS;
+#    pragma omp parallel copyin(MO_STATE)
+     {
+       double *Dev, *Tmp, *x;
+       int j;
+
+       Dev = malloc(p*sizeof(double)); REGION_ALLCHK(Dev)
+       Tmp = malloc(p*sizeof(double)); REGION_ALLCHK(Tmp)
+#      pragma omp for
+       for (j=0; j<Cnt; j++) {
+         if (REGION_FAILED) continue;
+         x = Data_Row(First+j, Tmp);
+         Dist[j] = Sq_Dist(x, XBarJ, C, Dev);
+         DistM[j] = Sq_Dist(x, MBar, MC, Dev);
+       }
+       free(Dev); free(Tmp);
+     }
+     Region_Check();
+     for (i=0; i<Cnt; i++) {
+       Ind[i] = (uint64_t)(Freq ? RowOf[First + i] : First + i + 1);
+       Wt[i] = w(sqrt(Dist[i]) / k);
+       Flag[i] = Dist[i] >= FinalCut;
+       J[i] = DistM[i] < FirstCut;
+     }
+     Res_Put(fd, Name, Ind, Cnt * sizeof(uint64_t), H.Off[RES_INDEX] + First * sizeof(uint64_t));
+     Res_Put(fd, Name, Dist, Cnt * sizeof(double), H.Off[RES_DIST] + First * sizeof(double));
+     Res_Put(fd, Name, Wt, Cnt * sizeof(double), H.Off[RES_WEIGHT] + First * sizeof(double));
+     Res_Put(fd, Name, Flag, Cnt, H.Off[RES_FLAG] + First);
+     Res_Put(fd, Name, J, Cnt, H.Off[RES_J] + First);
+   }
+   if (n % 8) {                     /* the padding after the last column */
+     memset(Flag, 0, 8);
+     Res_Put(fd, Name, Flag, 8 - n % 8, H.Off[RES_J] + n);
+   }
+   if (close(fd)) {
+     printf("Could not write %s\n", Name);
+     exit(1);
+   }
+   free(Dist); free(DistM); free(Wt); free(Ind); free(Flag); free(J);
+}
+
+/*------------------------------------------------------------------*/
+/* the model file (-model): what it takes to score new points as the */
+/* run scored its own, read back by MO_Read_Model */
+#define MOD_MAGIC "MOUTMOD1"
+#define MOD_MEAN 0              /* Off[] entries: location (p doubles) */
+#define MOD_SCATTER 1           /*   scatter (p by p doubles) */
+#define MOD_FACTOR 2            /*   its lower Cholesky factor (p by p) */
+#define MOD_COLS 3              /*   the file columns used (p uint32) */
+#define MOD_BLOCKS 4
+#define MOD_SOURCE 256
+struct ModHeader {
+  char Magic[8];                /* MOD_MAGIC (no NUL) */
+  uint32_t Order;               /* MAT_ORDER */
+  uint32_t p;
+  uint32_t FileCols;            /* columns in the data file */
+  uint32_t Pad0;                /* zero */
+  uint64_t n;                   /* points fitted */
+  int64_t Seed;                 /* SeedSave */
+  int64_t Iters;                /* ItersAllowed */
+  double Cut1, Cut2;            /* the cut fractions */
+  double FirstCut, FinalCut;    /* squared distance cutoffs (FinalCut flags) */
+  int64_t Time;                 /* when it was fitted (Unix seconds) */
+  uint64_t Off[MOD_BLOCKS];     /* where each block starts */
+  char Source[MOD_SOURCE];      /* the data file (NUL terminated) */
+  char Pad[8];                  /* zero */
+};
+
+/*------------------------------------------------------------------*/
+int Cholesky(double *S, double *L, int p)
+/* the lower L with S = L L' (both p by p, row major); False if S is */
+/* not positive definite */
+{
+   double Sum;
+   int i, j, k;
+
+   memset(L, 0, (size_t)p * p * sizeof(double));
+   for (j=0; j<p; j++) {
+     for (Sum = S[j*p+j], k=0; k<j; k++) Sum -= L[j*p+k] * L[j*p+k];
+     if (Sum <= 0.) return False;
+     L[j*p+j] = sqrt(Sum);
+     for (i=j+1; i<p; i++) {
+       for (Sum = S[i*p+j], k=0; k<j; k++) Sum -= L[i*p+k] * L[j*p+k];
+       L[i*p+j] = Sum / L[j*p+j];
+     }
+   }
+   return True;
+}
+
+/*------------------------------------------------------------------*/
+void Write_Model(char *Name, char *Source)
+/* the model of this run: XBarJ and FitC, which the final distances were */
+/* measured from, with the factor of FitC and the final cutoff */
+{
+   struct ModHeader H;
+   double *L;
+   uint32_t *Cols;
+   FILE *f;
+   int p = VectLen, j;
+
+   L = malloc((size_t)p*p*sizeof(double)); ALLCHK(L)
+   Cols = malloc((p+1)*sizeof(uint32_t)); ALLCHK(Cols)
+   if (!Cholesky(FitC, L, p)) {
+     printf("\n*error* the scatter matrix is not positive definite, so there\n");
+     printf("is no model to write\n\n");
+     exit(1);
+   }
+   for (j=0; j<=p; j++) Cols[j] = j < p ? (ColOf ? ColOf[j] : j+1) : 0;
+   memset(&H, 0, sizeof(H));
+   memcpy(H.Magic, MOD_MAGIC, 8);
+   H.Order = MAT_ORDER;
+   H.p = (uint32_t)p; H.FileCols = (uint32_t)FileCols;
+   H.n = (uint64_t)AllPoints; H.Seed = (int64_t)SeedSave;
+   H.Iters = (int64_t)ItersAllowed;
+   H.Cut1 = Cut1; H.Cut2 = Cut2;
+   H.FirstCut = FirstCut; H.FinalCut = FinalCut;
+   H.Time = (int64_t)time(NULL);
+   H.Off[MOD_MEAN] = sizeof(H);
+   H.Off[MOD_SCATTER] = H.Off[MOD_MEAN] + p * sizeof(double);
+   H.Off[MOD_FACTOR] = H.Off[MOD_SCATTER] + (uint64_t)p * p * sizeof(double);
+   H.Off[MOD_COLS] = H.Off[MOD_FACTOR] + (uint64_t)p * p * sizeof(double);
+   strncpy(H.Source, Source, MOD_SOURCE-1);
+   if ((f = fopen(Name, "wb")) == NULL
+       || fwrite(&H, sizeof(H), 1, f) != 1
+       || fwrite(XBarJ, sizeof(double), p, f) != (size_t)p
+       || fwrite(FitC, sizeof(double), (size_t)p*p, f) != (size_t)p*p
+       || fwrite(L, sizeof(double), (size_t)p*p, f) != (size_t)p*p
+       || fwrite(Cols, sizeof(uint32_t), (p+1) & ~1, f) != (size_t)((p+1) & ~1)
+       || fclose(f)) {
+     printf("Could not write %s\n", Name);
+     exit(1);
+   }
+   free(L); free(Cols);
+}
+
+/*------------------------------------------------------------------*/
+/* a model file in memory (MO_Read_Model); nothing in it changes once it */
+/* is read, so any number of threads can score against it */
+struct MO_Model {
+  struct ModHeader H;
+  char *Buf;                    /* the file */
+  double *Mean, *Scatter, *Factor;
+  uint32_t *Cols;               /*   (all pointing into Buf) */
+  double *W;                    /* the inverse of Factor (lower) */
+};
+#define SCORE_ROWS 8            /* rows Score_Rows takes together */
+#define SCORE_P 64              /*   and the p it keeps them on the stack for */
+#define SCORE_BLOCK 4096        /* rows a thread of Score_File takes */
+
+void Score_Rows(const struct MO_Model *Mod, const double *x, long n,
+                double *Dist, unsigned char *Flag);
+
+/*------------------------------------------------------------------*/
+void Score_File(struct MO_Model *Mod, char *InFile, char *OutFile)
+/* score the rows of InFile (in any of its formats) against Mod, all of */
+/* them in one parallel pass, and write a line per row to OutFile (or, */
+/* for a name ending in .bin, an n by 2 binary matrix of the distances */
+/* and flags); every column is read, and a block at a time of the */
+/* model's columns is copied out of them */
+{
+   double *Dist, *V, *B;
+   unsigned char *Flag;
+   long n, i, r, Out = 0, Blocks, Len;
+   int p, j, All;
+   FILE *f;
+
+   Read_Data(InFile);
+   if (FileCols != (int)Mod->H.FileCols) {
+     printf("\n*error* %s has %d columns, but the model was fitted to data\n",
+            InFile, FileCols);
+     printf("with %d\n\n", (int)Mod->H.FileCols);
+     exit(1);
+   }
+   n = XCnt > 0 ? XCnt : 0; p = (int)Mod->H.p;
+   All = p == FileCols;
+   Dist = malloc((n+1)*sizeof(double)); ALLCHK(Dist)
+   Flag = malloc(n+1); ALLCHK(Flag)
+   Blocks = (n + SCORE_BLOCK-1) / SCORE_BLOCK;
+#  pragma omp parallel private(B, Len, r, j) copyin(MO_STATE)
+   {
+     B = NULL;
+     if (!All) {B = malloc(SCORE_BLOCK*p*sizeof(double)); REGION_ALLCHK(B)}
+#    pragma omp for schedule(static)
+     for (i=0; i<Blocks; i++) {
+       if (REGION_FAILED) continue;
+       Len = n - i*SCORE_BLOCK < SCORE_BLOCK ? n - i*SCORE_BLOCK : SCORE_BLOCK;
+       if (!All)
+         for (r=0; r<Len; r++)
+           for (j=0; j<p; j++)
+             B[r*p+j] = X[(i*SCORE_BLOCK+r)*FileCols + Mod->Cols[j]-1];
+       Score_Rows(Mod, All ? X + i*SCORE_BLOCK*p : B, Len,
+                  Dist + i*SCORE_BLOCK, Flag + i*SCORE_BLOCK);
+     }
+     free(B);
+   }
+   Region_Check();
+   for (i=0; i<n; i++) Out += Flag[i];
+   if (Has_Suffix(OutFile, ".bin")) {
+     V = malloc((2*n+1)*sizeof(double)); ALLCHK(V)
+     for (i=0; i<n; i++) {V[2*i] = Dist[i]; V[2*i+1] = Flag[i];}
+     Write_Matrix(OutFile, V, 2, (int)n);
+     free(V);
+   } else {
+     if (!(f=Report_Open(OutFile,"w"))) {
+       printf("Could not open %s for write\n",OutFile);
+       exit(1);
+     }
+     fprintf(f,"# multout scores of %s against a model of %s (p=%d, n=%ld)\n",
+             InFile, Mod->H.Source, p, (long)Mod->H.n);
+     fprintf(f,"# squared distance cutoff %.6E; flag 1 is a potential outlier\n",
+             Mod->H.FinalCut);
+     fprintf(f,"# row distance flag\n");
+     for (i=0; i<n; i++) Put_Score(f, i+1, Dist[i], Flag[i]);
+     Report_Close(f);
+   }
+   printf("Scored %ld rows: %ld potential outliers\n", n, Out);
+   printf("Scores written to %s\n", OutFile);
+   free(Dist); free(Flag);
+}
+
+/*------------------------------------------------------------------*/
+long Put_Scores(FILE *f, struct MO_Model *Mod, double *Rows, long n,
+                double *Dist, unsigned char *Flag, long *Cnt)
+/* score n rows and write their lines, numbering on from *Cnt; return */
+/* how many are potential outliers */
+{
+   long k, Out = 0;
+
+   Score_Rows(Mod, Rows, n, Dist, Flag);
+   for (k=0; k<n; k++) {
+     Put_Score(f, ++*Cnt, Dist[k], Flag[k]);
+     Out += Flag[k];
+   }
+   return Out;
+}
+
+/*------------------------------------------------------------------*/
+#define LIVE_IN (1 << 16)         /* bytes Score_Stream asks read() for */
+#define LIVE_ROWS 256             /* rows it scores together, at most */
+void Score_Stream(struct MO_Model *Mod, char *OutFile)
+/* score rows as they arrive on stdin, a line of FileCols values each */
+/* (no p n header; blank lines and lines starting with # are skipped), */
+/* and write a line per row to OutFile as Score_File does. Whatever one */
+/* read() brings is parsed, scored and flushed before the next, so a */
+/* row waits for nothing that comes after it; the buffers are allocated */
+/* once (the input one grows only for a line longer than it) */
+{
+   char *Buf, *Line, *End, *q;
+   double *Rows, *Dist, v;
+   unsigned char *Flag;
+   int *Want;                   /* file column -> place in a row, or -1 */
+   int Cols = (int)Mod->H.FileCols, p = (int)Mod->H.p, c, k;
+   long Cap = LIVE_IN, Have = 0, Got, LineNo = 0, Cnt = 0, Out = 0, i, Eof = 0;
+   FILE *f;
+
+   if (Has_Suffix(OutFile, ".bin")) {
+     printf("\n*error* scores of stdin are written as text, not to %s\n\n",
+            OutFile);
+     exit(1);
+   }
+   Buf = malloc(Cap); ALLCHK(Buf)
+   Rows = malloc(LIVE_ROWS*p*sizeof(double)); ALLCHK(Rows)
+   Dist = malloc(LIVE_ROWS*sizeof(double)); ALLCHK(Dist)
+   Flag = malloc(LIVE_ROWS); ALLCHK(Flag)
+   Want = malloc(Cols*sizeof(int)); ALLCHK(Want)
+   for (c=0; c<Cols; c++) Want[c] = -1;
+   for (k=0; k<p; k++) Want[Mod->Cols[k]-1] = k;
+   if (!(f=Report_Open(OutFile,"w"))) {
+     printf("Could not open %s for write\n",OutFile);
+     exit(1);
+   }
+   fprintf(f,"# multout scores of stdin against a model of %s (p=%d, n=%ld)\n",
+           Mod->H.Source, p, (long)Mod->H.n);
+   fprintf(f,"# squared distance cutoff %.6E; flag 1 is a potential outlier\n",
+           Mod->H.FinalCut);
+   fprintf(f,"# row distance flag\n");
+   fflush(f);
+   while (!Eof) {
+     if (Have == Cap) {                 /* a line longer than the buffer */
+       Buf = realloc(Buf, Cap *= 2); ALLCHK(Buf)
+     }
+     Got = read(0, Buf + Have, Cap - Have);
+     if (Got < 0 && errno == EINTR) continue;
+     if (Got < 0) {
+       printf("\n*error* reading stdin: %s\n\n", strerror(errno));
+       exit(1);
+     }
+     if (Got == 0) {                    /* a last line without its newline */
+       Eof = 1;
+       if (Have) Buf[Have++] = '\n';
+     }
+     End = Buf + Have + Got;
+     for (Line = Buf, i = 0; Line < End; Line = q + 1) {
+       if ((q = memchr(Line, '\n', End - Line)) == NULL) break;
+       LineNo++;
+       for (; Line < q && IsSpace(*Line); Line++);
+       if (Line == q || *Line == '#') continue;
+       for (c=0; c<Cols; c++) {
+         for (; Line < q && IsSpace(*Line); Line++);
+         if (Line == q) {
+           printf("\n*error* stdin line %ld: %d values, not %d\n\n",
+                  LineNo, c, Cols);
+           exit(1);
+         }
+         if ((Line = Parse_Double(Line, q, &v)) == NULL) {
+           printf("\n*error* stdin line %ld: bad value in column %d\n\n",
+                  LineNo, c+1);
+           exit(1);
+         }
+         if (Want[c] >= 0) Rows[i*p + Want[c]] = v;
+       }
+       for (; Line < q && IsSpace(*Line); Line++);
+       if (Line < q) {
+         printf("\n*error* stdin line %ld: more than %d values\n\n",
+                LineNo, Cols);
+         exit(1);
+       }
+       if (++i == LIVE_ROWS) {
+         Out += Put_Scores(f, Mod, Rows, i, Dist, Flag, &Cnt);
+         i = 0;
+       }
+     }
+     Out += Put_Scores(f, Mod, Rows, i, Dist, Flag, &Cnt);
+     fflush(f);
+     Have = End - Line;                 /* the partial line, to the front */
+     memmove(Buf, Line, Have);
+   }
+   Report_Close(f);
+   printf("Scored %ld rows: %ld potential outliers\n", Cnt, Out);
+   free(Buf); free(Rows); free(Dist); free(Flag); free(Want);
+}
+#undef LIVE_IN
+#undef LIVE_ROWS
+
+/*------------------------------------------------------------------*/
+void Write_First_Results(char *OutFile, char *InFileName)
+/* final report */
+{
+   FILE *f;  /* output file */
+   int row, col;
+   char flag;
+
+   if (!(f=Report_Open(OutFile,"w"))) {
+     printf("Could not open %s for write\n",OutFile);
+     exit(1);
+   }
+   fprintf(f,BANNER);
+   fprintf(f,"\nData read from: %s\n", InFileName);
+   Put_Cols(f);
+   if (Sections & R_MEAN) {
+     fprintf(f,"\nRobust M-Estimate Mean:\n");
+     for (col=1; col <= VectLen; col++) fprintf(f," %11.3E\n", XBarJof(col));
+   }
+   if (Sections & R_COV) {
+     fprintf(f,"\nM-Estimate of Covariance Matrix:\n");
+     for (row=1; row<=VectLen; row++) {
+       for (col=1; col <= VectLen; col++) fprintf(f," %11.3E", Cof(row,col));
+       fprintf(f,"\n");
+     }
+   }
+   Report_Close(f);
+}
+
+/*------------------------------------------------------------------*/
+long Final_Estimate()
+/* the mean and covariance of the points ID_Good kept, into XBarJ and C */
+/* (wrecks C); return how many points they are */
+{
+   long JCnt, Kept;                   /* rows, points kept */
+   int row;
+
+   if (StreamMode) {
+     JCnt = Strm.Cnt;                  /* ID_Good left their sums */
+     Stream_Estimate((double)(JCnt - 1));
+     return JCnt;
+   }
+   JCnt = Kept = 0;
+   for (row=0; row<XCnt; row++)
+     if (JBits[row]) {JCnt++; Kept += Freqof(row+1);}
+   Form_XJ();
+   Compute_XBarJ((int)JCnt);
+   Form_C((int)JCnt);
+   return Kept;
+}
+
+/*------------------------------------------------------------------*/
+void Write_Final_Results(char *OutFile, float RejDist)
+/* final report */
+{
+   FILE *f;  /* output file */
+   int row, col;
+   long JCnt;                         /* points kept */
+   char *Line;                        /* for Put_Row */
+
+   if (!(f=Report_Open(OutFile,"a"))) {
+     printf("Could not open %s for write\n",OutFile);
+     exit(1);
+   }
+   fprintf(f,"\n---------------------------------------------\n");
+   if (Sections & (R_DIST|R_FLAGS)) {
+     fprintf(f,"\nRobust, Unscaled Mahalonobis Distances\n");
+     if (Sections & R_FLAGS)
+       fprintf(f,"An asterisk (*) indicates a potential outlier.\n");
+     if (!(Sections & R_DIST))
+       fprintf(f,"Only the potential outliers are listed.\n");
+     fprintf(f,"The cutoff for a potential outlier (with a requested\n rejection");
+     fprintf(f," of %g of the non-outliers) was determined to be %.3E\n",Cut2, RejDist);   
+   }
+   if (!(Sections & (R_DIST|R_FLAGS))) {}
+   else if (StreamMode) Stream_List(f);
+   else for (row=0; row<XCnt; row++) 
+     Put_Point(f, Freq ? RowOf[row] : row+1, *(SqResiduals+row),
+               !JBits[row], Freqof(row+1));
+   JCnt = Final_Estimate();
+   fprintf(f,"Rejection of the points with asterisks leaves %ld points\n",JCnt);
+   if (Sections & R_MEAN) {
+     fprintf(f,"with mean:\n");
+     for (col=1; col <= VectLen; col++) fprintf(f," %11.3E\n", XBarJof(col));
+   }
+   if (Sections & R_COV) {
+     fprintf(f,"\and covariance matrix:\n");
+     for (row=1; row<=VectLen; row++) {
+       for (col=1; col <= VectLen; col++) fprintf(f," %11.3E", Cof(row,col));
+       fprintf(f,"\n");
+     }
+   }
+
+   if (!(Sections & R_DATA)) {}
+   else if (StreamMode) Stream_Echo(f);
+   else if (Freq && !EchoFile) {
+     Line = malloc(ROW_CHARS); ALLCHK(Line)
+     fprintf(f,"\n\nComplete, Original Data (each distinct point once):\n");
+     for (row=1; row <= XCnt; row++) Put_Row(f, XRow(row), Line);
+     free(Line);
+   }
+   else if (EchoFile) {
+     Write_Matrix(EchoFile, X, VectLen, XCnt);
+     fprintf(f,"\n\nComplete, Original Data: in %s (binary matrix)\n", EchoFile);
+   } else {
+     Line = malloc(ROW_CHARS); ALLCHK(Line)
+     fprintf(f,"\n\nComplete, Original Data:\n");
+     for (row=1; row <= XCnt; row++) Put_Row(f, XRow(row), Line);
+     free(Line);
+   }
+   if (Sections & R_PARMS) {
+     fprintf(f,"\n\nParameters:\n");                               
+     fprintf(f,"p=%d, n=%ld, Iterations:%ld\n",VectLen, AllPoints, ItersAllowed); 
+     if (Freq)
+       fprintf(f,"Duplicates collapsed: %d distinct points\n", XCnt);
+     Dump_Parms(f);
+     if (StreamMode)
+       fprintf(f,"Stream mode: %ld of %ld partition cells searched\n",
+               Strm.Cells, Strm.Parts);
+     fprintf(f,"First stage cutoff %.3E taken from %s\n", FirstCut, CutoffSource);
+     if (CutMode == CHECK) Report_Approx_Check(f);
+     if (CutBlocks && CutHalf > 0.)
+       fprintf(f,"  %ld simulated samples, 95%% confidence half width %.3E (%.2f%%)\n",
+               CutBlocks, CutHalf, 100. * CutHalf / FirstCut);
+     else if (CutBlocks)
+       fprintf(f,"  %ld simulated samples, 95%% confidence half width n/a (fewer than %d rounds)\n",
+               CutBlocks, CI_ROUNDS);
+   }
+   Report_Close(f);
+}
+/*------------------------------------------------------------------*/
+void Bad_Run(char *OutFile, char *InFileName)
+/* final report when things didn't work out */
+{
+   FILE *f;  /* output file */
+   int row, col;
+   
+   if (!(f=Report_Open(OutFile,"w"))) {
+     printf("Could not open %s for write\n",OutFile);
+     exit(1);
+   }
+   fprintf(f,BANNER);
+   fprintf(f,"\nERROR: Could not get results due to singular data\n\n");
+   fprintf(f,"Data read from: %s\n", InFileName);
+   fprintf(f,"\n\nData:\n");
+   for (row=1; row <= XCnt; row++) {
+     for (col=1; col <=VectLen; col++) fprintf(f,"%E ",Xof(row,col));
+     fprintf(f,"\n");
+   }
+   fprintf(f,"\n\nParameters:\n");                               
+   fprintf(f,"p=%d, n=%d, Iterations:%ld\n",VectLen, XCnt, ItersAllowed); 
+   Dump_Parms(f);
+   Report_Close(f);
+}
+
+
+/*------------------------------------------------------------------*/
+int Parse_Sections(char *List)
+/* the report sections named in the comma separated List */
+/* (List is left as it was: it may be a caller's constant) */
+{
+    static char *Name[] = {"all", "none", "mean", "cov", "dist", "flags",
+                           "data", "parms"};
+    char *w;
+    int r = 0, k, Len;
+
+    for (w = List; *w; w += Len + (w[Len] == ',')) {
+      if ((Len = (int)strcspn(w, ",")) == 0) continue;
+      for (k=0; k<8 && (Len != (int)strlen(Name[k])
+                        || strncmp(w, Name[k], Len)); k++);
+      if (k == 8) {
+        printf("\nUnknown report section %.*s\n\n", Len, w);
+        Info_Exit();
+      }
+      if (k == 0) r = R_ALL;
+      else if (k > 1) r |= 1 << (k-2);
+    }
+    return r;
+}
+
+/*------------------------------------------------------------------*/
+int Set_Option(char *Name, char *Value)
+/* one of the command line -options, with Value the argument after it */
+/* (or NULL); return how many of the two it used. The strings are kept */
+{
+    int Used = 2;               /* Name and Value */
+
+    if (!strcmp(Name, "-cache") && Value) CacheDir = Value;
+    else if (!strcmp(Name, "-table")) {UseCutTable = True; Used = 1;}
+    else if (!strcmp(Name, "-pool")) {PoolTails = True; Used = 1;}
+    else if (!strcmp(Name, "-vr")) {VarRed = True; Used = 1;}
+    else if (!strcmp(Name, "-approx")) {CutMode = APPROX; Used = 1;}
+    else if (!strcmp(Name, "-check")) {CutMode = CHECK; Used = 1;}
+    else if (!strcmp(Name, "-prec") && Value) {
+      if ((CutPrec = (float)atof(Value)) <= 0.) Info_Exit();
+    }
+    else if (!strcmp(Name, "-verify")) {VerifyData = True; Used = 1;}
+    else if (!strcmp(Name, "-stream")) {StreamMode = True; Used = 1;}
+    else if (!strcmp(Name, "-sections") && Value)
+      Sections = Parse_Sections(Value);
+    else if (!strcmp(Name, "-cells") && Value) {
+      if ((StreamCells = atol(Value)) < 1) Info_Exit();
+    }
+    else if (!strcmp(Name, "-echo") && Value) EchoFile = Value;
+    else if (!strcmp(Name, "-results") && Value) ResultsFile = Value;
+    else if (!strcmp(Name, "-model") && Value) ModelFile = Value;
+    else if (!strcmp(Name, "-collapse")) {Collapse = True; Used = 1;}
+    else if (!strcmp(Name, "-cols") && Value) ColSpec = Value;
+    else if (!strcmp(Name, "-seed") && Value) {
+      SeedSave = atol(Value); SeedSet = True;
+    }
+    else if (!strcmp(Name, "-threads") && Value) {
+      if ((Threads = atoi(Value)) < 1) Info_Exit();
+    }
+    else {
+      printf("\nUnknown or incomplete option %s\n\n", Name);
+      Info_Exit();
+    }
+    return Used;
+}
+
+/**************************************************************************/
+/*---------------------------------------------------------------------------*/
+double All_Objective()
+/* the objective value of C and XBarJ on all of the data (inverts C) */
+{
+    InvertC(C, VectLen, &Determinant);
+    if (StreamMode) return Determinant * pow(Stream_k(), 2. * VectLen);
+    Compute_Distance_Vector();  /* needed to compute k */
+    return Determinant * pow((double)Compute_k(), (double)(2. * VectLen));
+}
+
+/*---------------------------------------------------------------------------*/
+void Search_Partitions()
+/* the estimation proper: search each cell of a random partition of the */
+/* data, then iterate on all of the data from each cell's best; leaves */
+/* the best C and XBarJ found (X and XCnt are restored) */
+/* in stream mode the first Strm.Cells cells are read from the file in */
+/* turn, and the iterations on all of the data are made in passes */
+{
+    double far *XSave = NULL, far *XWorking = NULL; /* copies of X */
+#   define XWorkingof(i,j) *(XWorking+(i-1)*VectLen+j-1) /* col major...*/
+    int XCntSave = 0;               /* overall n */
+    double *BestC, *BestXBarJ;      /* best of the partition results */
+    double *CSave;                  /* avoid an inversion */
+    double *PartC, *PartBar;        /* to allow S-iter on part result */
+    double MainBestObj = HUGE_VAL;  /* best partition objective value */
+    long PartitionCnt;              /* number of sample partitions */
+    long Cells;                     /* number searched */
+    int *Permutation = NULL;        /* random permutation vector */
+    int *FreqSave = NULL, *FreqWorking = NULL; /* Freq for X and XWorking */
+    int i,j,k;                      /* to loop */
+    int JCnt;                       /* to process sub-samples of partitions */
+    long Part;                      /* to loop through partitions */
+
+    BestC = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(BestC)
+    CSave = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(CSave)
+    PartC = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(PartC)
+    PartBar = malloc(VectLen*sizeof(double)); ALLCHK(PartBar)
+    BestXBarJ = malloc(VectLen*sizeof(double)); ALLCHK(BestXBarJ)
+
+    if (StreamMode) {
+        PartitionCnt = Strm.Parts; Cells = Strm.Cells;
+    } else {
+        XSave = _fmalloc(VectLen*XCnt*sizeof(double)); ALLCHK(XSave)
+        XWorking = _fmalloc(VectLen*XCnt*sizeof(double)); ALLCHK(XWorking)
+        Permutation = malloc(XCnt * sizeof(int)); ALLCHK(Permutation)
+        PartitionCnt = XCnt/Lambda; if (PartitionCnt <= 0) PartitionCnt = 1;
+        Cells = PartitionCnt;
+        XCntSave = XCnt;
+        Copy(XSave, X, XCnt * VectLen);
+        /* randomize the rows of X to make X working */
+        /* column major is a pain....*/
+        Generate_Permutation(XCnt, Permutation);
+        for (j=1; j<=XCnt; j++) for (k=1; k<=VectLen; k++) 
+            XWorkingof(j,k) = Xof((*(Permutation+j-1)),k);
+        if ((FreqSave = Freq)) {    /* the weights follow their rows */
+            FreqWorking = malloc(XCnt * sizeof(int)); ALLCHK(FreqWorking)
+            for (j=1; j<=XCnt; j++) FreqWorking[j-1] = Freqof(*(Permutation+j-1));
+        }
+    }
+
+    for (Part=0; Part<Cells; Part++) {
+        printf("Begin Partition Cell %ld\n",Part+1);
+        if (StreamMode) Stream_Load_Cell(Part);
+        else {
+            XCnt = XCntSave / PartitionCnt;
+            /* this is where that ridiculous column major idea hurts a little ...*/
+            for (j=1; j<=XCnt; j++) for (k=1; k<=VectLen; k++) 
+                Xof(j,k) = XWorkingof(j+Part*XCntSave/PartitionCnt, k); 
+            if (FreqSave) Freq = FreqWorking + Part*XCntSave/PartitionCnt;
+        }
+        Partition_Main(ItersAllowed/PartitionCnt);
+        /* now iterate from the optimal */
+        /* (remember that indexes in the local (random) X are not valid in X)*/
+        Copy(JBits, BestJBits, XCnt); 
+        JCnt = 0; for (i=0; i < XCnt; i++) JCnt += *(JBits+i);
+        Form_XJ();
+        Compute_XBarJ(JCnt);
+        Form_C(JCnt);
+        M_Iterate();
+        Copy(PartC, C, VectLen*VectLen*2);
+        Copy(PartBar, XBarJ, VectLen);
+        /*use entire sample to a get obj value and save the best C and XBARJ*/
+        if (StreamMode) {
+            Stream_Forward();
+            Stream_M_Iterate();
+        } else {
+            Copy(X, XSave, XCnt * VectLen);
+            XCnt = XCntSave;
+            Freq = FreqSave;
+            Forward(&JCnt);
+            M_Iterate();
+        }
+        Copy(CSave, C, VectLen*VectLen*2);
+        if (Trace) Dump_XBarJ("after iteration on all data");
+        ObjectiveValue = All_Objective();
+        if (Trace) printf("Partition ObjectiveValue=%lf\n",ObjectiveValue);
+        if (ObjectiveValue < MainBestObj) {
+            MainBestObj = ObjectiveValue;
+            Copy(BestC, CSave, VectLen*VectLen*2);
+            Copy(BestXBarJ, XBarJ, VectLen);
+	}
+        Copy(C, PartC,VectLen*VectLen*2);
+        Copy(XBarJ, PartBar, VectLen);
+        /***** duplicate to allow with and without forward */
+        if (StreamMode) Stream_M_Iterate(); else M_Iterate();
+        Copy(CSave, C, VectLen*VectLen*2);
+        if (Trace) Dump_XBarJ("after non-forward iteration on all data again");
+        ObjectiveValue = All_Objective();
+        if (Trace) printf("Partition ObjectiveValue=%lf\n",ObjectiveValue);
+        if (ObjectiveValue < MainBestObj) {
+            MainBestObj = ObjectiveValue;
+            Copy(BestC, CSave, VectLen*VectLen*2);
+            Copy(BestXBarJ, XBarJ, VectLen);
+	}
+/*  end dupl */
+    }
+    Copy(C, BestC,VectLen*VectLen*2);
+    Copy(XBarJ, BestXBarJ, VectLen);
+    if (!StreamMode) {
+        _ffree(XWorking);
+        Copy(X, XSave, XCnt * VectLen);
+        _ffree(XSave);
+        XCnt = XCntSave;
+        free(Permutation);
+        if (FreqSave) free(FreqWorking);
+    }
+    if (Trace) Dump_XBarJ("best partition");
+    free(BestC); free(CSave); free(PartC); free(PartBar); free(BestXBarJ);
+#   undef XWorkingof
+}
+
+/*---------------------------------------------------------------------------*/
+/* each allocation is on its context's list, so that whatever a run */
+/* leaves (or a failed run drops) can be freed with the context */
+struct Heap {
+    pthread_mutex_t Lock;           /* the threads of a run share it */
+    struct Block *First;
+};
+struct Block {                      /* in front of each allocation */
+    struct Block *Prev, *Next;
+    struct Heap *Owner;             /* NULL: on no list */
+    size_t Pad;                     /* keeps the data 16 byte aligned */
+};
+
+/* the context: the globals of a run (see MO_STATE) while no call is */
+/* using them, and what the caller gave */
+#define MO_FIELD(v) __typeof__(v) v;
+struct MultOut {
+    MO_OPTIONS(MO_FIELD)
+    MO_RUN(MO_FIELD)
+    struct Heap *Heap;
+    FILE *Log;                      /* MO_Log */
+    const double *Data;             /* MO_Set_Data */
+    int DataP;
+    long DataN;
+    char *DataName;                 /*   and what the report calls it */
+    char Error[MSG_LEN];            /* MO_Error */
+};
+TLS struct MultOut *CallCtx = NULL;     /* the context of the current call */
+
+void Ctx_Save(struct MultOut *m);
+void Call_Enter(struct MultOut *m, jmp_buf *Jump);
+void Memo_Drop();
+void Files_Close();
+
+/*---------------------------------------------------------------------------*/
+void Copy_Data(const double *x, int p, long n)
+/* X from the caller's n by p row major matrix (with -cols, just those */
+/* columns) */
+{
+    long i;
+    int j;
+
+    Select_Cols(p);
+    if (n <= VectLen || n > INT_MAX) {
+      printf("\n*error* For vectors of length %d, there must be at least %d points\n\n",
+             VectLen, VectLen+1);
+      exit(1);
+    }
+    XCnt = (int)n;
+    X = malloc((size_t)VectLen*XCnt*sizeof(double)); ALLCHK(X)
+    for (i=0; i<n; i++) for (j=0; j<VectLen; j++)
+      X[i*VectLen+j] = x[i*p + (ColOf ? ColOf[j]-1 : j)];
+}
+
+/*---------------------------------------------------------------------------*/
+/* the first stage cutoff depends only on n and p, so it is simulated by */
+/* a thread of its own (with its own OpenMP team) while the estimate is */
+/* found; it works on a copy of the state and hands back what it set */
+struct CutJob {
+    struct MultOut *S;              /* the state, before and after */
+    double CutPt;                   /* the result */
+    int Code;                       /* MO_OK, or how it failed */
+    char Msg[MSG_LEN];              /*   and why */
+};
+
+void *Cut_Main(void *Arg)
+{
+    struct CutJob *Job = Arg;
+    jmp_buf Jump;
+    double t;
+
+    Call_Enter(Job->S, &Jump);
+    if (setjmp(Jump)) {
+      Memo_Drop();
+      Files_Close();
+      Job->Code = CallCode;
+      memcpy(Job->Msg, Msg, MSG_LEN);
+      return NULL;
+    }
+#   ifdef _OPENMP
+      if (Threads) omp_set_num_threads(Threads);
+#   endif
+    t = Wall();
+    Job->CutPt = Rej_Cutoff((int)AllPoints, Cut1, SimTol, True);
+    Secs[2] = Wall() - t;
+    Ctx_Save(Job->S);
+    Job->Code = MO_OK;
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+double First_Stage(char *OutFile, char *InFileName)
+/* the estimate (left in C and XBarJ) and the first stage cutoff; with */
+/* an OutFile the first report is written as soon as the estimate is */
+/* found, so it is there while the cutoff is still being simulated */
+{
+    struct CutJob *Job = NULL;
+    double CutPt = 0.;              /* first stage cutoff (sq dist) */
+    double t0;                      /* start of the phase being timed */
+
+    if (StreamMode) {
+      /* simulated samples would be as big as the data: use the closed form */
+      if (CutMode != APPROX) printf("Stream mode: using the -approx cutoff\n");
+      CutMode = APPROX;
+      t0 = Wall();
+      CutPt = ApproxCut = Approx_Rej_Dist((double)Strm.n, VectLen, Cut1);
+      Secs[2] = Wall() - t0;
+      CutoffSource = "the scaled F approximation";
+    } else {
+      Job = malloc(sizeof(*Job)); ALLCHK(Job)
+      Job->S = malloc(sizeof(struct MultOut)); ALLCHK(Job->S)
+      *Job->S = *CallCtx;
+      Ctx_Save(Job->S);
+      if (pthread_create(&CutThread, NULL, Cut_Main, Job)) {
+        printf("Could not start the cutoff thread\n");
+        exit(1);
+      }
+      CutRunning = True;
+    }
+    t0 = Wall();
+    Search_Partitions();
+    Secs[1] = Wall() - t0;
+    if (OutFile) {
+      Write_First_Results(OutFile, InFileName); /* needs C intact */
+      printf("Analysis report written to %s.\n",OutFile);
+    }
+    if (Job) {
+      pthread_join(CutThread, NULL);
+      CutRunning = False;
+      CutHalf = Job->S->CutHalf; CutBlocks = Job->S->CutBlocks;
+      CutoffSource = Job->S->CutoffSource; ApproxCut = Job->S->ApproxCut;
+      Secs[2] = Job->S->Secs[2];
+      if (Job->Code != MO_OK) {
+        memcpy(Msg, Job->Msg, MSG_LEN);
+        MsgLen = (int)strlen(Msg); MsgHold = 1;
+        exit(Job->Code);
+      }
+      CutPt = Job->CutPt;
+      free(Job->S); free(Job);
+    }
+    return CutPt;
+}
+
+/*---------------------------------------------------------------------------*/
+void Analyse(char *InFile, char *OutFile, long Iters, char *ParmsFile)
+/* a whole run, as the multout program makes it: the data come from */
+/* InFile, or are in X already if it is NULL; the reports are written */
+/* to OutFile, if there is one. Iters < 0 is (n)(p) iterations */
+{
+    FILE *f;                        /* for file check */
+    float CutDist;                  /* to report */
+    double CutPt;                   /* first stage cutoff (sq dist) */
+    double t0;                      /* start of the phase being timed */
+
+#   ifndef BaseSubSampleSize
+      printf("Compiled without BaseSubSampleSize defined.\nAborting");
+      exit(1);
+#   endif
+#   ifdef _OPENMP
+      if (Threads) omp_set_num_threads(Threads);
+#   endif
+    if (InFile) {
+      t0 = Wall();
+      Load_Data(InFile);
+      Secs[0] = Wall() - t0;
+    }
+    ItersAllowed = Iters >= 0 ? Iters : VectLen * AllRows;
+
+    if (Trace && !StreamMode) Dump_Data("After Load");
+    if (ParmsFile) Load_Parms(ParmsFile); else Set_Default_Parms();
+    if (StreamMode) Stream_Cells();   /* XCnt becomes the cell size */
+    Make_Room();
+    if (OutFile) {
+      if (!(f=Report_Open(OutFile,"w"))) Info_Exit();
+      Report_Close(f);
+    }
+    Set_c_and_b0();
+
+    CutPt = First_Stage(OutFile, InFile ? InFile : CallCtx->DataName);
+    t0 = Wall();
+    Keep_Fit();
+    InvertC(C, VectLen, &Determinant);
+    if (!StreamMode) Compute_Distance_Vector();
+    printf("Beginning outlier detection.\n");
+    CutDist = ID_Good(CutPt, Cut1, Cut2);
+    Secs[3] = Wall() - t0;
+    if (ResultsFile) {
+      Write_Results(ResultsFile);
+      printf("Point results written to %s\n", ResultsFile);
+    }
+    if (ModelFile) {
+      Write_Model(ModelFile, InFile ? InFile : CallCtx->DataName);
+      printf("Model written to %s\n", ModelFile);
+    }
+    if (OutFile) {
+      Write_Final_Results(OutFile, CutDist); /* wrecks C */
+      printf("Done.\nFinal report written to %s\n",OutFile);
+    } else Final_Estimate();
+    Finished = True;
+}
+
+/**************************************************************************/
+/* the library interface (multout.h) and the machinery behind it: from */
+/* here on malloc, free, printf, exit and the file calls are the real ones */
+#undef printf
+#undef exit
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+#undef fopen
+#undef fdopen
+#undef fclose
+#undef open
+#undef close
+
+/*---------------------------------------------------------------------------*/
+/* the files and descriptors the thread has open (fopen and open above, */
+/* in place of the real ones); when all CALL_FILES are in use, a further */
+/* open fails as if the process had run out of them */
+#define CALL_FILES 16
+TLS FILE *CallFile[CALL_FILES];
+TLS int CallFd[CALL_FILES];
+TLS int CallFiles = 0, CallFds = 0;
+
+FILE *File_Track(FILE *f)
+{
+    if (f && CallFiles == CALL_FILES) {
+      fclose(f);
+      errno = EMFILE;
+      return NULL;
+    }
+    if (f) CallFile[CallFiles++] = f;
+    return f;
+}
+
+/*---------------------------------------------------------------------------*/
+int File_Close(FILE *f)
+{
+    int i;
+
+    for (i=0; i<CallFiles; i++)
+      if (CallFile[i] == f) {CallFile[i] = CallFile[--CallFiles]; break;}
+    return fclose(f);
+}
+
+/*---------------------------------------------------------------------------*/
+int Fd_Track(int fd)
+{
+    if (fd >= 0 && CallFds == CALL_FILES) {
+      close(fd);
+      errno = EMFILE;
+      return -1;
+    }
+    if (fd >= 0) CallFd[CallFds++] = fd;
+    return fd;
+}
+
+/*---------------------------------------------------------------------------*/
+int Fd_Close(int fd)
+{
+    int i;
+
+    for (i=0; i<CallFds; i++)
+      if (CallFd[i] == fd) {CallFd[i] = CallFd[--CallFds]; break;}
+    return close(fd);
+}
+
+/*---------------------------------------------------------------------------*/
+FILE *File_Adopt(int fd, FILE *f)
+/* fdopen(fd) gave f, which now owns fd */
+{
+    int i;
+
+    if (!f) return NULL;
+    for (i=0; i<CallFds; i++)
+      if (CallFd[i] == fd) {CallFd[i] = CallFd[--CallFds]; break;}
+    return File_Track(f);
+}
+
+/*---------------------------------------------------------------------------*/
+void Files_Close()
+/* close what a failed call left open */
+{
+    while (CallFiles) fclose(CallFile[--CallFiles]);
+    while (CallFds) close(CallFd[--CallFds]);
+}
+#undef CALL_FILES
+
+/*---------------------------------------------------------------------------*/
+void Heap_Link(struct Block *b, struct Heap *h)
+{
+    b->Owner = h;
+    if (!h) return;
+    pthread_mutex_lock(&h->Lock);
+    b->Prev = NULL;
+    if ((b->Next = h->First) != NULL) b->Next->Prev = b;
+    h->First = b;
+    pthread_mutex_unlock(&h->Lock);
+}
+
+/*---------------------------------------------------------------------------*/
+void Heap_Unlink(struct Block *b)
+{
+    struct Heap *h = b->Owner;
+
+    if (!h) return;
+    pthread_mutex_lock(&h->Lock);
+    if (b->Prev) b->Prev->Next = b->Next; else h->First = b->Next;
+    if (b->Next) b->Next->Prev = b->Prev;
+    pthread_mutex_unlock(&h->Lock);
+}
+
+/*---------------------------------------------------------------------------*/
+void *Heap_Alloc(size_t n)
+/* malloc, on the list of the thread's context (CallHeap) */
+{
+    struct Block *b;
+
+    if ((b = malloc(sizeof(*b) + n)) == NULL) return NULL;
+    Heap_Link(b, CallHeap);
+    return b + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+void *Heap_Calloc(size_t n, size_t Size)
+{
+    void *p;
+
+    if ((p = Heap_Alloc(n * Size)) != NULL) memset(p, 0, n * Size);
+    return p;
+}
+
+/*---------------------------------------------------------------------------*/
+void *Heap_Realloc(void *p, size_t n)
+{
+    struct Block *b, *Moved;
+
+    if (!p) return Heap_Alloc(n);
+    b = (struct Block *)p - 1;
+    Heap_Unlink(b);
+    if ((Moved = realloc(b, sizeof(*b) + n)) == NULL) {
+      Heap_Link(b, b->Owner);
+      return NULL;
+    }
+    Heap_Link(Moved, Moved->Owner);
+    return Moved + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+void Heap_Free(void *p)
+{
+    struct Block *b;
+
+    if (!p) return;
+    b = (struct Block *)p - 1;
+    Heap_Unlink(b);
+    free(b);
+}
+
+/*---------------------------------------------------------------------------*/
+void Heap_Free_All(struct Heap *h)
+{
+    struct Block *b, *Next;
+
+    pthread_mutex_lock(&h->Lock);
+    for (b = h->First; b; b = Next) {Next = b->Next; free(b);}
+    h->First = NULL;
+    pthread_mutex_unlock(&h->Lock);
+}
+
+/*---------------------------------------------------------------------------*/
+/* the cutoffs found so far in this process, so that runs of the same */
+/* shape (a batch, or contexts side by side) simulate only once; the key */
+/* includes the seed, so a remembered cutoff is exactly the one the run */
+/* would have simulated. A run that finds its key being worked on by */
+/* another waits for it */
+struct Memo {
+    struct Memo *Next;
+    char Ver[32];                   /* Cutoff_Version() */
+    int n, p, UseAlgo;
+    float a, tol, Goal;
+    long Seed;
+    int Done;                       /* False: still being found */
+    double Cut, Half;               /* the cutoff, CutHalf */
+    long Blocks;                    /* CutBlocks */
+    char *Source;                   /* CutoffSource */
+};
+struct Memo *Memos = NULL;
+pthread_mutex_t MemoLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t MemoDone = PTHREAD_COND_INITIALIZER;
+TLS struct Memo *MemoOwn = NULL;    /* the entry this thread must fill */
+
+int Memo_Find(int n, float a, float tol, float Goal, int UseAlgo, double *Cut)
+/* True, with *Cut, CutHalf, CutBlocks and CutoffSource set, if the */
+/* cutoff is known; if not, the caller is to find it and Memo_Put it */
+{
+    struct Memo *e;
+    char *Ver = Cutoff_Version();
+
+    pthread_mutex_lock(&MemoLock);
+    for (;;) {
+      for (e = Memos; e; e = e->Next)
+        if (e->n == n && e->p == VectLen && e->a == a && e->tol == tol
+            && e->Goal == Goal && e->UseAlgo == UseAlgo
+            && e->Seed == SeedSave && !strcmp(e->Ver, Ver)) break;
+      if (!e || e->Done) break;
+      pthread_cond_wait(&MemoDone, &MemoLock);
+    }
+    if (e) {
+      *Cut = e->Cut; CutHalf = e->Half; CutBlocks = e->Blocks;
+      CutoffSource = e->Source;
+    } else if ((e = calloc(1, sizeof(*e))) != NULL) {
+      strcpy(e->Ver, Ver);
+      e->n = n; e->p = VectLen; e->a = a; e->tol = tol; e->Goal = Goal;
+      e->UseAlgo = UseAlgo; e->Seed = SeedSave;
+      e->Next = Memos; Memos = e;
+      MemoOwn = e;
+      e = NULL;
+    }
+    pthread_mutex_unlock(&MemoLock);
+    return e != NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+void Memo_Put(double Cut)
+{
+    struct Memo *e = MemoOwn;
+
+    if (!e) return;
+    pthread_mutex_lock(&MemoLock);
+    e->Cut = Cut; e->Half = CutHalf; e->Blocks = CutBlocks;
+    e->Source = CutoffSource;
+    e->Done = True;
+    MemoOwn = NULL;
+    pthread_cond_broadcast(&MemoDone);
+    pthread_mutex_unlock(&MemoLock);
+}
+
+/*---------------------------------------------------------------------------*/
+void Memo_Drop()
+/* the cutoff this thread was finding will not come: let another try */
+{
+    struct Memo **e;
+
+    if (!MemoOwn) return;
+    pthread_mutex_lock(&MemoLock);
+    for (e = &Memos; *e != MemoOwn; e = &(*e)->Next);
+    *e = MemoOwn->Next;
+    free(MemoOwn);
+    MemoOwn = NULL;
+    pthread_cond_broadcast(&MemoDone);
+    pthread_mutex_unlock(&MemoLock);
+}
+
+/*---------------------------------------------------------------------------*/
+int Log_Printf(const char *Fmt, ...)
+/* printf: to the log, keeping the last paragraph for MO_Error */
+{
+    va_list a;
+    char Line[MSG_LEN], *s;
+    int r;
+
+    va_start(a, Fmt);
+    r = vsnprintf(Line, sizeof(Line), Fmt, a);
+    va_end(a);
+    if (CallLog) {
+      va_start(a, Fmt);
+      vfprintf(CallLog, Fmt, a);
+      va_end(a);
+    }
+    if (MsgHold) return r;
+    for (s = Line; *s; s++) {
+      if (*s == '\n' && (MsgLen == 0 || Msg[MsgLen-1] == '\n')) {
+        MsgNew = 1;                 /* a blank line ends the paragraph */
+        continue;
+      }
+      if (MsgNew) MsgLen = MsgNew = 0;
+      if (MsgLen < MSG_LEN-1) Msg[MsgLen++] = *s;
+    }
+    Msg[MsgLen] = 0;
+    return r;
+}
+
+/*---------------------------------------------------------------------------*/
+void Fail(int Code)
+/* exit: back out of the library call with an error code (MO_USAGE or */
+/* MO_ERROR), or in a thread of one of its parallel regions, out of the */
+/* TASK (the first error is the one reported) */
+{
+    if (Omp_Level() > CallLevel && TaskJump) {
+      Region_Fail(Code);
+      longjmp(*TaskJump, 1);
+    }
+    if (!CallJump || Omp_Level() > CallLevel) exit(1);
+    CallCode = Code == MO_USAGE ? MO_USAGE : MO_ERROR;
+    longjmp(*CallJump, 1);
+}
+
+/*---------------------------------------------------------------------------*/
+void Region_Fail(int Code)
+/* note the failure of this thread of a parallel region (the first one */
+/* noted is the one reported) */
+{
+#   pragma omp critical (Region_Fail)
+    if (!RegionErr->Code) {
+      memcpy(RegionErr->Msg, Msg, MSG_LEN);
+      RegionErr->Code = Code == MO_USAGE ? MO_USAGE : MO_ERROR;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+void Region_Check()
+/* after a parallel region: fail with the error one of its threads noted */
+{
+    int Code = RegionErr->Code;
+
+    if (Code == MO_OK) return;
+    memcpy(Msg, RegionErr->Msg, MSG_LEN);
+    MsgLen = strlen(Msg); MsgNew = 0;
+    RegionErr->Code = MO_OK;
+    Fail(Code);
+}
+
+/*---------------------------------------------------------------------------*/
+void Ctx_Load(struct MultOut *m)
+/* m's state becomes this thread's globals */
+{
+#   define MO_LOAD(v) memcpy(&v, &m->v, sizeof(v));
+    MO_OPTIONS(MO_LOAD)
+    MO_RUN(MO_LOAD)
+}
+
+/*---------------------------------------------------------------------------*/
+void Ctx_Save(struct MultOut *m)
+{
+#   define MO_SAVE(v) memcpy(&m->v, &v, sizeof(v));
+    MO_OPTIONS(MO_SAVE)
+    MO_RUN(MO_SAVE)
+}
+
+/*---------------------------------------------------------------------------*/
+void Call_Enter(struct MultOut *m, jmp_buf *Jump)
+/* begin a library call on m (Fail returns to Jump) */
+{
+    Ctx_Load(m);
+    CallCtx = m;
+    CallHeap = m->Heap;
+    CallLog = m->Log;
+    CallJump = Jump;
+    CallLevel = Omp_Level();
+    CallCode = MO_OK;
+    CallRegion.Code = MO_OK;
+    RegionErr = &CallRegion;
+    Msg[0] = 0; MsgLen = MsgNew = MsgHold = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+int Call_Leave(struct MultOut *m, int Code)
+/* end it, returning Code; after a failure the cutoff thread is waited */
+/* for, and the report and any other files it left open are closed */
+{
+    char *s = Msg;
+    int Len = MsgLen;
+
+    if (CutRunning) {pthread_join(CutThread, NULL); CutRunning = False;}
+    if (OpenReport) {
+      if (OpenReport != ReportOut) File_Close(OpenReport);
+      OpenReport = NULL;
+    }
+    Files_Close();
+    Ctx_Save(m);
+    if (Code == MO_OK) Len = 0;
+    for (; Len > 0 && *s == '\n'; Len--) s++;
+    for (; Len > 0 && s[Len-1] == '\n'; Len--);
+    if (Code != MO_OK && !Len) {s = "bad options or arguments"; Len = strlen(s);}
+    memcpy(m->Error, s, Len);
+    m->Error[Len] = 0;
+    CallJump = NULL; CallCtx = NULL;
+    return Code;
+}
+
+/*---------------------------------------------------------------------------*/
+void Begin_Run()
+/* free whatever the last run on this context left, and clear its state */
+{
+#   define MO_CLEAR(v) memset(&v, 0, sizeof(v));
+    if (KeptMap) munmap(KeptMap, KeptLen);
+    if (Room) Heap_Unlink((struct Block *)Room - 1);   /* see Make_Room */
+    Heap_Free_All(CallHeap);
+    if (Room) Heap_Link((struct Block *)Room - 1, CallHeap);
+    MO_RUN(MO_CLEAR)
+    CutoffSource = "simulation";
+}
+
+/*---------------------------------------------------------------------------*/
+struct MultOut *MO_New()
+{
+    static pthread_once_t Once = PTHREAD_ONCE_INIT;
+    struct MultOut *m;
+
+    pthread_once(&Once, Zig_Init);
+    if ((m = calloc(1, sizeof(*m))) == NULL) return NULL;
+    if ((m->Heap = calloc(1, sizeof(struct Heap))) == NULL) {
+      free(m);
+      return NULL;
+    }
+    pthread_mutex_init(&m->Heap->Lock, NULL);
+    m->Sections = R_ALL;
+    m->CutoffSource = "simulation";
+    m->DataName = "the data";
+    return m;
+}
+
+/*---------------------------------------------------------------------------*/
+void MO_Free(struct MultOut *m)
+{
+    if (!m) return;
+    if (m->KeptMap) munmap(m->KeptMap, m->KeptLen);
+    Heap_Free_All(m->Heap);
+    pthread_mutex_destroy(&m->Heap->Lock);
+    free(m->Heap);
+    free(m);
+}
+
+/*---------------------------------------------------------------------------*/
+void MO_Log(struct MultOut *m, FILE *f) {m->Log = f;}
+void MO_Report(struct MultOut *m, FILE *f) {m->ReportOut = f;}
+char *MO_Error(struct MultOut *m) {return m->Error;}
+char *MO_Banner() {return BANNER;}
+
+/*---------------------------------------------------------------------------*/
+int MO_Usage(struct MultOut *m)
+{
+    Call_Enter(m, NULL);
+    Usage();
+    return Call_Leave(m, MO_USAGE);
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Option(struct MultOut *m, char *Name, char *Value)
+{
+    jmp_buf Jump;
+    int Used;
+
+    Call_Enter(m, &Jump);
+    if (setjmp(Jump)) {
+      Call_Leave(m, CallCode);
+      return 0;
+    }
+    Used = Set_Option(Name, Value);
+    Call_Leave(m, MO_OK);
+    return Used;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Set_Parms(struct MultOut *m, int Lambda, int Trace, float Cut,
+                 float SimTol)
+{
+    char *Why = NULL;
+
+    if (Lambda < 0 || (Lambda > 0 && Lambda < 3)) Why = "Lambda must be 0 or more than 2";
+    else if (Cut < 0. || Cut > 1.) Why = "the cut fraction must be between 0 and 1";
+    else if (SimTol <= 0.) Why = "the simulation tolerance must be greater than 0";
+    if (Why) {
+      strcpy(m->Error, Why);
+      return MO_USAGE;
+    }
+    m->ParmsSet = True;
+    m->SetLambda = Lambda; m->SetTrace = Trace;
+    m->SetCut = Cut; m->SetSimTol = SimTol;
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Set_Data(struct MultOut *m, const double *x, int p, long n)
+{
+    if (!x || p < 1 || n < 0) {
+      strcpy(m->Error, "the data must be an n by p matrix, p > 0");
+      return MO_USAGE;
+    }
+    m->Data = x; m->DataP = p; m->DataN = n;
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Set_Name(struct MultOut *m, char *Name)
+{
+    m->DataName = Name;
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+void Use_Data(struct MultOut *m)
+/* X from the MO_Set_Data data, for a run */
+{
+    double t0;
+
+    if (!m->Data || StreamMode) {
+      Log_Printf("\n*error* %s\n\n", StreamMode ? "-stream needs a data file"
+                 : "no data (see MO_Set_Data)");
+      Fail(MO_USAGE);
+    }
+    t0 = Wall();
+    Copy_Data(m->Data, m->DataP, m->DataN);
+    if (!SeedSet) SeedSave = DEFAULT_SEED;
+    Data_Ready(m->DataName);
+    Secs[0] = Wall() - t0;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Run(struct MultOut *m, long Iters)
+{
+    jmp_buf Jump;
+
+    Call_Enter(m, &Jump);
+    if (setjmp(Jump)) return Call_Leave(m, CallCode);
+    Begin_Run();
+    Use_Data(m);
+    Analyse(NULL, NULL, Iters, NULL);
+    return Call_Leave(m, MO_OK);
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Run_Files(struct MultOut *m, char *InFile, char *OutFile, long Iters,
+                 char *ParmsFile)
+{
+    jmp_buf Jump;
+
+    Call_Enter(m, &Jump);
+    if (setjmp(Jump)) return Call_Leave(m, CallCode);
+    Begin_Run();
+    if (!InFile) Use_Data(m);
+    Analyse(InFile, OutFile, Iters, ParmsFile);
+    return Call_Leave(m, MO_OK);
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Load(struct MultOut *m, char *InFile, double **x, int *p, long *n)
+{
+    jmp_buf Jump;
+    double *Out;
+    size_t Len;
+
+    Call_Enter(m, &Jump);
+    if (setjmp(Jump)) return Call_Leave(m, CallCode);
+    Begin_Run();
+    if (StreamMode) {
+      Log_Printf("\n*error* -stream data cannot be loaded into memory\n\n");
+      Fail(MO_USAGE);
+    }
+    Read_Data(InFile);
+    if (XCnt <= 0) {
+      Log_Printf("\n*error* no data in %s\n\n", InFile);
+      Fail(MO_ERROR);
+    }
+    Len = (size_t)VectLen * XCnt * sizeof(double);
+    if ((Out = malloc(Len)) == NULL) {
+      Log_Printf("allocation error\n");
+      Fail(MO_ERROR);
+    }
+    memcpy(Out, X, Len);
+    *x = Out; *p = VectLen; *n = XCnt;
+    Begin_Run();                    /* the context's copy is not needed */
+    return Call_Leave(m, MO_OK);
+}
+
+/*---------------------------------------------------------------------------*/
+int Not_Finished(struct MultOut *m, int NeedRows)
+/* True (with the reason in m->Error) if there are no results to give */
+{
+    if (!m->Finished) strcpy(m->Error, "there are no results: no run has finished");
+    else if (NeedRows && m->StreamMode)
+      strcpy(m->Error, "a -stream run keeps no per point results");
+    else return False;
+    return True;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Dims(struct MultOut *m, int *p, long *n)
+{
+    if (Not_Finished(m, False)) return MO_ERROR;
+    *p = m->VectLen;
+    *n = m->StreamMode ? m->Strm.n : (long)m->XCnt;
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Estimate(struct MultOut *m, double *Mean, double *Cov)
+{
+    int p = m->VectLen;
+
+    if (Not_Finished(m, False)) return MO_ERROR;
+    if (Mean) memcpy(Mean, m->XBarJ, p * sizeof(double));
+    if (Cov) memcpy(Cov, m->C, (size_t)p * p * sizeof(double));
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_M_Estimate(struct MultOut *m, double *Mean, double *Cov)
+{
+    int p = m->VectLen;
+
+    if (Not_Finished(m, False)) return MO_ERROR;
+    if (Mean) memcpy(Mean, m->MBar, p * sizeof(double));
+    if (Cov) memcpy(Cov, m->MFit, (size_t)p * p * sizeof(double));
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Distances(struct MultOut *m, double *Dist, unsigned char *Flag,
+                 long *Row)
+{
+    int i;
+
+    if (Not_Finished(m, True)) return MO_ERROR;
+    for (i=0; i<m->XCnt; i++) {
+      if (Dist) Dist[i] = m->SqResiduals[i];
+      if (Flag) Flag[i] = !m->JBits[i];
+      if (Row) Row[i] = m->Freq ? m->RowOf[i] : i+1;
+    }
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Cutoffs(struct MultOut *m, double *First, double *Final)
+{
+    if (Not_Finished(m, False)) return MO_ERROR;
+    if (First) *First = m->FirstCut;
+    if (Final) *Final = m->FinalCut;
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+void Score_Rows(const struct MO_Model *Mod, const double *x, long n,
+                double *Dist, unsigned char *Flag)
+/* the squared distances of the n rows of x from the model, as */
+/* |W (x - Mean)|^2, and flags for those at or beyond the final cutoff; */
+/* SCORE_ROWS rows go through together, with the rows innermost, so the */
+/* loops vectorise across rows. Nothing is allocated: the deviations are */
+/* on the stack (for p up to SCORE_P; above that they are recomputed) */
+{
+    double Dev[SCORE_ROWS * SCORE_P], *D, Sum[SCORE_ROWS], z[SCORE_ROWS], w;
+    const double *W = Mod->W, *Mean = Mod->Mean, *y;
+    long r0;
+    int p = Mod->H.p, i, j, r, B;
+
+    for (r0 = 0; r0 < n; r0 += SCORE_ROWS) {
+      B = n - r0 < SCORE_ROWS ? (int)(n - r0) : SCORE_ROWS;
+      if (p <= SCORE_P) {
+        for (j = 0; j < p; j++)
+          for (r = 0, D = Dev + j*SCORE_ROWS; r < SCORE_ROWS; r++)
+            D[r] = r < B ? x[(r0 + r)*p + j] - Mean[j] : 0.;
+        for (r = 0; r < SCORE_ROWS; r++) Sum[r] = 0.;
+        for (i = 0; i < p; i++) {
+          for (r = 0; r < SCORE_ROWS; r++) z[r] = 0.;
+          for (j = 0; j <= i; j++) {
+            w = W[i*p + j];
+            D = Dev + j*SCORE_ROWS;
+#           pragma omp simd
+            for (r = 0; r < SCORE_ROWS; r++) z[r] += w * D[r];
+          }
+#         pragma omp simd
+          for (r = 0; r < SCORE_ROWS; r++) Sum[r] += z[r] * z[r];
+        }
+      } else for (r = 0; r < B; r++) {
+        y = x + (r0 + r)*p;
+        for (Sum[r] = 0., i = 0; i < p; i++) {
+          for (w = 0., j = 0; j <= i; j++) w += W[i*p + j] * (y[j] - Mean[j]);
+          Sum[r] += w * w;
+        }
+      }
+      for (r = 0; r < B; r++) {
+        Dist[r0 + r] = Sum[r];
+        if (Flag) Flag[r0 + r] = Sum[r] >= Mod->H.FinalCut;
+      }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+void MO_Score(const struct MO_Model *Mod, const double *x, long n,
+              double *Dist, unsigned char *Flag)
+{
+    Score_Rows(Mod, x, n, Dist, Flag);
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Read_Model(struct MultOut *m, char *File, struct MO_Model **Model)
+{
+    struct MO_Model *Mod;
+    struct ModHeader *H;
+    FILE *f;
+    long Len;
+    uint64_t p, Need[MOD_BLOCKS];
+    char *Buf, *Why = NULL;
+    int i, j, k;
+    double Sum;
+
+    *Model = NULL;
+    if ((f = fopen(File, "rb")) == NULL) {
+      snprintf(m->Error, MSG_LEN, "Could not open %s for read", File);
+      return MO_USAGE;
+    }
+    if (fseek(f, 0L, SEEK_END) || (Len = ftell(f)) < 0
+        || fseek(f, 0L, SEEK_SET)) {      /* a pipe, say */
+      fclose(f);
+      snprintf(m->Error, MSG_LEN, "%s is not a multout model file", File);
+      return MO_ERROR;
+    }
+    if ((Mod = calloc(1, sizeof(*Mod))) == NULL
+        || (Buf = Mod->Buf = malloc(Len + 1)) == NULL) {
+      fclose(f);
+      MO_Free_Model(Mod);
+      strcpy(m->Error, "allocation error");
+      return MO_ERROR;
+    }
+    if (fread(Buf, 1, Len, f) != (size_t)Len) Why = "could not be read";
+    fclose(f);
+    H = &Mod->H;
+    if (!Why && ((size_t)Len < sizeof(*H) || memcmp(Buf, MOD_MAGIC, 8)))
+      Why = "is not a multout model file";
+    if (!Why) {
+      memcpy(H, Buf, sizeof(*H));
+      p = H->p;
+      Need[MOD_MEAN] = p; Need[MOD_SCATTER] = Need[MOD_FACTOR] = p * p;
+      Need[MOD_COLS] = (p + 1) / 2;         /* in doubles */
+      if (H->Order != MAT_ORDER) Why = "was written with the other byte order";
+      else if (p < 1 || p > 65536 || H->FileCols < p) Why = "has a bad header";
+      for (k = 0; !Why && k < MOD_BLOCKS; k++)
+        if (H->Off[k] % 8 || H->Off[k] < sizeof(*H) || H->Off[k] > (uint64_t)Len
+            || Need[k] > ((uint64_t)Len - H->Off[k]) / sizeof(double))
+          Why = "is cut short or has a bad header";
+    }
+    if (!Why) {
+      Mod->Mean = (double *)(Buf + H->Off[MOD_MEAN]);
+      Mod->Scatter = (double *)(Buf + H->Off[MOD_SCATTER]);
+      Mod->Factor = (double *)(Buf + H->Off[MOD_FACTOR]);
+      Mod->Cols = (uint32_t *)(Buf + H->Off[MOD_COLS]);
+      for (j = 0; j < (int)p; j++)
+        if (Mod->Cols[j] < 1 || Mod->Cols[j] > H->FileCols
+            || (j && Mod->Cols[j] <= Mod->Cols[j-1])
+            || !(Mod->Factor[j*p + j] > 0.)) Why = "has a bad column list or factor";
+    }
+    if (!Why && (Mod->W = calloc(p * p, sizeof(double))) == NULL) Why = "is too big";
+    if (Why) {
+      snprintf(m->Error, MSG_LEN, "%s %s", File, Why);
+      MO_Free_Model(Mod);
+      return MO_ERROR;
+    }
+    /* W: the inverse of the lower triangular factor, a column at a time */
+    for (j = 0; j < (int)p; j++) {
+      Mod->W[j*p + j] = 1. / Mod->Factor[j*p + j];
+      for (i = j+1; i < (int)p; i++) {
+        for (Sum = 0., k = j; k < i; k++) Sum += Mod->Factor[i*p + k] * Mod->W[k*p + j];
+        Mod->W[i*p + j] = -Sum / Mod->Factor[i*p + i];
+      }
+    }
+    *Model = Mod;
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+void MO_Free_Model(struct MO_Model *Mod)
+{
+    if (!Mod) return;
+    free(Mod->Buf); free(Mod->W);
+    free(Mod);
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Model_Info(const struct MO_Model *Mod, int *p, int *FileCols,
+                  double *Cut)
+{
+    if (p) *p = (int)Mod->H.p;
+    if (FileCols) *FileCols = (int)Mod->H.FileCols;
+    if (Cut) *Cut = Mod->H.FinalCut;
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Model_Cols(const struct MO_Model *Mod, int *Cols)
+{
+    int j;
+
+    for (j = 0; j < (int)Mod->H.p; j++) Cols[j] = (int)Mod->Cols[j];
+    return MO_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+int MO_Score_File(struct MultOut *m, struct MO_Model *Mod, char *InFile,
+                  char *OutFile)
+{
+    jmp_buf Jump;
+    char *Save = m->ColSpec;
+
+    Call_Enter(m, &Jump);
+    if (setjmp(Jump)) {
+      ColSpec = Save;
+      return Call_Leave(m, CallCode);
+    }
+    Begin_Run();
+    if (StreamMode) {
+      Log_Printf("\n*error* -stream cannot be used to score\n\n");
+      Fail(MO_USAGE);
+    }
+#   ifdef _OPENMP
+      if (Threads) omp_set_num_threads(Threads);
+#   endif
+    ColSpec = NULL;              /* the model has its own columns */
+    if (!strcmp(InFile, "-")) Score_Stream(Mod, OutFile);
+    else Score_File(Mod, InFile, OutFile);
+    ColSpec = Save;
+    return Call_Leave(m, MO_OK);
+}
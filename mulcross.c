@@ -26,10 +26,13 @@
 #include <math.h>
 #include <assert.h>
 #include <memory.h>
+#include <string.h>
+#include <stdint.h>
 
 #define BANNER "mulcross version 1.00\nCopyright 1993,94,96 by David L. Woodruff and David M. Rocke\n"
 
 #define DATAFILE "MULCROSS.DAT"   /* data output file */
+#define BINFILE "MULCROSS.BIN"    /* the same, with -b */
 #define STATSFILE "MULCROSS.STT"    /* statistics */
 #define PARMSFILE "GEN.PRM"   /* problem parameters */
 #define SEEDFILE "SEED.DAT"   /* random number seed */
@@ -39,6 +42,10 @@ void Give_Info()
   printf("This program reads parameters from a file named exactly %s\n",PARMSFILE);
   printf("It reads a integer random number seed with 1 to 5 digits from %s\n",SEEDFILE);
   printf("This seed file is overwritten with a psuedo-random seed by the program\n");
+  printf("unless the seed is given on the command line: mulcross [-b] [seed]\n");
+  printf("(so that concurrent runs do not share %s)\n",SEEDFILE);
+  printf("With -b the data go to %s as a binary matrix (full precision)\n",
+         BINFILE);
   printf("Data is output to %s and statistics to %s\n",DATAFILE, STATSFILE);
   printf("The parameters file (%s) should contain P N A D\n",PARMSFILE);
   printf("Where P is the dimension, N is the number of points\n");
@@ -77,6 +84,8 @@ double *XSave;         /* scratch space */
 #   define XSaveof(i,j) *(XSave+(i-1)*VectLen+j-1) /* col major...*/
 
 long seed;      /* URan seed */
+int SeedSet = 0;  /* seed came from the command line; leave SEEDFILE alone */
+int Binary = 0;   /* write BINFILE instead of DATAFILE */
 double Lambda;              /* covariance matrix multiplier */
 
 /*----------------------------------------------------------------------------*/
@@ -106,6 +115,82 @@ double v1,v2,r;
    return(mu + sd * (v1 * sqrt(-2.0 * log(r)/r)));
 }
 
+/*--------------------------------------------------------------------------*/
+/* batch normal deviates by the ziggurat method (Marsaglia and Tsang 2000, */
+/* in Doornik's 2005 form: 128 layers, driven by (0,1) uniforms) */
+/* Zig_Init must be called once before Norm_Fill */
+#define ZIG_C 128                   /* layers */
+#define ZIG_R 3.442619855899        /* where the tail starts */
+#define ZIG_V 9.91256303526217e-3   /* area of each layer */
+#define ZIG_BATCH 256               /* deviates per fast path pass */
+double ZigX[ZIG_C+1];               /* layer edges; ZigX[0] is V/f(R) */
+double ZigR[ZIG_C];                 /* ZigX[i+1]/ZigX[i], the box part */
+
+void Zig_Init()
+{
+  int i;
+  double f = exp(-0.5 * ZIG_R * ZIG_R);
+
+  ZigX[0] = ZIG_V / f;
+  ZigX[1] = ZIG_R;
+  ZigX[ZIG_C] = 0.;
+  for (i=2; i<ZIG_C; i++) {
+    ZigX[i] = sqrt(-2. * log(ZIG_V / ZigX[i-1] + f));
+    f = exp(-0.5 * ZigX[i] * ZigX[i]);
+  }
+  for (i=0; i<ZIG_C; i++) ZigR[i] = ZigX[i+1] / ZigX[i];
+}
+
+/*--------------------------------------------------------------------------*/
+double Zig_Slow(int i, double u, long *z)
+/* finish a deviate that missed the box of layer i at position u */
+{
+  double x, y, f0, f1;
+
+  for (;;) {
+    if (fabs(u) < ZigR[i]) return u * ZigX[i];
+    if (i == 0) {                   /* the tail beyond ZIG_R */
+      do {
+        x = log(URan(z)) / ZIG_R;
+        y = log(URan(z));
+      } while (-2. * y < x * x);
+      return u < 0. ? x - ZIG_R : ZIG_R - x;
+    }
+    x = u * ZigX[i];                /* the wedge */
+    f0 = exp(-0.5 * (ZigX[i] * ZigX[i] - x * x));
+    f1 = exp(-0.5 * (ZigX[i+1] * ZigX[i+1] - x * x));
+    if (f1 + URan(z) * (f0 - f1) < 1.) return x;
+    u = 2. * URan(z) - 1.;
+    i = (int)(URan(z) * ZIG_C);
+  }
+}
+
+/*--------------------------------------------------------------------------*/
+void Norm_Fill(double *x, int cnt, long *z)
+/* fill x[0..cnt-1] with standard normal deviates, use seed z */
+/* the uniforms are drawn first (the generator is serial), then the box */
+/* test is a branch free loop the compiler can vectorize; only the ~1% */
+/* of misses go through Zig_Slow */
+{
+  double u[ZIG_BATCH];
+  int k[ZIG_BATCH], Miss[ZIG_BATCH];
+  int i, m, Base;
+
+  for (Base = 0; Base < cnt; Base += m) {
+    m = cnt - Base < ZIG_BATCH ? cnt - Base : ZIG_BATCH;
+    for (i=0; i<m; i++) {
+      u[i] = 2. * URan(z) - 1.;
+      k[i] = (int)(URan(z) * ZIG_C);
+    }
+    for (i=0; i<m; i++) {
+      x[Base+i] = u[i] * ZigX[k[i]];
+      Miss[i] = fabs(u[i]) >= ZigR[k[i]];
+    }
+    for (i=0; i<m; i++)
+      if (Miss[i]) x[Base+i] = Zig_Slow(k[i], u[i], z);
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 double Chi2_At_Pt001(int v)
 /* return the v deg. of freed. 0.001 point of a chi square*/
@@ -173,7 +258,7 @@ void Load_Parms()
            PARMSFILE);
     exit(1);
   }
-  if ((f = fopen(SEEDFILE,"r")) == NULL) {
+  if (!SeedSet && (f = fopen(SEEDFILE,"r")) == NULL) {
     Give_Info();
     printf("Could not open seed file %s for read\n",SEEDFILE);
     exit(1);
@@ -185,19 +270,17 @@ void Load_Parms()
      printf("warning: setting lambda to %lf\n",Lambda);
    }
 
-  fscanf(f,"%ld",&seed);
-  fclose(f);
+  if (!SeedSet) {
+    fscanf(f,"%ld",&seed);
+    fclose(f);
+  }
 }
 
 /*-------------------------------------------------------------------------*/
 void Generate_Data()
 /* generate the data (see comments at top of file) */
 {
-    int row, col;       /* to loop */
-
-  for (row = 1; row <= XCnt; row++)
-   for (col = 1; col <= VectLen; col++)
-    Xof(row,col) =  Norm((double)0.,(double)1.,&seed);
+  Norm_Fill(X, XCnt * VectLen, &seed);
 }
 
 /*-------------------------------------------------------------------------*/
@@ -211,7 +294,7 @@ void Pollute()
   double *DirVect;            /* direction vector */
   int SampStart;              /* first polluted sample index */
                  
-  DirVect = malloc((VectLen+1)*sizeof(float)); ALLCHK(DirVect)               
+  DirVect = malloc((VectLen+1)*sizeof(double)); ALLCHK(DirVect)               
   PollDist = NumUnits * sqrt(Chi2_At_Pt001(VectLen) / VectLen);
   SampStart = XCnt - PollCnt + 1;
   for (Samp = SampStart; Samp <=XCnt; Samp++) {
@@ -220,9 +303,72 @@ void Pollute()
       for (i=1; i<=VectLen; i++) 
         if (URan(&seed) > 0.5) DirVect[i] = -1.; else DirVect[i] = 1.;
     }
-    for (i=1; i<=VectLen; i++) {
-        Xof(Samp, i) = Norm(PollDist*DirVect[i], sqrt(Lambda), &seed);
-    }
+    Norm_Fill(&Xof(Samp, 1), VectLen, &seed);
+    for (i=1; i<=VectLen; i++) 
+        Xof(Samp, i) = PollDist*DirVect[i] + sqrt(Lambda) * Xof(Samp, i);
+  }
+}
+
+/*-------------------------------------------------------------------------*/
+/* binary matrix files: a 64 byte header, then the values in native */
+/* byte order (the header says which way round and how they are laid out) */
+/* (the same format as in multout.c, which reads them) */
+#define MAT_MAGIC "MOUTMAT1"
+#define MAT_ORDER 0x01020304U   /* reads differently on the other byte order */
+#define MAT_F64 1               /* Dtype: double */
+#define MAT_F32 2               /*        float */
+#define MAT_ROWS 0              /* Layout: row major (like X) */
+#define MAT_COLS 1              /*         column major */
+struct MatHeader {
+  char Magic[8];                /* MAT_MAGIC (no NUL) */
+  uint32_t Order;               /* MAT_ORDER */
+  uint32_t Dtype, Layout;
+  uint32_t p;                   /* columns */
+  uint64_t n;                   /* rows */
+  uint64_t Offset;              /* of the first value (64) */
+  uint64_t Checksum;            /* Mat_Checksum of the values */
+  char Pad[16];                 /* zero */
+};
+
+/*-------------------------------------------------------------------------*/
+uint64_t Mat_Checksum(char *v, size_t Len)
+/* FNV-1a, 64 bits, taken over 8 byte words (then a 4 byte tail) */
+{
+  uint64_t h = 0xCBF29CE484222325ULL, w;
+  uint32_t t;
+  size_t i;
+
+  for (i=0; i+8<=Len; i+=8) {
+    memcpy(&w, v+i, 8);
+    h = (h ^ w) * 0x100000001B3ULL;
+  }
+  if (i+4 <= Len) {
+    memcpy(&t, v+i, 4);
+    h = (h ^ t) * 0x100000001B3ULL;
+  }
+  return h;
+}
+
+/*-------------------------------------------------------------------------*/
+void Write_Matrix(char *Name, double *V, int p, int n)
+/* write the n by p row major V as a binary matrix file */
+{
+  struct MatHeader H;
+  FILE *f;
+  size_t Bytes = (size_t)p * n * sizeof(double);
+
+  memset(&H, 0, sizeof(H));
+  memcpy(H.Magic, MAT_MAGIC, 8);
+  H.Order = MAT_ORDER;
+  H.Dtype = MAT_F64; H.Layout = MAT_ROWS;
+  H.p = (uint32_t)p; H.n = (uint64_t)n;
+  H.Offset = sizeof(H);
+  H.Checksum = Mat_Checksum((char *)V, Bytes);
+  if ((f = fopen(Name, "wb")) == NULL
+      || fwrite(&H, sizeof(H), 1, f) != 1
+      || fwrite(V, 1, Bytes, f) != Bytes || fclose(f)) {
+    printf("Could not write %s\n", Name);
+    exit(1);
   }
 }
 
@@ -233,6 +379,10 @@ void Write_Data()
   FILE *f;        /* input file stream record */
   int row,col;      /* to loop */
 
+  if (Binary) {
+    Write_Matrix(BINFILE, X, VectLen, XCnt);
+    return;
+  }
   if ((f = fopen(DATAFILE,"w")) == NULL) {
     Give_Info();
     printf("Could not open %s for write\n",DATAFILE);
@@ -551,7 +701,7 @@ void Generate_Permutation(int N, int *p)
 }
                      
 /**************************************************************************/
-int main()
+int main(int argc, char *argv[])
 {
   FILE *f;           /* to update seed file */
   int i,j,k, row, col; /* loop indexes (cannablized code)*/
@@ -560,6 +710,16 @@ int main()
   double Det; /* to ignore the determinant...*/
 
   printf(BANNER);
+  if (argc > 1 && !strcmp(argv[1], "-b")) {
+    Binary = 1;
+    argv++; argc--;
+  }
+  if (argc > 2 || (argc == 2 && (seed = atol(argv[1])) <= 0)) {
+    Give_Info();
+    exit(1);
+  }
+  SeedSet = argc == 2;
+  Zig_Init();
   Load_Parms();
   Make_Room();
   Permutation = malloc(XCnt * sizeof(int)); ALLCHK(Permutation)
@@ -594,14 +754,19 @@ int main()
   for (row=0; row<XCnt; row++)
      fprintf(f,"point %4d: %.4E\n", row+1, *(SqResiduals+row));
   fclose(f);
-  if ((f = fopen(SEEDFILE,"w")) == NULL) {
-      printf("Could not open %s for write\n",SEEDFILE);
-      exit(1);
-  }
-  fprintf(f,"%ld\n",seed);
-  fclose(f);
   printf("done.\n");
-  printf("Parameters read from %s; seed file, %s, read and updated\n",
+  if (SeedSet) printf("Parameters read from %s; seed %ld\n", PARMSFILE,
+                      atol(argv[1]));
+  else {
+    if ((f = fopen(SEEDFILE,"w")) == NULL) {
+        printf("Could not open %s for write\n",SEEDFILE);
+        exit(1);
+    }
+    fprintf(f,"%ld\n",seed);
+    fclose(f);
+    printf("Parameters read from %s; seed file, %s, read and updated\n",
            PARMSFILE, SEEDFILE);
-  printf("Data is in %s, statistics are in %s\n",DATAFILE, STATSFILE);
+  }
+  printf("Data is in %s, statistics are in %s\n",Binary ? BINFILE : DATAFILE,
+         STATSFILE);
 }
@@ -5,1643 +5,1076 @@
 /* THERE IS NO WARRANTY OF ANY KIND */
 /* This software may be freely distributed for non-commercial use. */
 
-/* Compilation Notes: */
-/* 1. This is a single file C program using only standard libraries */
-/* 2. You will need the -lm linker switch on most Unix and related systems */
-/* 3. You will almost surely need to use a large memory model on a 16 bit PC */
-
-/* Other Notes: */
-/* 0. This program assumes that the data are in general position */
-/* 1. see the function Info_Exit() for usage instructions */
-/* 2. see the paper "Idenfication of Outliers in Multivariate Data" */
-/*    by Rocke and Woodruff for detailed explanations */
-/* 3. the program gencross.c can generate test data */
-/* 4. The optional parms file is for experts only; see Load_Parms() */
-/* 5. If the outlier detection phase is too slow, */
-/*    you can increase the simulation tolerance (the last parm) */
-/* 6. Singularities in the data are not handled very well (see 0.)*/
-/* 7. send questions to dlwoodruff@ucdavis.edu; (916)752-0515 */
-
-#define BANNER "multout version 3.03.1\nCopyright 1992,93,94,95,96 by David L. Woodruff and David M. Rocke\n"
-
-/* Release Notes: */
-/* 
-Differences between 2.00.04 and 3.00
-1. The program outputs an M-Estimate of location and shape before beginning
-   the simulations for outlier cutoff and the file is closed. Hence, the
-   program can be killed during the simulations and useful output will
-   be present.
-2. The program outputs the final estimate of location and shape used to 
-   generate the robust distances.
-*/
-/*3.01 
-1. One error message preceded by *error* 
-2. exit(1) if singularity is encountered 
-3. iterations is now an optional command line arg
-*/
-/* 3.02
-1. changes in singularity messages
-*/
-/* 3.03 changes in comments */
-
-#include <stdio.h>       /* magical incantations */
+/* the command line program: the estimator itself is libmultout.c (see */
+/* multout.h); this just hands it the arguments */
+
+#include <stdio.h>
 #include <stdlib.h>
-#include <malloc.h>
+#include <string.h>
 #include <math.h>
-#include <assert.h>
-#include <memory.h>
-#include <search.h>
-#include <float.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include "multout.h"
+
+#define REPORT_BUF (1 << 20)            /* as in libmultout.c */
+#define MAX_OPTS 64                     /* options passed on to batch jobs */
+#define ERR_LEN 256                     /* a batch job's error message */
+#define True -1
+#define False 0
+
+/* batch and group modes: the jobs, and the options each worker's */
+/* context is given */
+struct Job {
+    char *In, *Out, *Parms;             /* the manifest line */
+    long Iters;
+    char *Key, *Name;                   /* group mode: the key, the report's */
+    double KeyVal;                      /*   name for the data */
+    double *X;                          /*   and the group's rows */
+    int Cols;
+    long Rows;
+    int Code;                           /* MO_OK or how it failed */
+    int p;
+    long n, Outliers;                   /* Outliers < 0: not known */
+    double Cut1, Cut2, Secs;
+    char Error[ERR_LEN];
+};
+struct Job *Jobs;
+int JobCnt, NextJob = 0, Failed = 0;
+pthread_mutex_t JobLock = PTHREAD_MUTEX_INITIALIZER;
+char *Opts[MAX_OPTS];
+int OptCnt = 0;
 
 /*------------------------------------------------------------------*/
-void Info_Exit()
-/* give the user some hints, then exit */
+FILE *Report_To_Stdout(struct MultOut *m)
+/* outfile "-": the report keeps stdout, the progress messages move to */
+/* stderr so that the report can be piped; returns the report's stream */
 {
-  printf("Usage: multout infile outfile [iterations [parmsfile]]\n\n");
-  printf(" where infile contains: p n\n"); 
-  printf("                        data record one (p data elements)\n");
-  printf("                        data record two\n");
-  printf("                            . . . \n");
-  printf("and iterations is an integer controlling the time spent.\n");
-  printf("For light contamination use 1 iteration; for heavy,");
-  printf(" try (n)(p) or more.\n");
-  printf("If it is not specified, (n)(p) is used.\n");
-  printf("\nExample: multout suspect.dat suspect.out 10000\n");
-  exit(1);
-}
-/*------------------------------------------------------------------*/
+    FILE *f;
+    int fd;
 
-/* parms */
-int Lambda;                             /* target partition size */
-float Cut1, Cut2;                       /* for outlier ID */
-float SimTol;
-
-/* define the algorithm begin used */
-#define BaseSubSampleSize (int)(XCnt/2)       /* whence we "lap" */
-/* define the means of evaluating a partition as SCRIT or MVECRIT */
-
-/*#include "std.c"*/
-
-/* to allow compilation of the same code on the DECstations */
-/* set host ULTRIX or PC */
-#define PC 1
-#define ULTRIX 2
-
-#define HOST ULTRIX
-/* version 6: Ultrix really means OSF/1 */
-#if HOST == ULTRIX
-#   define far                          /* no need for memory kludges */
-#   define _fmalloc malloc              /* ditto */
-#   define _ffree free
-#endif
-
-#define True -1 			/* for use in */
-#define False 0 			/* setting vars only  */
-
-#define SEEDFILE "SEED.DAT"		/* to allow variations in seed */
-
-#define ALLCHK(x) if (x == NULL) {printf ("allocation error\n"); assert(x);}
-#define NTOL (double)0.00001            /* newton tolerance */
-#define WTOL (double)0.001              /* weight convergence tolerance */
-/*#define LTOL 1./(double)(XCnt*VectLen)*/  /* lambda tolerance */
-#define LTOL 1./(double)VectLen            /* lambda tolerance */ /*12/21/92*/
-#define NTIMEOUT 100                    /* max newton iters */
-#define GMULT 1.2                       /* controls ghost precision */
-#define dabs(x) (((x) < 0.) ? -(x) : (x))
-
-/* shared parms */
-int Trace;			  /* controls debug trace dump info */
-long ItersAllowed;
-/* run time parm (for all but simulated annealing) */
-float Cut1, Cut2;                       /* for outlier ID */
-
-/* global data */
-int VectLen;			  /* number of attributes */
-int XCnt;			  /* number of observations */
-double *X;			  /* The observations */
-#define XRow(i) (X+(i-1)*VectLen)
-#define Xof(i,j) *(X+(i-1)*VectLen+j-1) /* X[i,j] */
-double InstanceID = 0.;   /* to hash an instance ID using Diag of data */
-
-/* the J set is defined by non-zero JBit indicators */
-int *JBits;			  /* indicators for J set (squander bits) */
-int *BestJBits;			  /* best XJ seen so far */
-int *OnesList, *ZerosList;	  /* indexes of bits set and zero */
-double *XBarJ;			  /* x bar values for the J set */
-#define XBarJof(i) *(XBarJ+i-1)   /* XBarJ[i] */
-double *XJ;			  /* data matrix corresp. to J set */
-#define XJof(i,j) *(XJ+(i-1)*VectLen+j-1) /* XJ[i,j] */
-double *ZJ;			  /* e concat XJ */
-#define ZJof(i,j) *(ZJ+(i-1)*(VectLen+1)+j-1) /* ZJ[i,j] */
-
-/* covariance matrix, rectangular space to facilitate GJ inversion */
-/* the inverse is going to be in the right half of the C matrix, so */
-/* space is not allocated, just a macro to get at the data */
-double *C;			  /* COLUMN MAJOR covariance matrix */
-#define Cof(i,j) (*(C+(i-1)+(j-1)*VectLen))  /* C[i,j] */
-double *A;			  /* ZZt */
-#define Aof(i,j) (*(A+(i-1)+(j-1)*(VectLen+1)))  /* A[i,j] */
-double Determinant;    /* the product of the pivots, in this case */
-#define C_1of(i,j) *(C+VectLen*VectLen+(i-1)+(j-1)*VectLen)	/* C-1[i,j] */
-#define A_1of(i,j) *(A+(VectLen+1)*(VectLen+1)+(i-1)+(j-1)*(VectLen+1))
-long SingularCnt=0;		  /* count the number of Det=0 seen */
-
-/* many of these vectors are global only to make dynamic allocation easy */
-/* the so-called sqresiduals vector is the squared mahalanobis distances */
-double *SqResiduals;   /* squared distances, zero based */
-double *kSqSpace;      /* for sorting in compute_k */
-double *dTilde;        /* modified distances (used in s estimation) */
-double *wVector;       /* weights vector stored to save comp. & test converg.*/
-double *OldwVector;    /* last iteration's wieght vector */
-double Sumw, Sumv;     /* save some time in M iterations */
-double mJ2;	       /* the left hand side of Rouss...(1.24) */
-double c1=0., b0=0.;    /* "constants" for S estimation " */
-double M=0.;           /* "constant" for t-biweight */
-double ActualBP;       /* breakdown point implied by c and b0 <= RequestedBP */
-double *uAu;           /* local to the descent routine */
-/* also need a record for the times when we want to know who is at the dist */
-struct ResidRec{
-    double SqMahalDist; 	  /* distance to the point */
-    int SampleNum;		  /* index into X */
-};
-struct ResidRec *ResidRecs;	  /* to be used whenever needed */
-
-/* minimization variables */
-double ObjectiveValue;		  /* to be minimized */
-double BestObjectiveValue;	  /* to keep score */
-
-/* Random Number generator declarations */
-#define Ua (long)1317	  /*a,b, and c are for URan*/
-#define Ub (long)27699
-#define Uc (long)131072
-long seed;			  /* random number seed (running) */
-long SeedSave;                    /* so we have the original seed as ID */
-
-/* enhanced algorithm declarations */
-#   define HALFWAY (VectLen + 1) / 2 + XCnt / 4  /*between p+1 and 1/2 samp*/
-
-/* forward declarations */
-double Compute_k();
-void Set_c_and_b0();
-double rho(double d);
-void Standardize_X();
-void Use_Algo_Rej_Code();  // have assumed n==XCnt
-void Pre_Check_Data();
-
-int i_i;  /* to be used by copy macro */
-#define Copy(x,y,z) for (i_i=0; i_i<(z); i_i++) x[i_i] = y[i_i]
-
-/*---------------------------------------------------------------------------*/
-double URan( long *seed)
-/*return a uniform 0,1 rv using and returning the seed*/
-{
-   do *seed = (Ua * *seed + Ub) % Uc; while (*seed == 0);
-   return((double)*seed	/ (double)Uc);
+    fflush(stdout);
+    if ((fd = dup(1)) < 0 || (f = fdopen(fd, "w")) == NULL
+        || dup2(2, 1) < 0) {
+      printf("Could not send the report to stdout\n");
+      exit(1);
+    }
+    setvbuf(f, NULL, _IOFBF, REPORT_BUF);
+    MO_Report(m, f);
+    return f;
 }
 
-/*--------------------------------------------------------------------------*/
-double Norm(double mu, double sd, long *z)
-/* return a normal deviate with mean mu and std dev sd,
-   use seed z */
-/* just waste a deviate... */
-
+/*------------------------------------------------------------------*/
+double Job_Clock()
 {
-double v1,v2,r;
-
-   do {
-     v1 = 2.0 * URan(z) - 1.;
-     v2 = 2.0 * URan(z) - 1.;
-     r = v1*v1 + v2*v2;
-   } while (r >= 1.0);
-   return(mu + sd * (v1 * sqrt(-2.0 * log(r)/r)));
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
 }
 
-/*-------------------------------------------------------------------------*/
-void Load_Data(char *DATAFILE)
-/* make and load the Data matrix */
-/* the input file is assumed to be line records with the first two */
-/* values the integer vector length and the number of observations */
-/* X array is ROW MAJOR!!! */
+/*------------------------------------------------------------------*/
+void Read_Manifest(char *Name)
+/* Jobs from the manifest: a line per job, "infile outfile [iterations */
+/* [parmsfile]]"; blank lines and lines starting with # are skipped */
 {
-    FILE *f;			  /* input file stream record */
-    int spot;			  /* to loop */
-    int r;                        /* for error detection */
+    FILE *f;
+    char *Buf, *Line, *Next, *Field[5];
+    long Len;
+    int k, LineNo = 0;
 
-    if ((f = fopen(DATAFILE,"r")) == NULL) {
-	printf("\nCould not open %s for read\n\n",DATAFILE);
-	Info_Exit();
+    if ((f = fopen(Name, "r")) == NULL) {
+      printf("\nCould not open the manifest %s for read\n", Name);
+      exit(1);
     }
-    fscanf(f,"%d %d",&VectLen, &XCnt);
-    if (XCnt <= VectLen) {
-      printf("\n*error* For vectors of length %d, there must be at least %d points\n\n",
-		VectLen, VectLen+1);
-	Info_Exit();
+    fseek(f, 0L, SEEK_END);
+    Len = ftell(f);
+    rewind(f);
+    if ((Buf = malloc(Len + 1)) == NULL
+        || (Jobs = calloc(Len / 4 + 1, sizeof(struct Job))) == NULL) {
+      printf("allocation error\n");
+      exit(1);
     }
-    X = malloc(VectLen*XCnt*sizeof(double));
-    ALLCHK(X)
-
-    for (spot=0; spot<VectLen*XCnt; spot++) fscanf(f,"%lf",X+spot);
+    Buf[fread(Buf, 1, Len, f)] = 0;
     fclose(f);
-
-    if ((f = fopen(SEEDFILE,"r")) == NULL) {
-	printf("\nCould not open the seed file %s for read\n",SEEDFILE);
-        printf("This file should contain an integer between 1 and 100000.\n");
-        exit(1);
-    }
-    r = fscanf(f,"%ld",&seed);
-    if (r != 1) {
-	printf("\nCould not read the seed from %s\n",SEEDFILE);
-        printf("This file should contain an integer between 1 and 100000.\n");
+    JobCnt = 0;
+    for (Line = Buf; Line; Line = Next) {
+      if ((Next = strchr(Line, '\n')) != NULL) *Next++ = 0;
+      LineNo++;
+      for (k = 0; k < 5 && (Field[k] = strtok(k ? NULL : Line, " \t\r")); k++);
+      if (k == 0 || Field[0][0] == '#') continue;
+      if (k < 2 || k > 4 || (k > 2 && atol(Field[2]) < 0)) {
+        printf("\n*error* Bad manifest line %d: it should be\n", LineNo);
+        printf("infile outfile [iterations [parmsfile]]\n");
         exit(1);
+      }
+      Jobs[JobCnt].In = Field[0];
+      Jobs[JobCnt].Out = Field[1];
+      Jobs[JobCnt].Iters = k > 2 ? atol(Field[2]) : -1;
+      Jobs[JobCnt].Parms = k > 3 ? Field[3] : NULL;
+      JobCnt++;
     }
-    SeedSave = seed;
-    fclose(f);
-
-    Set_c_and_b0();
-    Pre_Check_Data();
 }
 
-/*-------------------------------------------------------------------------*/
-void Dump_Data(char *msg)
-/* dump the X array */
+/*------------------------------------------------------------------*/
+void Job_Results(struct MultOut *m, struct Job *j)
+/* what the summary index shows of a job that ran */
 {
-    int row, col;
-
-    printf("Dump of X data array %s\n",msg);
-    for (row=1; row<=XCnt; row++) {
-	for (col=1; col<=VectLen; col++) printf("%E ",Xof(row,col));
-	printf("\n");
-    }
+    unsigned char *Flag;
+    long i;
+
+    MO_Dims(m, &j->p, &j->n);
+    MO_Cutoffs(m, &j->Cut1, &j->Cut2);
+    j->Outliers = -1;               /* a -stream run keeps no flags */
+    if (MO_Distances(m, NULL, NULL, NULL) != MO_OK
+        || (Flag = malloc(j->n)) == NULL) return;
+    MO_Distances(m, NULL, Flag, NULL);
+    for (j->Outliers = i = 0; i < j->n; i++) j->Outliers += Flag[i];
+    free(Flag);
 }
 
-/*-------------------------------------------------------------------------*/
-void Make_Room()
-/* allocate space for global data structures */
-/* everything is made, no matter what you are doing .... */
+/*------------------------------------------------------------------*/
+void *Worker(void *Arg)
+/* run jobs until there are none left; the context is kept from job to */
+/* job, so a job with the same n and p as the last reuses its space */
+/* (and the library remembers every cutoff it has found) */
 {
-    JBits = malloc((XCnt)*sizeof(int));
-    ALLCHK(JBits)
-    OnesList = malloc(XCnt*sizeof(int));
-    ALLCHK(OnesList)
-    ZerosList = malloc(XCnt*sizeof(int));
-    ALLCHK(ZerosList)
-    BestJBits = malloc(XCnt*sizeof(int));
-    ALLCHK(BestJBits)
-    XBarJ = malloc(VectLen*sizeof(double));
-    ALLCHK(XBarJ)
-    XJ = malloc((XCnt)*VectLen*sizeof(double)); /* lots of room */
-    ALLCHK(XJ)
-    ZJ = malloc(sizeof(double)*(size_t)XCnt*(size_t)(VectLen+1)); /* lots */
-    ALLCHK(ZJ)
-    C = malloc(VectLen*VectLen*2*sizeof(double));
-    ALLCHK(C)
-    A = malloc((VectLen+1)*(VectLen+1)*2*sizeof(double));
-    ALLCHK(A)
-    SqResiduals = malloc((XCnt)*sizeof(double));
-    ALLCHK(SqResiduals)
-    kSqSpace = malloc((XCnt)*sizeof(double));
-    ALLCHK(kSqSpace)
-    dTilde = malloc((XCnt)*sizeof(double));
-    ALLCHK(dTilde)
-    wVector = malloc((XCnt)*sizeof(double));
-    ALLCHK(wVector)
-    OldwVector = malloc((XCnt)*sizeof(double));
-    ALLCHK(OldwVector)
-    ResidRecs = malloc((XCnt)*sizeof(struct ResidRec));
-    ALLCHK(ResidRecs)
-    uAu = malloc((XCnt+1)*sizeof(double));
-    ALLCHK(uAu)    
-}
+    struct MultOut *m;
+    struct Job *j;
+    int i;
+    double t;
+    char *s;
 
-/*-------------------------------------------------------------------------*/
-void Check_Bits(int JCnt, char *msg)
-/* debug tool */
-{
-   int OPos, ZPos;  /* to loop through substring lists */
-   int i, locj;     /* to loop through JBits */
-
-    locj = 0;
-    for (i=0; i<XCnt; i++) locj += *(JBits+i);
-    if (locj != BaseSubSampleSize) {
-        printf("There are only %d bits rather than %d in J\n",locj,BaseSubSampleSize);
-        printf("%s\n",msg);
-        for (i=0; i<XCnt; i++) printf("%d ",*(JBits+i)); printf("\n");
-        exit(1);
-    }
-    for (OPos=0; OPos < JCnt; OPos++) if (!(*(JBits+*(OnesList+OPos)))) {
-        printf("zero bit Opos=%d, jbit pos is %d\n",OPos, *(OnesList+OPos));
-        printf("%s\n",msg);
-        exit(1);
+    (void)Arg;
+    if ((m = MO_New()) == NULL) {
+      printf("allocation error\n");
+      exit(1);
     }
-    for (ZPos=0; ZPos < JCnt; ZPos++) if ((*(JBits+*(ZerosList+ZPos)))) {
-        printf("one bit Zpos=%d, jbit pos is %d\n",ZPos, *(ZerosList+ZPos));
-        printf("%s\n",msg);
-        exit(1);
+    for (i = 0; i < OptCnt; i += MO_Option(m, Opts[i], Opts[i+1]));
+    for (;;) {
+      pthread_mutex_lock(&JobLock);
+      j = NextJob < JobCnt ? Jobs + NextJob++ : NULL;
+      pthread_mutex_unlock(&JobLock);
+      if (!j) break;
+      t = Job_Clock();
+      if (j->X) {
+        MO_Set_Data(m, j->X, j->Cols, j->Rows);
+        MO_Set_Name(m, j->Name);
+      }
+      if ((j->Code = MO_Run_Files(m, j->X ? NULL : j->In, j->Out, j->Iters,
+                                  j->Parms)) == MO_OK)
+        Job_Results(m, j);
+      else {
+        strncpy(j->Error, MO_Error(m), ERR_LEN - 1);    /* its first line */
+        j->Error[strcspn(j->Error, "\n")] = 0;
+        for (s = j->Error; *s; s++) if (*s == '\t') *s = ' ';
+      }
+      j->Secs = Job_Clock() - t;
+      pthread_mutex_lock(&JobLock);
+      if (j->Key) printf("Group %s (%ld rows): ", j->Key, j->Rows);
+      else printf("Job %d: %s ", (int)(j - Jobs) + 1, j->In);
+      if (j->Code == MO_OK) printf("done (%.2f seconds)\n", j->Secs);
+      else {
+        printf("failed: %s\n", j->Error);
+        Failed++;
+      }
+      fflush(stdout);
+      pthread_mutex_unlock(&JobLock);
     }
-    printf("bits OK: %s\n",msg);
-    for (i=0; i<XCnt; i++) printf("%d ",*(JBits+i)); printf("\n");
-}
-
-/*-------------------------------------------------------------------------*/
-void Create_SubString_Lists(const int JCnt)
-/* Update sub-string lists for ones and zeros in JBits	*/
-/* no need to clear first */
-/* JCnt is the size of the sub-sample */
-/* (this isn't as useful in genetic.c because we may never use them...)*/
-{
-    int row,oh=0,zee=0;			/* to loop */
-
-    for (row=0; row<XCnt; row++)
-	if (*(JBits+row)) *(OnesList+oh++) = row; else *(ZerosList+zee++)=row;
+    MO_Free(m);
+    return NULL;
 }
 
-/*-------------------------------------------------------------------------*/
-void Form_XJ()
-/* put rows in XJ corresponding to the J set indexes */
-/* note that the indicator set is zero based; also note row data vectors*/
+/*------------------------------------------------------------------*/
+void Write_Index(char *Name)
+/* the summary: a tab separated line per job, in manifest order (or */
+/* per group, in key order) */
 {
-    int Xrow, XJrow, col;		 /* to loop */
-
-    XJrow = 1;
-    for (Xrow = 1; Xrow <= XCnt; Xrow++) {
-	if (*(JBits+Xrow-1)) {
-	    for (col = 1; col <= VectLen; col++)
-		XJof(XJrow, col) = Xof(Xrow, col);
-	    /* the row index is in the J set */
-	    XJrow++;
-	}
-    }
-}
+    FILE *f;
+    struct Job *j;
 
-/*-------------------------------------------------------------------------*/
-void Form_ZJ(double *X)
-/* put rows in ZJ corresponding to the J set indexes */
-/* note that the indicator set is zero based; also note row data vectors*/
-/* X is provided as an argument to allow for ghost images */
-{
-    int Zrow, ZJrow, col;		 /* to loop */
-
-    ZJrow = 1;
-    for (Zrow = 1; Zrow <= XCnt; Zrow ++) {
-	if (*(JBits+Zrow-1)) {
-	    ZJof(ZJrow, 1) = 1;
-	    for (col = 2; col <= VectLen+1; col++)
-		ZJof(ZJrow, col) = Xof(Zrow, col-1);
-	    /* the row index is in the J set */
-	    ZJrow++;
-	}
+    if (!strcmp(Name, "-")) f = stdout;
+    else if ((f = fopen(Name, "w")) == NULL) {
+      printf("Could not open %s for write\n", Name);
+      exit(1);
     }
-}
-
-/*-------------------------------------------------------------------------*/
-void Dump_XJ(const int JCnt, char *msg)
-/* dump the bit map and the rows */
-/* JCnt is the size of the sub-sample */
-{
-    int row,col;	   /* to loop */
-
-    printf("J set and corresp. data matrix %s\n",msg);
-    for (row=0; row<XCnt; row++) printf("%2d",*(JBits+row));
-    printf("\n\n");
-    for (row=1; row<=JCnt; row++) {
-	for (col=1; col<=VectLen; col++) printf("%7E ",XJof(row,col));
-	printf("\n");
+    fprintf(f, "%s\tstatus\tp\tn\toutliers\tcutoff1\tcutoff2\tseconds\tinfile\toutfile\terror\n",
+            JobCnt && Jobs[0].Key ? "group" : "job");
+    for (j = Jobs; j < Jobs + JobCnt; j++) {
+      if (j->Key) fprintf(f, "%s", j->Key);
+      else fprintf(f, "%d", (int)(j - Jobs) + 1);
+      if (j->Code == MO_OK)
+        fprintf(f, "\tok\t%d\t%ld\t%ld\t%.6E\t%.6E", j->p, j->n,
+                j->Outliers, j->Cut1, j->Cut2);
+      else fprintf(f, "\tfailed\t\t\t\t\t");
+      fprintf(f, "\t%.3f\t%s\t%s\t%s\n", j->Secs, j->In, j->Out, j->Error);
     }
-}
-
-/*-------------------------------------------------------------------------*/
-void Dump_ZJ(const int JCnt, char *msg)
-/* dump the bit map and the rows */
-/* JCnt is the size of the sub-sample */
-{
-    int row,col;	   /* to loop */
-
-    printf("J set and corresp. ZJ:  %s\n",msg);
-    for (row=0; row<XCnt; row++) printf("%2d",*(JBits+row));
-    printf("\n\n");
-    for (row=1; row<=JCnt; row++) {
-	for (col=1; col<=VectLen+1; col++) printf("%7E ",ZJof(row,col));
-	printf("\n");
+    if (f != stdout && fclose(f)) {
+      printf("Could not write %s\n", Name);
+      exit(1);
     }
 }
 
-/*-------------------------------------------------------------------------*/
-void Compute_XBarJ(const int JCnt)
-/* compute XBarJ values (observations are "row" vectors) */
-/* JCnt is the size of the sub-sample */
-/* very simple */
+/*------------------------------------------------------------------*/
+void Run_Jobs(int Workers, int SeedSet)
+/* the Jobs on Workers threads (0: one per processor), in the order */
+/* they are in; SEED.DAT is read once here, not by every job */
 {
-    int row, col;		    /* to loop */
-#   define XBCOL *(XBarJ+col-1)	  /* typing aid */
+    static char Seed[32];
+    pthread_t *t;
+    FILE *f;
+    int i;
 
-    for (col=1; col<=VectLen; col++) {
-	XBCOL = XJof(1,col);
-	for (row=2; row<=JCnt; row++) XBCOL += XJof(row,col);
-	XBCOL = XBCOL / (JCnt);
+    if (!SeedSet && (f = fopen("SEED.DAT", "r")) != NULL) {
+      if (fscanf(f, "%31s", Seed) == 1 && OptCnt + 2 < MAX_OPTS) {
+        Opts[OptCnt++] = "-seed";
+        Opts[OptCnt++] = Seed;
+      }
+      fclose(f);
+    }
+    if (Workers < 1 && (Workers = (int)sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+      Workers = 1;
+    if (Workers > JobCnt) Workers = JobCnt;
+    if ((t = malloc((Workers + 1) * sizeof(pthread_t))) == NULL) {
+      printf("allocation error\n");
+      exit(1);
     }
+    printf("%d jobs on %d threads\n", JobCnt, Workers);
+    for (i = 0; i < Workers; i++)
+      if (pthread_create(t + i, NULL, Worker, NULL)) {
+        printf("Could not start a batch thread\n");
+        exit(1);
+      }
+    for (i = 0; i < Workers; i++) pthread_join(t[i], NULL);
+    free(t);
 }
 
-/*-------------------------------------------------------------------------*/
-void Dump_XBarJ(char *msg)
-/* display the estimate of the center */
+/*------------------------------------------------------------------*/
+void Run_Batch(char *Manifest, char *Index, int Workers, int SeedSet)
 {
-    int col;		    /* to loop */
-
-    printf("Dump of Mean for current J set: %s\n",msg);
-    for (col=1; col <= VectLen; col++) printf("  %E\n", XBarJof(col));
+    Read_Manifest(Manifest);
+    Run_Jobs(Workers, SeedSet);
+    Write_Index(Index);
+    printf("%d of %d jobs done; index written to %s\n", JobCnt - Failed,
+           JobCnt, Index);
 }
 
-/*-------------------------------------------------------------------------*/
-void Randomize_JBits(const int JCnt)
-/* produce random J bit settings */
-/* URan is to (0,1) not [0,1]; JBits is zero based */
-/* JCnt is the size of the sub-sample */
+/*------------------------------------------------------------------*/
+int Bigger_Group(const void *a, const void *b)
 {
-    int setsofar=0;	       /* keep track of number set */
-    int spot;		       /* element to consider setting */
+    const struct Job *x = a, *y = b;
 
-    memset(JBits, 0, (XCnt)*sizeof(int));
-
-    while (setsofar < JCnt) {
-	spot = (int)(URan(&seed) * XCnt);
-	if (!(*(JBits+spot))) {
-	    ++setsofar;
-	    ++(*(JBits+spot));
-	}
-    }
-}
-
-/*-------------------------------------------------------------------------*/
-void Form_C(const int JCnt)
-/* form the covariance matrix for XJ */
-/* JCnt is the size of the sub-sample */
-
-{
-    int i, j;		       /* current cell in C */
-    int k;		       /* to loop through samples */
-
-    for (i=1; i<=VectLen; i++) {
-	for (j=1; j<=i; j++) {
-	    Cof(i,j) = 0;
-	    for (k=1; k<=JCnt; k++) {
-		Cof(i,j) += (XJof(k,i) - XBarJof(i))
-			  * (XJof(k,j) - XBarJof(j));
-	    }
-	    Cof(i,j) = Cof(i,j) / (double)(JCnt - 1);
-	}
-    }
-    for (i=1; i<=VectLen;i++) for (j=i+1; j<=VectLen;j++) Cof(i,j) = Cof(j,i);
+    return (x->Rows < y->Rows) - (x->Rows > y->Rows);
 }
 
-/*-------------------------------------------------------------------------*/
-void Form_A(const int JCnt)
-/* form the ZJ * Trans(ZJ) */
-/* JCnt is size of half sample */
+int Lower_Key(const void *a, const void *b)
 {
-    int i, j;		       /* current cell in C */
-    int k;		       /* to loop through samples */
-
-    for (i=1; i<=VectLen+1; i++) {
-	for (j=1; j<=i; j++) {
-	    Aof(i,j) = 0;
-	    for (k=1; k<=JCnt; k++) {
-		Aof(i,j) += ZJof(k,i) * ZJof(k,j);
-	    }
-	}
-    }
-    for (i=1; i<=VectLen+1;i++) for (j=i+1; j<=VectLen+1;j++) Aof(i,j) = Aof(j,i);
-}
+    const struct Job *x = a, *y = b;
 
-/*-------------------------------------------------------------------------*/
-void Dump_C(char *msg)
-/* dump the C matrix (COLUMN MAJOR storage, but output the usual way) */
-{
-    int i,j;	/* to loop */
-    printf("Entire rectangle: %s\n",msg);
-    for (i=0; i<VectLen; i++) {
-	for (j=0; j<2*VectLen; j++) printf("%.2E ",*(C+i+j*VectLen));
-	printf("|\n");
-    }
+    return (x->KeyVal > y->KeyVal) - (x->KeyVal < y->KeyVal);
 }
 
-/*-------------------------------------------------------------------------*/
-void InvertC(double *C, int VectLen, double *Determinant)
-/* things are getting a bit hacked up here..... */
-/* assume C is VectLen by VectLen */
-/* C must have room for another square on the right */
-/* do Gauss-Jordon Elimination on C*x(j) = e(j); Strang 29 */
-/* see also page 38 (no use exchanging rows since PDS) */
-/* keep a running product of the pivots as the determinant of C */
-/* (later, try to do something more efficient (e.g. use Symm)) */
-/* COLUMN MAJOR arrays, look out... */
-/* pivots are left in original C space, result is on ``right'' side */
-
+/*------------------------------------------------------------------*/
+void Split_Groups(char *InFile, char *OutFile, long Iters, char *Parms,
+                  double *x, int p, long n, int Col)
+/* a job for each distinct value in column Col of the n by p data x: */
+/* one pass over the rows finds each one's group (by hashing the key) */
+/* and counts the groups, then the rows are copied, group after group, */
+/* into one block */
 {
-    /* "locals" */
-    int pivotrow, row, col;	/* to loop */
-    double Pivot;		/* C[pivotrow, pivotrow]	*/
-    double m;			/* multiplier */
-
-    /* put I in the right half */
-    for (row=1; row <= VectLen; row++)
-	for (col = VectLen+1; col <= 2*VectLen; col++)
-	    if (col == row+VectLen) Cof(row,col) = 1.; else Cof(row,col) = 0.;
-
-    /* forward elimination */
-    *Determinant = 1;   /* running product */
-    for (pivotrow = 1; pivotrow < VectLen; pivotrow++) {
-	if (Cof(pivotrow,pivotrow) <= 0.0) {
-	    /*printf("bad pivot at row %d, you lose\n",pivotrow);*/
-	    *Determinant = 0;
-	    return;
-	}
-	else { /* non-zero pivot in C[row,row] */
-	    Pivot = Cof(pivotrow, pivotrow);   /* two uses for pivot */
-	    for (row = pivotrow+1; row <= VectLen; row++) {
-		m = Cof(row, pivotrow) / Pivot;
-		for (col = pivotrow; col <= VectLen+pivotrow; col++) { 
-                    /* assumes no zero pivots shuffles!!!*/
-		    Cof(row,col) = Cof(row,col) - m * Cof(pivotrow,col);
-		}
-	    }
-	}
-	*Determinant *= Pivot;
-
+    int *Of, g, G = 0;                  /* each row's group, the groups */
+    int *Slot;                          /* hash table of groups */
+    long *Start, i, Size, h;
+    double *Block, Key;
+    uint64_t Bits;
+    char Buf[64];
+
+    for (Size = 16; Size < 2 * n; Size *= 2);
+    if ((Of = malloc(n * sizeof(int))) == NULL
+        || (Slot = malloc(Size * sizeof(int))) == NULL
+        || (Start = calloc(n + 1, sizeof(long))) == NULL
+        || (Jobs = calloc(n, sizeof(struct Job))) == NULL
+        || (Block = malloc((size_t)n * p * sizeof(double))) == NULL) {
+      printf("allocation error\n");
+      exit(1);
     }
-    *Determinant *= Cof(VectLen, VectLen);
-    if (!*Determinant) {return;}
-
-    /* back substitution, pivots are non-zero, so use them */
-    for (pivotrow = 2; pivotrow <=VectLen; pivotrow++){
-	Pivot = Cof(pivotrow, pivotrow);
-	for (row = 1; row < pivotrow; row++) {
-	    if (Cof(row,pivotrow)) {
-		m = Cof(row,pivotrow) / Pivot;
-		for (col = pivotrow; col <= VectLen+pivotrow; col++) {
-		    Cof(row,col) = Cof(row,col) - m*Cof(pivotrow, col);
-		}
-	    }
-	}
+    for (h = 0; h < Size; h++) Slot[h] = -1;
+    for (i = 0; i < n; i++) {
+      Key = x[i*p + Col-1];
+      if (Key == 0.) Key = 0.;          /* -0 is 0 */
+      if (Key != Key) Key = NAN;        /*   and every nan the same */
+      memcpy(&Bits, &Key, sizeof(Bits));
+      h = (long)((Bits * 0x9E3779B97F4A7C15ULL) >> 32) & (Size - 1);
+      for (; (g = Slot[h]) >= 0
+             && memcmp(&Jobs[g].KeyVal, &Key, sizeof(Key)); h = (h+1) & (Size-1));
+      if (g < 0) {
+        Slot[h] = g = G++;
+        Jobs[g].KeyVal = Key;
+      }
+      Of[i] = g;
+      Start[g+1]++;
     }
-
-    /* finally, divide the rows in the inverse by the pivots */
-    for (row = 1; row <= VectLen; row++)
-	for (col = VectLen+1; col <= 2*VectLen; col++)
-	    Cof(row, col) = Cof(row,col) / Cof(row,row);
-}
-
-/*-------------------------------------------------------------------------*/
-void InvertA(double *A, int VL, double *Determinant)
-/* things are getting a bit hacked up here..... */
-/* (what is needed is a few moments to write a general invert.... */
-/* this is hideous (we pass in VL+1 or else.... */
-/* see InvertC for details*/
-{
-    /* "locals" */
-    int pivotrow, row, col;	/* to loop */
-    double Pivot;		/* A[pivotrow, pivotrow]	*/
-    double m;			/* multiplier */
-
-    /* put I in the right half */
-    for (row=1; row <= VL; row++)
-	for (col = VL+1; col <= 2*VL; col++)
-	    if (col == row+VL) Aof(row,col) = 1; else Aof(row,col) = 0;
-
-    /* forward elimination */
-    *Determinant = 1;   /* running product */
-    for (pivotrow = 1; pivotrow < VL; pivotrow++) {
-	if (!Aof(pivotrow,pivotrow)) {
-	    /* printf("zero pivot at row %d, you lose\n",pivotrow); */
-	    *Determinant = 0;
-	    return;
-	}
-	else {
-	    /* non-zero pivot in A[row,row] */
-	    Pivot = Aof(pivotrow, pivotrow);   /* two uses for pivot */
-	    for (row = pivotrow+1; row <= VL; row++) {
-		m = Aof(row, pivotrow) / Pivot;
-		for (col = pivotrow; col <= VL+pivotrow; col++) { /* assumes no zero pivots shuffles!!!*/
-		    Aof(row,col) = Aof(row,col) - m * Aof(pivotrow,col);
-		}
-	    }
-	}
-	*Determinant *= Pivot;
-
+    for (g = 0; g < G; g++) Start[g+1] += Start[g];
+    for (g = 0; g < G; g++) {
+      Jobs[g].X = Block + Start[g] * p;
+      Jobs[g].Cols = p;
     }
-    *Determinant *= Aof(VL, VL);
-    if (!*Determinant) return;
-
-    /* back substitution, pivots are non-zero, so use them */
-    for (pivotrow = 2; pivotrow <=VL; pivotrow++){
-	Pivot = Aof(pivotrow, pivotrow);
-	for (row = 1; row < pivotrow; row++) {
-	    if (Aof(row,pivotrow)) {
-		m = Aof(row,pivotrow) / Pivot;
-		for (col = pivotrow; col <= VL+pivotrow; col++) {
-		    Aof(row,col) = Aof(row,col) - m*Aof(pivotrow, col);
-		}
-	    }
-	}
+    for (i = 0; i < n; i++) {           /* Rows counts what is in so far */
+      g = Of[i];
+      memcpy(Jobs[g].X + Jobs[g].Rows++ * p, x + i*p, p * sizeof(double));
     }
-
-    /* finally, divide the rows in the inverse by the pivots */
-    for (row = 1; row <= VL; row++)
-	for (col = VL+1; col <= 2*VL; col++)
-	    Aof(row, col) = Aof(row,col) / Aof(row,row);
-}
-
-/*-------------------------------------------------------------------------*/
-int Compare_doubles(const void *arg1, const void *arg2)
-/* compare *arg1 and *arg2 as per qsort needs */
-/* assume that doubles can never really be equal */
-{
-    if (*(double*)arg1 < *(double*)arg2) return(-1); else return(1);
-}
-
-/*--------------------------------------------------------------------------*/
-void Compute_Distance_Vector()
-/* compute a squared distance vector (called SqResiduals) for the current C_1
- and sub-sample
-*/
-{
-    double rowsum;	      /* to accumulate rightmost mult first */
-    int i;		      /* index into vector being formed */
-    int row, col;	      /* indexes for vector matrix mult. */
-			      /* (row and col refer to c-1) */
-
-    for (i=1; i<=XCnt; i++) {
-        *(SqResiduals+i-1) = 0.;
-	for (row = 1; row <= VectLen; row++) {
-	   rowsum = 0;
-	   for (col = 1; col <= VectLen; col++) {
-	     rowsum += (Xof(i,col) - XBarJof(col)) * C_1of(row,col);
-	   }
-	   *(SqResiduals+i-1) += rowsum * (Xof(i,row) - XBarJof(row));
-	}
+    for (g = 0; g < G; g++) {
+      snprintf(Buf, sizeof(Buf), "%.15g", Jobs[g].KeyVal);
+      if (strtod(Buf, NULL) != Jobs[g].KeyVal && Jobs[g].KeyVal == Jobs[g].KeyVal)
+        snprintf(Buf, sizeof(Buf), "%.17g", Jobs[g].KeyVal);  /* exact */
+      if ((Jobs[g].Key = strdup(Buf)) == NULL
+          || (Jobs[g].Name = malloc(strlen(InFile) + strlen(Buf) + 10)) == NULL
+          || (Jobs[g].Out = malloc(strlen(OutFile) + strlen(Buf) + 2)) == NULL) {
+        printf("allocation error\n");
+        exit(1);
+      }
+      sprintf(Jobs[g].Name, "%s, group %s", InFile, Buf);
+      sprintf(Jobs[g].Out, "%s.%s", OutFile, Buf);
+      Jobs[g].In = InFile;
+      Jobs[g].Iters = Iters;
+      Jobs[g].Parms = Parms;
     }
+    JobCnt = G;
+    free(Of); free(Slot); free(Start); free(x);
 }
 
-/*-------------------------------------------------------------------------*/
-void Compute_mJ2()
-/* replace the word "median" with (n+p+1)/2 percentile */
-/* compute a vector that represents the argument to the med in 1.24 */
-/* then find sqrt of its median and place it in global mJ */
-/* note that the vector is declared globally for mindless dynamic allocation*/
-/* (Could form vectors to save a subtraction at the expense of an assignment*/
-/* and loop control; if you have a vector processor, you may want to do it) */
+/*------------------------------------------------------------------*/
+int Lists_Col(char *Spec, int Col)
+/* True if the -cols list Spec (like 1,4,7-9) takes in column Col */
 {
-    Compute_Distance_Vector();
-    qsort(SqResiduals, XCnt, sizeof(double), Compare_doubles);
-    mJ2 = *(SqResiduals+(XCnt+VectLen+1)/2);
-}
+    char *q = Spec, *e;
+    long a, b;
 
-/*-------------------------------------------------------------------------*/
-double Mahalanobis_Dist(int SampNo)
-/* find the squared mahalanombis distance to the sample SampNo (not 0 based) */
-/* using the current C inverse and the current X bar */
-{
-    double rowsum;	      /* to accumulate rightmost mult first */
-    double RetVal=0.;	      /* to collect the distance (squared) */
-    int row, col;	      /* indexes for vector matrix mult. */
-			      /* (row and col refer to c inverse) */
-
-    for (row = 1; row <= VectLen; row++) {
-	rowsum = 0.;
-	for (col = 1; col <= VectLen; col++) {
-	    rowsum += (Xof(SampNo,col) - XBarJof(col)) * C_1of(row,col);
-	}
-	RetVal += rowsum * (Xof(SampNo,row) - XBarJof(row));
-    }
-    return RetVal;
+    do {
+      a = b = strtol(q, &e, 10);
+      if (e != q && *e == '-') b = strtol(q = e+1, &e, 10);
+      if (a <= Col && Col <= b) return True;
+      q = e + 1;
+    } while (*e == ',');
+    return False;
 }
 
-/*-------------------------------------------------------------------------*/
-void Record_Best()
-/* the global variable ObjectiveValue < BestObjectiveValue so do some
-   bookkeeping */
+/*------------------------------------------------------------------*/
+void Run_Groups(char *InFile, char *OutFile, long Iters, char *Parms,
+                int Col, int Workers, int SeedSet, char *ColSpec)
+/* group mode: a full analysis of each group of rows with the same value */
+/* in column Col, on Workers threads; the reports go to OutFile.key, */
+/* and the summary of them all to OutFile. The biggest groups are */
+/* started first, so that the small ones fill in around them. With */
+/* -cols (ColSpec), those columns are used, and they must leave out Col */
 {
-    int i, cntj;                   /* to count bits */
-
-    BestObjectiveValue = ObjectiveValue;
-    Copy(BestJBits, JBits, XCnt);
-    cntj = 0;
-    for (i=0; i<XCnt; i++) cntj += *(JBits+i);
-    if (cntj != BaseSubSampleSize) {
-        printf("wrong number of bits in best %d\n",cntj);
-        for (i=0; i<XCnt; i++) printf("%d ",*(JBits+i));
-        exit(1);
+    static char Cols[64];               /* all the columns but Col */
+    struct MultOut *m;
+    double *x;
+    int p;
+    long n;
+
+    if ((m = MO_New()) == NULL) {
+      printf("allocation error\n");
+      exit(1);
     }
-    if (Trace) printf("Objective Value Reduced to %14.9lf\n", ObjectiveValue);
-    if (Trace) {for (i=0; i<XCnt; i++) printf("%d ",*(JBits+i)); printf("\n");}
-}
-
-/*---------------------------------------------------------------------------*/
-void Process_JBits(const int JCnt)
-/* Given JBits, do all the calculations	*/
-{
-    int debcnt=0;  /* debug count */
-
-    Form_ZJ(X);
-    Form_A(JCnt);
-    InvertA(A, VectLen+1, &Determinant);
-    ObjectiveValue = Determinant;   /* LOOK! unscaled by 1/(n-h)^(p+1) */
-    if (Determinant <= (double)0.0) {
-	printf("Singular Covariance matrix");
-	printf("Determinant = %E\n", Determinant);
-	Dump_ZJ(JCnt, "zero determinant");
-	printf("End of zero determinant dump\n");
-	ObjectiveValue = 10 * ObjectiveValue;  /* try to stay out */
-	SingularCnt++;
-//	return;
-        exit(1);
+    MO_Log(m, stdout);
+    if (MO_Load(m, InFile, &x, &p, &n) != MO_OK) exit(1);
+    MO_Free(m);
+    if (Col > p || p == 1) {
+      printf("\n*error* -group %d: %s has %d columns; the group column must be\n",
+             Col, InFile, p);
+      printf("one of them, and not the only one\n");
+      exit(1);
     }
-
-    if (!ObjectiveValue) {
-	printf("Zero objective value\n");
-	printf("Determinant = %E, mJ2=%E\n", Determinant, mJ2);
-	Dump_XJ(JCnt, "Zero objective Value");
-	printf("End of zero objective value dump\n");
-	exit(1);
+    if (ColSpec && Lists_Col(ColSpec, Col)) {
+      printf("\n*error* -cols %s takes in the group column %d; every group\n",
+             ColSpec, Col);
+      printf("would be constant in it\n");
+      exit(1);
     }
-    if (ObjectiveValue < BestObjectiveValue){
-	Record_Best();
+    if (!ColSpec && OptCnt + 2 < MAX_OPTS) {
+      if (Col == 1) sprintf(Cols, "2-%d", p);
+      else if (Col == p) sprintf(Cols, "1-%d", p-1);
+      else sprintf(Cols, "1-%d,%d-%d", Col-1, Col+1, p);
+      Opts[OptCnt++] = "-cols";
+      Opts[OptCnt++] = Cols;
     }
+    Split_Groups(InFile, OutFile, Iters, Parms, x, p, n, Col);
+    qsort(Jobs, JobCnt, sizeof(struct Job), Bigger_Group);
+    Run_Jobs(Workers, SeedSet);
+    qsort(Jobs, JobCnt, sizeof(struct Job), Lower_Key);
+    Write_Index(OutFile);
+    printf("%d of %d groups done; index written to %s\n", JobCnt - Failed,
+           JobCnt, OutFile);
 }
 
-/*---------------------------------------------------------------------------*/
-double rho(double d)
-/* compute the rho function, use conditional compilition for more forms...*/
-/* assume that c is global */
-/* change this to a macro for slight speed up */
-{
-    double d2,c2,c4,d4,M2,M4;	/* intermediate calcs */
-    double retval;		/* debugging */
-
-   if (d > (M + c1)) return(M*M/2. + c1 * (5.*c1 + 16.*M)/30.);
-   else if (d >= M) {
-     d2 = d*d; d4 = d2*d2;
-     c2 = c1*c1; c4 = c2*c2;
-     M2 = M*M; M4 = M2*M2;
-     retval = M2/2. - M2 * (M4 - 5.*M2*c2 + 15.*c4)/(30.*c4)
-	      +d2*(0.5 + M4/(2*c4) - M2/c2)
-	      +d*d2*(4*M/(3*c2) - 4*M2*M/(3*c4))
-	      +d4*(3*M2/(2*c4) - 1/(2*c2))
-	      -4*M*d*d4/(5*c4) + d4*d2/(6*c4);
-     return(retval);
-   }
-   else return(d*d/2.);
-}
-
-/*---------------------------------------------------------------------------*/
-double psi(double d)
-/* compute the psi function, use conditional compilition for more forms...*/
-/* assume that c is global */
-/* change this to a macro for slight speed up */
+/*------------------------------------------------------------------*/
+int Score(struct MultOut *m, char *ModelFile, char *InFile, char *OutFile)
+/* score mode: the rows of InFile against a fitted model */
 {
-    double inner;   /* intermediate calc */
+    struct MO_Model *Mod;
+    int r;
 
-   if (d > (M + c1)) return(0.);
-   else if (d >= M) {
-     inner = 1. - ((d-M)/c1)*((d-M)/c1);
-     return(d * inner * inner);
-   } else return(d);
+    if (MO_Read_Model(m, ModelFile, &Mod) != MO_OK) {
+      printf("\n*error* %s\n\n", MO_Error(m));
+      return MO_ERROR;
+    }
+    r = MO_Score_File(m, Mod, InFile, OutFile);
+    MO_Free_Model(Mod);
+    return r;
 }
 
-/*---------------------------------------------------------------------------*/
-double w(double d)
-/* compute the weight function, use conditional compilition for more forms...*/
-/* assume that c1 is global */
-/* change this to a macro for slight speed up */
-{
-    double inner;   /* intermediate calc */
-
-   if (d > (M + c1)) return(0.);
-   else if (d >= M) {
-     inner = 1 - ((d-M)/c1)*((d-M)/c1);
-     return(inner * inner);
-   } else return(1.);
-}
+/*------------------------------------------------------------------*/
+/* serve mode: models kept in memory and scored for other processes on */
+/* a Unix domain socket. A request is a Req header, the model's name */
+/* and n rows of p doubles; the reply is a Rep header, then n distances */
+/* (double) and n flags (uint8), or for an info request the model's */
+/* column numbers (int32), or for a refusal the message. p may be the */
+/* model's p or the number of columns of its data file (its columns */
+/* are then picked out). All in native byte order */
+#define REQ_MAGIC "MOSQ"
+#define REP_MAGIC "MOSR"
+#define OP_SCORE 1
+#define OP_INFO 2
+#define SERVE_MAX (1L << 28)    /* bytes of values a request may send */
+#define SERVE_POLL 1            /* seconds between model file checks */
+#define SERVE_STALL 10          /* seconds a request may take to arrive */
+#define CLIENT_ROWS 65536       /* rows a -client request sends */
+struct Req {
+    char Magic[4];              /* REQ_MAGIC */
+    uint32_t Op;                /* OP_SCORE or OP_INFO */
+    uint32_t NameLen;           /* the model's name (no NUL) follows */
+    uint32_t p;                 /* values per row */
+    uint64_t n;                 /* rows (0 for OP_INFO) */
+};
+struct Rep {
+    char Magic[4];              /* REP_MAGIC */
+    int32_t Status;             /* MO_OK, or MO_ERROR and a message */
+    uint32_t p, FileCols;       /* the model's */
+    uint64_t n;                 /* rows scored, or the message length */
+    double Cut;                 /* squared distance cutoff */
+};
+struct Loaded {                 /* a model as read, and the requests */
+    struct MO_Model *Mod;       /*   that are using it */
+    int Refs;
+};
+struct Served {
+    char *File, *Name;          /* Name: File without its directory */
+    struct Loaded *Cur;
+    struct stat St;             /* of File when Cur was read */
+};
+struct Space {                  /* a serve worker's buffers, kept from */
+    double *X, *Sel, *Dist;     /*   request to request (they only grow) */
+    unsigned char *Flag;
+    int *Cols;
+    size_t Vals, Rows, p;       /* what they have room for */
+};
+struct Served *Models;
+int ModelCnt;
+pthread_mutex_t ModelLock = PTHREAD_MUTEX_INITIALIZER;
+int Listener;
+int Work[2], Back[2];           /* pipes of connections with a request */
+char *SockPath;                 /*   waiting, and of those served */
 
-/*---------------------------------------------------------------------------*/
-double Compute_k()
-/* find the k value to enforce the constraint (see Rocke paper) */
-/* assumes the distances vector, SqResiduals, has been computed */
+/*------------------------------------------------------------------*/
+struct Loaded *Load_Model(struct MultOut *m, char *File)
+/* NULL if File does not read (the reason is m's error) */
 {
-    double k;                   /* newton converge on k (return val) */
+    struct Loaded *L;
 
-    Copy(kSqSpace, SqResiduals, XCnt);
-    qsort(kSqSpace, XCnt, sizeof(double), Compare_doubles);
-    k = sqrt(*(kSqSpace+(XCnt+VectLen+1)/2)) / M;
-    return(k);     
-}
-
-/*---------------------------------------------------------------------------*/
-void Compute_wVector_and_Sums()
-/* (for s estimation iteration) find a k value and then adjust the distances*/
-/* Assume that b0 is global */
-/* the result is placed in the global vector dTilde */
-/* note: cute math, fk = mean(rho(d/k)) and dfk = -mean(psi(d/k)*d/k^2)
-/* also pre-compute the results of calls to the w function */
-{
-    double k;                   /* newton converge on k*/
-    int i;                      /* to loop for sums */
-
-    k = Compute_k();
-    Sumw = Sumv = 0.;
-    for (i=0; i<XCnt; i++) { 
-        Sumw += (*(wVector+i) = w((*(dTilde+i) = sqrt(*(SqResiduals+i))/k)));
-        Sumv += (*(wVector+i)) * (*(SqResiduals+i) / (k*k));
+    if ((L = malloc(sizeof(struct Loaded))) == NULL) {
+      printf("allocation error\n");
+      exit(1);
+    }
+    L->Refs = 0;
+    if (MO_Read_Model(m, File, &L->Mod) != MO_OK) {
+      free(L);
+      return NULL;
     }
+    return L;
 }
 
-/*---------------------------------------------------------------------------*/
-void M_Iterate()
-/* given a C matrix, iterate to an M estimate */
-/* note that this routines abuses many data structures, in particular,
-   XBarJ is used as the iterated mean and C is adjusted as well
-*/
-/* assumes that c and b0 have been set */
+/*------------------------------------------------------------------*/
+struct Loaded *Use_Model(char *Name)
+/* the model called Name, held for a request (NULL: there is none) */
 {
-    int i,j,k;                        /* to loop */
-    double MaxWDelta;                 /* max delta of a wieight element */
-    long siters=0;                    /* to time out on iterations */
+    struct Loaded *L = NULL;
+    int i;
 
-    Sumw = 0;
-    for (i=0; i<XCnt; i++) *(OldwVector+i) = 1.;
-    do {
-        InvertC(C, VectLen, &Determinant);
-        if (Determinant <= 0.0) {
-            printf("Singular Covariance matrix\n");
-	        printf("Determinant = %E\n", Determinant);
-            printf("w vector\n");
-            for (j = 0; j <XCnt; j++) printf("%E ",*(wVector+j));
-            printf("\n");
-	        printf("End of zero determinant dump from M_Iterate\n");
-            exit(1);
-        }
-        Compute_Distance_Vector();
-        Compute_wVector_and_Sums();
-        for (j = 1; j <= VectLen; j++) {
-            XBarJof(j) = 0.;
-            for (i=0; i < XCnt; i++) XBarJof(j) += (*(wVector+i)) * Xof(i+1,j);
-            XBarJof(j) = XBarJof(j) / Sumw;
-	    }
-        for (i=1; i<=VectLen; i++) { /* sorry about the use of k for i */
-	    for (j=1; j<=i; j++) {
-	        Cof(i,j) = 0;
-   	        for (k=1; k<=XCnt; k++) {
-		    Cof(i,j) += (*(wVector+k-1))
-                              * (Xof(k,i) - XBarJof(i))
-			      * (Xof(k,j) - XBarJof(j));
-	        }
-	        Cof(i,j) = VectLen * Cof(i,j) / Sumv;
-	    }
-        }
-        for (i=1; i<=VectLen;i++) 
-            for (j=i+1; j<=VectLen;j++) 
-                Cof(i,j) = Cof(j,i);
-        MaxWDelta = 0.;
-        for (i=0; i<XCnt; i++) {
-            if (dabs((*(wVector+i)) - (*(OldwVector+i))) > MaxWDelta)
-                MaxWDelta = dabs((*(wVector+i)) - (*(OldwVector+i)));
-            *(OldwVector+i) = *(wVector+i);
-	}
-        if (siters++ > (long)(1./(float)WTOL)) {
-            printf("Time out in M convergence, MaxWDelta = %lf, WTOL = %lf\n",
-                   MaxWDelta, WTOL);
-            break;
-	}
-    } while (MaxWDelta > WTOL); /* wgts converge */
+    pthread_mutex_lock(&ModelLock);
+    for (i = 0; i < ModelCnt; i++)
+      if (!strcmp(Models[i].Name, Name)) {
+        L = Models[i].Cur;
+        L->Refs++;
+        break;
+      }
+    pthread_mutex_unlock(&ModelLock);
+    return L;
 }
 
-/* --------------------------------------------------------------------------*/
-double xp(float p)
-/* return inverse of normal (approx. Abromowitz and Stegun 941 */
+/*------------------------------------------------------------------*/
+void Done_Model(struct Loaded *L)
+/* a request is finished with L: it goes once no request is using it */
+/* and a newer one has replaced it */
 {
-  double t;
-  if (p > (float)0.5) p = (float)1.-p;
-  t = sqrt(log(1/(p*p)));
-#define a0 2.30753
-#define a1 0.27061
-#define b1 0.99229
-#define b2 0.04481
-  return t - (a0 + a1*t) / (1+b1*t+b2*t*t);
-#undef a0
-#undef a1
-#undef b1
-#undef b2
+    int i, Gone;
+
+    pthread_mutex_lock(&ModelLock);
+    Gone = --L->Refs == 0;
+    for (i = 0; Gone && i < ModelCnt; i++) if (Models[i].Cur == L) Gone = 0;
+    pthread_mutex_unlock(&ModelLock);
+    if (Gone) {
+      MO_Free_Model(L->Mod);
+      free(L);
+    }
 }
 
-/* --------------------------------------------------------------------------*/
-double ChiSq_1(int v, float x)
-/* return the x point of a v degree chi square (e.g., its inverse)*/
-/* (approx. Abromowitz and Stegun 932 */
-/* only above the median */
+/*------------------------------------------------------------------*/
+int Changed(struct stat *a, struct stat *b)
 {
-  double inner;
-  inner =  1. - 2./(9.*v) + xp(x) * sqrt((double)2./(double)(9.*v));
-  return v * inner * inner * inner;
+    return a->st_ino != b->st_ino || a->st_size != b->st_size
+           || a->st_mtim.tv_sec != b->st_mtim.tv_sec
+           || a->st_mtim.tv_nsec != b->st_mtim.tv_nsec;
 }
 
-/* --------------------------------------------------------------------------*/
-float ChiSq(int v, double D, double tol)
-/* return the v degree chi square by searching the inverse */
+/*------------------------------------------------------------------*/
+void Check_Models(struct MultOut *m)
+/* read again any model file that changed; requests already using the */
+/* old model finish with it. If the new file does not read, the old */
+/* model stays until the file changes again */
 {
-  int i=0;  /* debug... get rid of this */
-  float bot, top, mid;  /* for binary search */
-  double d;             /* mid dist */
-  bot = (float)0.5;
-  top = (float)1. - (float)tol;
-  if ((D > ChiSq_1(v, top)) || (D < ChiSq_1(v, bot))) {
-    printf("Cannot find chiSq(%d) for %lf (tol=%lf)\n", v, D, tol);
-    exit(1);
-  }
-  mid = (top+bot)/(float)2.;
-  while ((dabs((d = (double)ChiSq_1(v, mid))-D) > tol) && (++i<20)) {
-    if (d > D) top = mid; else bot = mid;
-    mid = (top + bot) / (float)2.;
-  }
-  return(mid);
-}
-
-
-/*---------------------------------------------------------------------------*/
-void Set_c_and_b0()
-/* set the values of c and M using rough approximations */
-/* ignore the requested breakdown point */
-/* no longer b0 because we are no longer using S */
-{    
-    double MPlusc;  /* F^-1(1-arp) */
-
-    MPlusc = ChiSq_1(VectLen, (float)0.999);
-    M = sqrt(ChiSq_1(VectLen, (float)(XCnt+VectLen+1)/(float)(2*XCnt)));
-    c1 = sqrt(MPlusc) - M;
-    ActualBP = 0.;  /* not used */
+    struct Served *s;
+    struct Loaded *L, *Old;
+    struct stat St;
+
+    for (s = Models; s < Models + ModelCnt; s++) {
+      if (stat(s->File, &St) || !Changed(&St, &s->St)) continue;
+      s->St = St;
+      if ((L = Load_Model(m, s->File)) == NULL) {
+        printf("*error* %s (the model loaded before is kept)\n", MO_Error(m));
+        fflush(stdout);
+        continue;
+      }
+      pthread_mutex_lock(&ModelLock);
+      Old = s->Cur;
+      s->Cur = L;
+      if (Old->Refs) Old = NULL;        /* Done_Model frees it */
+      pthread_mutex_unlock(&ModelLock);
+      if (Old) {
+        MO_Free_Model(Old->Mod);
+        free(Old);
+      }
+      printf("Reloaded %s\n", s->File);
+      fflush(stdout);
+    }
 }
 
-/*-------------------------------------------------------------------------*/
-int Compare_Resids(const void *arg1, const void *arg2)
-/* compare *arg1 and *arg2 as per qsort needs */
-/* assume that doubles can never really be equal */
+/*------------------------------------------------------------------*/
+int Get_All(int fd, void *Buf, size_t Len)
+/* read Len bytes; False at the end of the stream or on an error */
 {
-  if (((struct ResidRec *)arg1)->SqMahalDist 
-      < ((struct ResidRec *)arg2)->SqMahalDist) 
-        return(-1); else return(1);
+    char *p = Buf;
+    ssize_t r;
+
+    while (Len) {
+      if ((r = read(fd, p, Len)) <= 0) {
+        if (r < 0 && errno == EINTR) continue;
+        return False;
+      }
+      p += r;
+      Len -= r;
+    }
+    return True;
 }
 
-/*---------------------------------------------------------------------------*/
-double Sq_Rej_Dist(int n, float a, float tol, int UseAlgo)
-/* useit controls use of the iterative estimator */
-/* find the distance to reject fraction a; WRECKS Xbar, C,etc; */
-/* ASSUMES VectLen */
+/*------------------------------------------------------------------*/
+int Put_All(int fd, const void *Buf, size_t Len)
+/* write Len bytes (a closed peer is an error, not a SIGPIPE) */
 {
-  double sofar, oldsofar;  // these are cutoffs (sq distances)
-  int cnt, row, col;
-  int XCntSave;
-  double far *XSave;
-  int Blocks, Blk, Sector, CutCnt;
-  double *BigSqSpace;
-
-  assert(n > VectLen); assert(n <= XCnt);
-  if (a<=0.) return HUGE_VAL;
-  if (a>=1.) return 0.;
-
-  XSave = _fmalloc(VectLen*XCnt*sizeof(double)); ALLCHK(XSave)
-  Copy(XSave, X, XCnt * VectLen);
-  XCntSave = XCnt;
-  XCnt = n;
-
-  Blocks = (int) (10./((float)XCnt * a));  /* for small a */
-  if (Blocks < 40) Blocks = 40;
-  Sector = Blocks * XCnt;
-  CutCnt = (int)(a * (float)Sector);
-  BigSqSpace = malloc(Sector * sizeof(double)); ALLCHK(BigSqSpace)
-
-  cnt = 0;
-  sofar = oldsofar = 0.;
-  do {
-    for (Blk = 0; Blk < Blocks; Blk++) {
-      for (row = 1; row <= XCnt; row++)
-       for (col = 1; col <= VectLen; col++)
-        Xof(row, col) = XJof(row,col) =  Norm((double)0.,(double)1.,&seed);
-      Compute_XBarJ(n);
-      Form_C(n);
-      /* overall, the next line is brutal hack... */
-      if (UseAlgo) Use_Algo_Rej_Code();  // have assumed n==XCnt...
-      InvertC(C, VectLen, &Determinant);
-      Compute_Distance_Vector();  // of len XCnt
-      for (row=0; row<XCnt; row++) BigSqSpace[Blk*XCnt+row] = SqResiduals[row];
+    const char *p = Buf;
+    ssize_t r;
+
+    while (Len) {
+      if ((r = send(fd, p, Len, MSG_NOSIGNAL)) <= 0) {
+        if (r < 0 && errno == EINTR) continue;
+        return False;
+      }
+      p += r;
+      Len -= r;
     }
-    qsort(BigSqSpace, Sector, sizeof(double), Compare_doubles);
-    oldsofar = sofar;
-    sofar += (BigSqSpace[Sector-CutCnt]+BigSqSpace[Sector-CutCnt-1])/2.;
-    if (++cnt > 100) break;
-    if (Trace) printf ("ID sector cnt=%d, sofar=%lf\n",cnt, sofar);
-  } while ((cnt < 2) 
-            || (dabs(oldsofar/(cnt-1) - sofar/cnt) / (sofar/cnt) > tol));
-  XCnt = XCntSave;
-  Copy(X, XSave, XCnt * VectLen);
-  _ffree(XSave); free(BigSqSpace);
-  return sofar/cnt;
+    return True;
 }
 
-/*---------------------------------------------------------------------------*/
-float ID_Good(float a1, float a2)
-/* on input, the distance vector must be ready to use */
-/* on output, set JBits set for nominally good points */
-/* return the cutoff distance */
-/* do a two step using a1 and a2 as fraction to reject */
-/* this routine is very fragile (as noted) */
-/* all the globals make it a hack */
+/*------------------------------------------------------------------*/
+int Refuse(int fd, struct Rep *r, char *Msg)
+/* a reply of Msg instead of scores */
 {
-  double far *SqSave; // to save "real" data
-  int XCntSave;
-  double CutPt1, CutPt2;  // cutoff for sq dist
-  int i,n;       // index and temp data size
-
-  SqSave = _fmalloc(XCnt*sizeof(double)); ALLCHK(SqSave)
-  Copy(SqSave, SqResiduals, XCnt);
-
-  CutPt1 = Sq_Rej_Dist(XCnt, a1, SimTol, True); // wreck the globals...
-  n = 0;
-  for (i=0; i<XCnt; i++) 
-    if (SqSave[i] < CutPt1) {JBits[i] = 1; ++n;}
-    else JBits[i]=0;
-  if (Trace) printf("first cut uses %E and leaves %d\n",CutPt1, n);
-  if (n <= VectLen) {
-    printf("Warning: too few points kept with cutoff fraction %f\n", a1);
-    n = XCntSave;
-  } else {
-    Form_XJ();
-    Compute_XBarJ(n);
-    Form_C(n);
-    InvertC(C, VectLen, &Determinant);
-    Compute_Distance_Vector();
-  } 
-  CutPt2 = ChiSq_1(VectLen, ((float)1.-a2));
-  CutPt2 
-    /= ChiSq(VectLen+2, 
-       ChiSq_1(VectLen, (float)(1.-a1)), (float)0.001)/(float)(1.-a1);
-  n = 0;
-  for (i=0; i<XCnt; i++) {
-    if (Trace) printf("%d %f\n",i,(float)SqSave[i]);
-    if (SqResiduals[i] < CutPt2) {JBits[i] = 1; ++n;}
-    else JBits[i]=0;
-  }
-  if (Trace) printf("second cut uses %E and leaves %d\n",CutPt2, n);
-  if (n <= VectLen) {
-    printf("WARNING: Too few points kept with cutoff fraction %f\n", a2);
-  }
-  _ffree(SqSave);
-  return (float)CutPt2;
+    r->Status = MO_ERROR;
+    r->n = strlen(Msg);
+    return Put_All(fd, r, sizeof(struct Rep)) && Put_All(fd, Msg, r->n);
 }
 
-/*---------------------------------------------------------------------------*/
-double Comp_uAu(int uInd)
-/* to get give the determint multiplier
-   assume that the inverse of A is available
-   see Hawkins FSA paper for notation
-   As of Jan 27, 1994:
-*/
+/*------------------------------------------------------------------*/
+int Grow_Space(struct Space *w, size_t Vals, size_t Rows, size_t p)
+/* room in w for a request; False if there is not the memory (a request */
+/* fails, not the server) */
 {
-    double uau=0;                 /* intermediate vector x inverse prods */
-    double rowsumau;              /* to accumulate rightmost mult first */
-			          /* (row and col refer to c inverse) */
-    int p1, locuInd;
-    double *locA1Start;
-    int i,j;
-#define uauZof(i,j) (j==1 ? 1 : Xof(i,j-1))  /* inefficient */
-/*
-    for (row = 1; row <= VectLen+1; row++) {
-	rowsumau = A_1of(row,1);
-	for (col = 2; col <= VectLen+1; col++) {
-	    rowsumau += A_1of(row,col) * Xof(uInd,col-1);
-	}
-	uau += rowsumau * uauZof(uInd, row);       
+    if (Vals > w->Vals) {
+      free(w->X); free(w->Sel);
+      w->X = malloc(Vals * sizeof(double));
+      w->Sel = malloc(Vals * sizeof(double));
+      if ((w->Vals = w->X && w->Sel ? Vals : 0) == 0) return False;
     }
-*/
-/* dangerous speed ups */
-locA1Start = A+(VectLen+1)*(VectLen+1);
-locuInd = uInd - 1;
-p1 = VectLen+1;
-#define locA1(i,j) *(locA1Start+i+j*p1)
-    for (i=0; i <= VectLen; i++) {
-        rowsumau = locA1(i,0);
-        for (j=1; j<=VectLen; j++) 
-            rowsumau += locA1(i,j) * *(X+locuInd*VectLen + j-1);
-	uau += rowsumau * uauZof(uInd, i+1);       
+    if (Rows > w->Rows) {
+      free(w->Dist); free(w->Flag);
+      w->Dist = malloc(Rows * sizeof(double));
+      w->Flag = malloc(Rows);
+      if ((w->Rows = w->Dist && w->Flag ? Rows : 0) == 0) return False;
     }
-    return(uau);
-}
-#undef uauZof
-
-/*---------------------------------------------------------------------------*/
-double Swap_Fact(int GoodOut, int BadIn)
-/* give the determint multiplier that results from
-   taking goodout out of J and BadIn into J (less than one is good)
-   assume that the inverse of A is available
-   see Hawkins page 8 for notation
-*/
-#define Zof(i,j) (j==1 ? 1 : Xof(i,j-1)) /* inefficient */
-{
-    double retval;                /* for debugging */
-    double a1;                    /* avoid address calc */
-    double uau=0, vav=0, uav=0;   /* itermediate vector x inverse prods */
-    double rowsumav, rowsumau;    /* to accumulate rightmost mult first */
-    int row, col;	          /* indexes for vector matrix mult. */
-			          /* (row and col refer to c inverse) */
-
-    /* use Z (not X or ZJ) */
-    for (row = 1; row <= VectLen+1; row++) {
-	rowsumav = rowsumau = 0.;
-	for (col = 1; col <= VectLen+1; col++) {
-	    rowsumau += (a1=A_1of(row,col)) * Zof(GoodOut,col);
-	    rowsumav += a1 * Zof(BadIn,col);
-	}
-	uau += rowsumau * Zof(GoodOut, row);       
-	vav += rowsumav * Zof(BadIn, row);
-        uav += rowsumav * Zof(GoodOut, row);
-    }
-    retval = (1-uau)*(1+vav) + (uav)*(uav);
-    return(retval);
-}
-#undef Zof
-/*---------------------------------------------------------------------------*/
-int Find_Best_Descent(int JCnt, int *GoodOut, int *BadIn)
-/* return false if there is not descent possible */
-/* uses sub string lists */
-/* return pointers to the best guys to move */
-/* A had better correspond to X  */
-/* This is way too messy.... */
-{
-    int OPos, ZPos;  /* to loop through substring lists */
-    double BestMoveFact=1.;  /* to find best (1. not HUGE_VAL....)*/
-    double MF;       /* avoid extra calls */
-    int i;
-
-    for (i=1; i<=XCnt; i++) uAu[i] = Comp_uAu(i);
-
-    for (OPos=0; OPos < JCnt; OPos++) {
-        for (ZPos=0; ZPos < XCnt - JCnt; ZPos++) {
-          if ((1-uAu[*(OnesList+OPos)+1]) * (1+uAu[*(ZerosList+ZPos)+1])
-            < BestMoveFact) {
-            /* calling the entire Swap_Fact is a slight waste of time... */
-            if ((MF = Swap_Fact(*(OnesList+OPos)+1, *(ZerosList+ZPos)+1))
-                 < BestMoveFact) {
-                BestMoveFact = MF;
-                *GoodOut = *(OnesList+OPos)+1;
-                *BadIn = *(ZerosList+ZPos)+1;
-                if (Trace) printf("%d out, %d in is current best\n",
-                           *(OnesList+OPos)+1, *(ZerosList+ZPos)+1);
-	    }
-          }
-        }
+    if (p > w->p) {
+      free(w->Cols);
+      w->Cols = malloc(p * sizeof(int));
+      if ((w->p = w->Cols ? p : 0) == 0) return False;
     }
-    if (Trace) printf("Best Move has MF=%E\n", BestMoveFact);
-    if (BestMoveFact < 1.) return(True); else return(False);
+    return True;
 }
 
-/*-------------------------------------------------------------------------*/
-void Do_One_Descent(int JCnt)
-/* simple descent to a local min */
+/*------------------------------------------------------------------*/
+int Serve_Request(int fd, struct Space *w)
+/* answer one request on fd; False if the connection is to be closed */
+/* (it closed, or sent something malformed or too big to take) */
 {
-    int GoodOut, BadIn;        /* to swap */
-
-    while (Find_Best_Descent(JCnt, &GoodOut, &BadIn)) {
-        *(JBits+GoodOut-1) = 0; *(JBits+BadIn-1) = 1;
-        if (Trace) printf("swap %d %d %E\n", GoodOut, BadIn, Determinant);
-        Create_SubString_Lists(JCnt);  /* could update ...*/
-        Process_JBits(JCnt);
+    struct Req q;
+    struct Rep r;
+    struct Loaded *L;
+    char Name[256], Msg[400];
+    double *x;
+    size_t Vals;
+    long i;
+    int p, FileCols, j, Ok;
+
+    if (!Get_All(fd, &q, sizeof(q))) return False;
+    memset(&r, 0, sizeof(r));
+    memcpy(r.Magic, REP_MAGIC, 4);
+    if (memcmp(q.Magic, REQ_MAGIC, 4) || q.NameLen >= sizeof(Name)
+        || (q.Op == OP_INFO && q.n != 0)
+        || (q.Op == OP_SCORE
+            && (q.p == 0 || q.n > SERVE_MAX / sizeof(double) / q.p))
+        || (q.Op != OP_SCORE && q.Op != OP_INFO)) {
+      Refuse(fd, &r, "bad request (or more than the request size limit)");
+      return False;
+    }
+    Vals = q.Op == OP_SCORE ? (size_t)q.n * q.p : 0;
+    if (!Get_All(fd, Name, q.NameLen)) return False;
+    Name[q.NameLen] = 0;
+    if (q.Op == OP_SCORE && !Grow_Space(w, Vals, (size_t)q.n, 0)) {
+      Refuse(fd, &r, "not enough memory for the request");
+      return False;
+    }
+    if (Vals && !Get_All(fd, w->X, Vals * sizeof(double))) return False;
+    if ((L = Use_Model(Name)) == NULL) {
+      snprintf(Msg, sizeof(Msg), "no model called %s is served", Name);
+      return Refuse(fd, &r, Msg);
+    }
+    MO_Model_Info(L->Mod, &p, &FileCols, &r.Cut);
+    r.p = p;
+    r.FileCols = FileCols;
+    if (!Grow_Space(w, 0, 0, p)) {
+      Done_Model(L);
+      return Refuse(fd, &r, "not enough memory for the request");
+    }
+    MO_Model_Cols(L->Mod, w->Cols);
+    if (q.Op == OP_INFO) {
+      Done_Model(L);
+      Ok = Put_All(fd, &r, sizeof(r)) && Put_All(fd, w->Cols, p * sizeof(int));
+    } else if ((int)q.p != p && (int)q.p != FileCols) {
+      Done_Model(L);
+      snprintf(Msg, sizeof(Msg), "rows of %u values, but model %s takes %d"
+               " (or %d, those of its data file)", q.p, Name, p, FileCols);
+      Ok = Refuse(fd, &r, Msg);
+    } else {
+      x = w->X;
+      if ((int)q.p != p) {
+        for (i = 0; i < (long)q.n; i++)
+          for (j = 0; j < p; j++)
+            w->Sel[i*p + j] = w->X[i*q.p + w->Cols[j]-1];
+        x = w->Sel;
+      }
+      MO_Score(L->Mod, x, (long)q.n, w->Dist, w->Flag);
+      Done_Model(L);
+      r.n = q.n;
+      Ok = Put_All(fd, &r, sizeof(r))
+           && Put_All(fd, w->Dist, q.n * sizeof(double))
+           && Put_All(fd, w->Flag, q.n);
     }
+    return Ok;
 }
 
-/*---------------------------------------------------------------------------*/
-void Get_XBarJ(int JCnt, double *XBarJ)
-/* x bar for the current J set, using only local variables (except J) */
-/* perhaps used by ghost image programs */
+/*------------------------------------------------------------------*/
+void *Serve_Worker(void *Arg)
+/* answer a request on each connection Dispatch hands over, and hand */
+/* the connection back for its next one (or close it) */
 {
-   int row, col;     /* to loop */
-   
-    for (col=1; col<=VectLen; col++) {
-	XBarJof(col) = 0.;
-	for (row=1; row<=XCnt; row++) 
-            if (*(JBits+row-1)) XBarJof(col) += Xof(row,col);
-	XBarJof(col) /=  JCnt;
+    struct Space w;
+    char Junk[4096];
+    int fd;
+
+    (void)Arg;
+    memset(&w, 0, sizeof(w));
+    for (;;) {
+      if (read(Work[0], &fd, sizeof(int)) != sizeof(int)) continue;
+      if (Serve_Request(fd, &w)) write(Back[1], &fd, sizeof(int));
+      else {        /* unread input would reset the connection, and the */
+                    /* client might lose the refusal */
+        while (recv(fd, Junk, sizeof(Junk), MSG_DONTWAIT) > 0);
+        close(fd);
+      }
     }
+    return NULL;
 }
 
-#define T_T FLT_EPSILON
-/*-------------------------------------------------------------------------*/
-int Lex_Compare_Data_Recs(const void *arg1, const void *arg2)
-/* compare *arg1 and *arg2 as per qsort needs */
-/* assume that doubles can never really be equal */
+/*------------------------------------------------------------------*/
+void Dispatch(struct MultOut *m)
+/* wait on the listening socket and every idle connection at once: a */
+/* connection with a request goes to a worker (through the Work pipe) */
+/* and comes back through Back when it has been answered, so an idle */
+/* client holds no worker. Model files are checked every SERVE_POLL */
+/* seconds */
 {
-  int i;
-  for (i=0; i<VectLen; i++) {
-    if (*((double *)arg1+i) < *((double *)arg2+i)-T_T) return(-1); 
-    if (*((double *)arg1+i) > *((double *)arg2+i)+T_T) return(1); 
-  }
-  return(0);
-}
+    struct pollfd *P;
+    struct timeval Stall = {SERVE_STALL, 0};
+    int Cnt = 2, Cap = 64, i, k, fd, Got[256];
+    time_t Next = time(NULL) + SERVE_POLL;
 
-/*-------------------------------------------------------------*/
-void Pre_Check_Data()
-/* this routine checks X for duplicates */
-/* if any are found, it gripes and dies */
-{
-  int i,j;
-  int Duds = False;
-  double *XSave;
-
-  XSave = malloc(VectLen*XCnt*sizeof(double)); ALLCHK(XSave)
-  Copy(XSave, X, XCnt * VectLen);
-  qsort(X, XCnt, VectLen * sizeof(double), Lex_Compare_Data_Recs);
-
-  for (i=1; i<XCnt; i++) {
-    if (!Lex_Compare_Data_Recs(XRow(i), XRow(i+1))) {
-       if (!Duds) printf("\nERROR: Duplicate points\n");
-       Duds = True;
-       for (j=1; j<=VectLen; j++) printf("%lf ",Xof(i,j));
-       printf("\n");
+    if ((P = malloc(Cap * sizeof(struct pollfd))) == NULL) {
+      printf("allocation error\n");
+      exit(1);
+    }
+    P[0].fd = Listener; P[0].events = POLLIN;
+    P[1].fd = Back[0]; P[1].events = POLLIN;
+    for (;;) {
+      for (i = 0; i < Cnt; i++) P[i].revents = 0;
+      if (poll(P, Cnt, 1000 * SERVE_POLL) < 0 && errno != EINTR) {
+        printf("\n*error* poll: %s\n\n", strerror(errno));
+        exit(1);
+      }
+      if (time(NULL) >= Next) {
+        Check_Models(m);
+        Next = time(NULL) + SERVE_POLL;
+      }
+      for (i = Cnt - 1; i >= 2; i--)    /* the last ones are done already */
+        if (P[i].revents) {
+          write(Work[1], &P[i].fd, sizeof(int));
+          P[i] = P[--Cnt];
+        }
+      k = 0;
+      if (P[1].revents & POLLIN)
+        k = (int)(read(Back[0], Got, sizeof(Got) - sizeof(int)) / (int)sizeof(int));
+      if ((P[0].revents & POLLIN) && (fd = accept(Listener, NULL, NULL)) >= 0) {
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &Stall, sizeof(Stall))
+            || setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &Stall, sizeof(Stall)))
+          close(fd);
+        else Got[k++] = fd;
+      }
+      if (Cnt + k > Cap
+          && (P = realloc(P, (Cap = 2 * (Cnt + k)) * sizeof(struct pollfd))) == NULL) {
+        printf("allocation error\n");
+        exit(1);
+      }
+      while (k > 0) {
+        P[Cnt].fd = Got[--k];
+        P[Cnt++].events = POLLIN;
+      }
     }
-  }
-  if (Duds) {
-    printf("The program will terminate due to duplicate points.\n");
-    printf("If a point was included r times, it was displayed r-1 times.\n");
-    printf("The tolerance used in duplicate detections was %E\n",
-           (double)T_T);
-    exit(1);
-  }
-  Copy(X, XSave, XCnt * VectLen);
-  free(XSave);
-}
-#undef T_T
-
-/*-------------------------------------------------------------------------*/
-void Use_Algo_Rej_Code()
-{
-  M_Iterate();
 }
 
-/*----------------------------------------------------------------------------*/
-void Parms_Help(char *S)
+/*------------------------------------------------------------------*/
+void Stop_Serving(int Sig)
 {
-  printf("\nThere was an error reading parameters from the file %s\n",S);
-  printf("The file should contain the partition multiplier (e.g. 5)\n");
-  printf("  the trace level (e.g. 0), the cut fraction (e.g. 0.01)\n");
-  printf("  and the simulation tolerance (e.g. 0.5)\n");
-  printf("Sample Contents:\n 5 0 0.01 0.5\n");  
-  exit(1);
+    (void)Sig;
+    unlink(SockPath);
+    _exit(0);
 }
 
-/*----------------------------------------------------------------------------*/
-void Set_Default_Parms()
-/* establish values for algorithm parameters */
-{
-  Lambda = 5 * VectLen;
-  Trace = 0;
-  Cut1 = Cut2 = (float)0.01;
-  SimTol = (float)0.5;
-} 
-
-/*----------------------------------------------------------------------------*/
-void Dump_Parms(FILE *f)
-{
-    fprintf(f,"Lambda Multiplier: %d; Trace: %d; \n", Lambda/VectLen, Trace);
-    fprintf(f,"Cut Fraction: %f; Simulation Tolerance: %f\n", Cut2, SimTol);
-}
- 
-/*----------------------------------------------------------------------------*/
-void Load_Parms(char *PARMSFILE)
-/* establish values for algorithm parameters */
+/*------------------------------------------------------------------*/
+int Socket_To(char *Path, struct sockaddr_un *a)
+/* a new socket, and in *a the address of Path */
 {
-    FILE *f;	   /* input file stream record pointer */
-    int LambdaMult; /* allow partition size to vary w/dimension */
-    int r;
-    float Cut;
+    int fd;
 
-    if ((f = fopen(PARMSFILE,"r")) == NULL) {
-       printf("\nCould not open the parms file specified: %s\n\n",PARMSFILE);
-       Info_Exit();
-    }
-    r = fscanf(f,"%d %d %f %f", &LambdaMult, &Trace, &Cut, &SimTol);
-    if (r != 4) Parms_Help(PARMSFILE);
-
-    fclose(f);
-    if (LambdaMult < 3) {
-        printf("Lambda mult is %d, but should be > 2\n",LambdaMult);
-        Parms_Help(PARMSFILE);
-    }
-    if ((Cut < 0) || (Cut > 1)) {
-      printf("The cut parm was %f but it must be between 0 and 1\n",Cut);
-      Parms_Help(PARMSFILE);
+    if (strlen(Path) >= sizeof(a->sun_path)) {
+      printf("\n*error* the socket name %s is too long\n\n", Path);
+      exit(1);
     }
-    if (SimTol <= (float)0.0) {
-      printf("The simulation tolerance must be greater than 0\n");
-      Parms_Help(PARMSFILE);
+    memset(a, 0, sizeof(*a));
+    a->sun_family = AF_UNIX;
+    strcpy(a->sun_path, Path);
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+      printf("\n*error* could not make a socket: %s\n\n", strerror(errno));
+      exit(1);
     }
-    
-    Cut1 = Cut2 = Cut;
-    Lambda = LambdaMult * VectLen;
+    return fd;
 }
 
-/*-------------------------------------------------------------------------*/
-void Forward(int *JCnt)
-/* similar to atkinson algorithm */
-/* NOTE: we stop at 2p */
+/*------------------------------------------------------------------*/
+void Run_Serve(char *Path, char **Files, int Cnt, int Workers)
+/* serve mode: load the models, listen on Path and answer requests on */
+/* Workers threads; this thread then runs Dispatch. A socket */
+/* left at Path by a server that is gone is replaced; a live one is not */
 {
-    int i;		      /* index into vector being formed */
-
-    for (*JCnt=VectLen+1; *JCnt <= 2*VectLen; (*JCnt)++) {
-        InvertC(C, VectLen, &Determinant);
-        Compute_Distance_Vector();
-        for (i=0; i<XCnt; i++) {
-          (ResidRecs+i)->SqMahalDist = *(SqResiduals+i);
-	  (ResidRecs+i)->SampleNum = i;
+    struct MultOut *m;
+    struct sockaddr_un a;
+    struct Served *s;
+    struct stat St;
+    pthread_t t;
+    int i, fd;
+
+    if ((m = MO_New()) == NULL
+        || (Models = calloc(Cnt, sizeof(struct Served))) == NULL) {
+      printf("allocation error\n");
+      exit(1);
+    }
+    for (ModelCnt = 0; ModelCnt < Cnt; ModelCnt++) {
+      s = Models + ModelCnt;
+      s->File = Files[ModelCnt];
+      s->Name = strrchr(s->File, '/') ? strrchr(s->File, '/') + 1 : s->File;
+      for (i = 0; i < ModelCnt; i++)
+        if (!strcmp(Models[i].Name, s->Name)) {
+          printf("\n*error* two models are called %s\n\n", s->Name);
+          exit(1);
         }
-        qsort(ResidRecs, XCnt, sizeof(struct ResidRec), Compare_Resids);
-        memset(JBits, 0, XCnt*sizeof(int));
-        for (i=0; i<*JCnt; i++) *(JBits+(ResidRecs+i)->SampleNum) = 1;
-        Form_XJ();
-        Compute_XBarJ(*JCnt);
-        Form_C(*JCnt);
+      if (stat(s->File, &s->St)) {
+        printf("\n*error* could not open %s: %s\n\n", s->File, strerror(errno));
+        exit(1);
+      }
+      if ((s->Cur = Load_Model(m, s->File)) == NULL) {
+        printf("\n*error* %s\n\n", MO_Error(m));
+        exit(1);
+      }
     }
-    /* fill to half sample (not very efficient) */
-    *JCnt = BaseSubSampleSize;
-    memset(JBits, 0, XCnt*sizeof(int));
-    for (i=1; i<= *JCnt; i++) *(JBits+(ResidRecs+i)->SampleNum) = 1;
-    Form_XJ();
-    Compute_XBarJ(*JCnt);
-    Form_C(*JCnt);
-    Create_SubString_Lists(*JCnt);
-}
-
-/**************************************************************************/
-int Partition_Main(long LocalItersAllowed)
-{
-    long IterCntr=0;			       /* to count iterations */
-    int i,BitsInBest;			       /* find out how big winner is*/
-    int JCnt;				       /* variable sub-sample size*/
-
-    JCnt = BaseSubSampleSize;
-    Randomize_JBits(JCnt);	/* to make a best */
-    Process_JBits(JCnt);
-    Create_SubString_Lists(JCnt);
-    Record_Best();	/* a best */
-    for (i=0; i<LocalItersAllowed; i++) {
-	IterCntr++;
-	Do_One_Descent(JCnt);
-	if (Trace) printf("Descent %ld Results in %.3E\n", IterCntr, ObjectiveValue);
-        Randomize_JBits(JCnt);
-        Process_JBits(JCnt);
-        Create_SubString_Lists(JCnt);
+    fd = Socket_To(Path, &a);
+    if (connect(fd, (struct sockaddr *)&a, sizeof(a)) == 0) {
+      printf("\n*error* a server is already listening on %s\n\n", Path);
+      exit(1);
+    }
+    close(fd);
+    if (!stat(Path, &St) && S_ISSOCK(St.st_mode)) unlink(Path);
+    Listener = Socket_To(Path, &a);
+    if (bind(Listener, (struct sockaddr *)&a, sizeof(a))
+        || listen(Listener, SOMAXCONN)) {
+      printf("\n*error* could not listen on %s: %s\n\n", Path, strerror(errno));
+      exit(1);
     }
-    Copy(JBits, BestJBits, XCnt);
-    BitsInBest = 0; for (i=0; i<XCnt; i++) if (*(BestJBits+i)) ++BitsInBest;
-    Form_XJ();
-    Compute_XBarJ(BitsInBest);
-    if (Trace) Dump_XBarJ("For Best SubSample in Partition");
+    SockPath = Path;
+    if (fcntl(Listener, F_SETFL, O_NONBLOCK) || pipe(Work) || pipe(Back)) {
+      printf("\n*error* could not set up the server: %s\n\n", strerror(errno));
+      exit(1);
+    }
+    signal(SIGINT, Stop_Serving);
+    signal(SIGTERM, Stop_Serving);
+    signal(SIGPIPE, SIG_IGN);
+    if (Workers < 1 && (Workers = (int)sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+      Workers = 1;
+    for (i = 0; i < Workers; i++)
+      if (pthread_create(&t, NULL, Serve_Worker, NULL)) {
+        printf("Could not start a serve thread\n");
+        exit(1);
+      }
+    printf("Serving %d model%s on %s with %d threads\n", ModelCnt,
+           ModelCnt == 1 ? "" : "s", Path, Workers);
+    fflush(stdout);
+    Dispatch(m);
 }
 
 /*------------------------------------------------------------------*/
-void Generate_Permutation(int N, int *p)
-/* generate permutation of length N in p */
-/* p is zero based, but the permutation is not */
+void Ask(int fd, uint32_t Op, char *Name, uint32_t p, uint64_t n,
+         double *x, struct Rep *r)
+/* send a request and read the reply's header; a refusal ends the run */
 {
-    int i,j;				 /* to loop */
-    int lspot;				 /* offset in l */
-    int *FullList;			 /* unpermuted */
-    int *l; 				 /* left to be used */
-
-    FullList = malloc(N * sizeof(int));
-    ALLCHK(FullList)
-    for (i=0; i<N; i++) *(FullList+i) = i+1;
-    l = malloc(N * sizeof(int));
-    ALLCHK(l)
-
-    Copy(l, FullList, N);
-    for (i=0; i < N; i++) {
-	lspot = (int)(URan(&seed) * (float)(N - i));
-	*(p+i) = *(l+lspot);
-	for (j=lspot; j<N-i; j++) *(l+j) = *(l+j+1);
+    struct Req q;
+    char Msg[512];
+
+    memcpy(q.Magic, REQ_MAGIC, 4);
+    q.Op = Op;
+    q.NameLen = strlen(Name);
+    q.p = p;
+    q.n = n;
+    if (!Put_All(fd, &q, sizeof(q)) || !Put_All(fd, Name, q.NameLen)
+        || !Put_All(fd, x, n * p * sizeof(double))
+        || !Get_All(fd, r, sizeof(struct Rep)) || memcmp(r->Magic, REP_MAGIC, 4)) {
+      printf("\n*error* the server closed the connection\n\n");
+      exit(1);
+    }
+    if (r->Status != MO_OK) {
+      if (r->n >= sizeof(Msg)) r->n = sizeof(Msg) - 1;
+      Msg[Get_All(fd, Msg, r->n) ? r->n : 0] = 0;
+      printf("\n*error* the server says: %s\n\n", Msg);
+      exit(1);
     }
-    free(l); free(FullList);
 }
 
 /*------------------------------------------------------------------*/
-void Write_First_Results(char *OutFile, char *InFileName)
-/* final report */
+void Run_Client(struct MultOut *m, FILE *f, char *Path, char *Name,
+                char *InFile, char *OutFile)
+/* -client: score InFile against the model Name served on Path, */
+/* CLIENT_ROWS rows a request, and write the scores as -score does (to */
+/* f if it is not NULL) */
 {
-   FILE *f;  /* output file */
-   int row, col;
-   char flag;
-
-   if (!(f=fopen(OutFile,"w"))) {
-     printf("Could not open %s for write\n",OutFile);
-     exit(1);
-   }
-   fprintf(f,BANNER);
-   fprintf(f,"\nData read from: %s\n", InFileName);
-   fprintf(f,"\nRobust M-Estimate Mean:\n");
-   for (col=1; col <= VectLen; col++) fprintf(f," %11.3E\n", XBarJof(col));
-   fprintf(f,"\nM-Estimate of Covariance Matrix:\n");
-   for (row=1; row<=VectLen; row++) {
-     for (col=1; col <= VectLen; col++) fprintf(f," %11.3E", Cof(row,col));
-     fprintf(f,"\n");
-   }
-   fclose(f);
+    struct sockaddr_un a;
+    struct Rep r;
+    double *x, *Dist;
+    unsigned char *Flag;
+    long n, i, j, k, Out = 0;
+    int fd, p, Col;
+
+    fd = Socket_To(Path, &a);
+    if (connect(fd, (struct sockaddr *)&a, sizeof(a))) {
+      printf("\n*error* no server on %s: %s\n\n", Path, strerror(errno));
+      exit(1);
+    }
+    if (MO_Load(m, InFile, &x, &p, &n) != MO_OK) exit(1);
+    if ((Dist = malloc(CLIENT_ROWS * sizeof(double))) == NULL
+        || (Flag = malloc(CLIENT_ROWS)) == NULL) {
+      printf("allocation error\n");
+      exit(1);
+    }
+    Ask(fd, OP_INFO, Name, 0, 0, NULL, &r);
+    for (i = 0; i < (long)r.p; i++) Get_All(fd, &Col, sizeof(int));
+    if (!f && (f = fopen(OutFile, "w")) == NULL) {
+      printf("Could not open %s for write\n", OutFile);
+      exit(1);
+    }
+    fprintf(f, "# multout scores of %s against the model %s served on %s\n",
+            InFile, Name, Path);
+    fprintf(f, "# squared distance cutoff %.6E; flag 1 is a potential outlier\n",
+            r.Cut);
+    fprintf(f, "# row distance flag\n");
+    for (i = 0; i < n; i += k) {
+      k = n - i < CLIENT_ROWS ? n - i : CLIENT_ROWS;
+      Ask(fd, OP_SCORE, Name, p, k, x + i*p, &r);
+      if (!Get_All(fd, Dist, k * sizeof(double)) || !Get_All(fd, Flag, k)) {
+        printf("\n*error* the server closed the connection\n\n");
+        exit(1);
+      }
+      for (j = 0; j < k; j++) {
+        fprintf(f, "%ld %.6E %d\n", i + j + 1, Dist[j], Flag[j]);
+        Out += Flag[j];
+      }
+    }
+    if (fclose(f)) {
+      printf("Could not write %s\n", OutFile);
+      exit(1);
+    }
+    close(fd);
+    printf("Scored %ld rows: %ld potential outliers\n", n, Out);
+    free(x); free(Dist); free(Flag);
 }
 
 /*------------------------------------------------------------------*/
-void Write_Final_Results(char *OutFile, float RejDist)
-/* final report */
-{
-   FILE *f;  /* output file */
-   int row, col, JCnt;
-   char flag;
-
-   if (!(f=fopen(OutFile,"a"))) {
-     printf("Could not open %s for write\n",OutFile);
-     exit(1);
-   }
-   fprintf(f,"\n---------------------------------------------\n");
-   fprintf(f,"\nRobust, Unscaled Mahalonobis Distances\n");
-   fprintf(f,"An asterisk (*) indicates a potential outlier.\n");
-   fprintf(f,"The cutoff for a potential outlier (with a requested\n rejection");
-   fprintf(f," of %g of the non-outliers) was determined to be %.3E\n",Cut2, RejDist);   
-   for (row=0; row<XCnt; row++) {
-     if (JBits[row]) flag = ' '; else flag = '*';
-     fprintf(f,"%c point%4d: %.3E\n", flag, row+1, *(SqResiduals+row));
-   }
-   JCnt = 0;
-   for (row=0; row<XCnt; row++) JCnt += JBits[row];
-   Form_XJ();
-   Compute_XBarJ(JCnt);
-   Form_C(JCnt);
-   fprintf(f,"Rejection of the points with asterisks leaves %d points\n",JCnt);
-   fprintf(f,"with mean:\n");
-   for (col=1; col <= VectLen; col++) fprintf(f," %11.3E\n", XBarJof(col));
-   fprintf(f,"\and covariance matrix:\n");
-   for (row=1; row<=VectLen; row++) {
-     for (col=1; col <= VectLen; col++) fprintf(f," %11.3E", Cof(row,col));
-     fprintf(f,"\n");
-   }
-
-   fprintf(f,"\n\nComplete, Original Data:\n");
-   for (row=1; row <= XCnt; row++) {
-     for (col=1; col <=VectLen; col++) fprintf(f,"%E ",Xof(row,col));
-     fprintf(f,"\n");
-   }
-   fprintf(f,"\n\nParameters:\n");                               
-   fprintf(f,"p=%d, n=%d, Iterations:%ld\n",VectLen, XCnt, ItersAllowed); 
-   Dump_Parms(f);
-   fclose(f);
-}
-/*------------------------------------------------------------------*/
-void Bad_Run(char *OutFile, char *InFileName)
-/* final report when things didn't work out */
-{
-   FILE *f;  /* output file */
-   int row, col;
-   
-   if (!(f=fopen(OutFile,"w"))) {
-     printf("Could not open %s for write\n",OutFile);
-     exit(1);
-   }
-   fprintf(f,BANNER);
-   fprintf(f,"\nERROR: Could not get results due to singular data\n\n");
-   fprintf(f,"Data read from: %s\n", InFileName);
-   fprintf(f,"\n\nData:\n");
-   for (row=1; row <= XCnt; row++) {
-     for (col=1; col <=VectLen; col++) fprintf(f,"%E ",Xof(row,col));
-     fprintf(f,"\n");
-   }
-   fprintf(f,"\n\nParameters:\n");                               
-   fprintf(f,"p=%d, n=%d, Iterations:%ld\n",VectLen, XCnt, ItersAllowed); 
-   Dump_Parms(f);
-   fclose(f);
-}
-
-                               
-/**************************************************************************/
 int main(int argc, char *argv[])
 {
-    double far *XSave, far *XWorking;       /* copies of X */
-#   define XWorkingof(i,j) *(XWorking+(i-1)*VectLen+j-1) /* col major...*/
-    int XCntSave;                   /* overall n */
-    double *BestC, *BestXBarJ;      /* best of the partition results */
-    double *CSave;                  /* avoid an inversion */
-    double *PartC, *PartBar;        /* to allow S-iter on part result */
-    double MainBestObj = HUGE_VAL;  /* best partition objective value */
-    int PartitionCnt;               /* number of sample partitions */
-    int *Permutation;               /* random permutation vector */
-    int i,j,k;                      /* to loop */
-    int JCnt;                       /* to process sub-samples of partitions */
-    int Part;                       /* to loop through partitions */
-    FILE *f;                        /* for file check */
-    float CutDist;                  /* to report */
-
-    printf(BANNER);
-    if ((argc < 3) || (argc > 5)) Info_Exit();
-
-#   ifndef BaseSubSampleSize
-      printf("Compiled without BaseSubSampleSize defined.\nAborting");
+    struct MultOut *m;
+    int i, k, Used;         /* next argument, next positional slot */
+    long Iters = -1;        /* (n)(p) */
+    char *Manifest = NULL;  /* -batch */
+    char *Model = NULL;     /* -score */
+    char *Serve = NULL;     /* -serve socket */
+    char *Client = NULL;    /* -client socket */
+    FILE *Out = NULL;       /* the scores, for a -client outfile of - */
+    int Group = 0;          /* -group column (0: none) */
+    int Workers = 0;        /* -jobs (0: one per processor) */
+    int SeedSet = False;    /* -seed was given */
+    char *ColSpec = NULL;   /* and -cols */
+
+    if ((m = MO_New()) == NULL) {
+      printf("allocation error\n");
+      exit(1);
+    }
+    MO_Log(m, stdout);
+    Opts[OptCnt++] = "-threads";        /* batch jobs share the processors */
+    Opts[OptCnt++] = "1";
+    if (getenv("MULTOUT_CACHE")) {
+      Opts[OptCnt++] = "-cache";
+      Opts[OptCnt++] = getenv("MULTOUT_CACHE");
+      MO_Option(m, "-cache", getenv("MULTOUT_CACHE"));
+    }
+    for (i=1; i<argc && argv[i][0] == '-' && argv[i][1]; i += Used) {
+      Used = 2;
+      if (!strcmp(argv[i], "-batch") && i+1 < argc) Manifest = argv[i+1];
+      else if (!strcmp(argv[i], "-score") && i+1 < argc) Model = argv[i+1];
+      else if (!strcmp(argv[i], "-serve") && i+1 < argc) Serve = argv[i+1];
+      else if (!strcmp(argv[i], "-client") && i+1 < argc) Client = argv[i+1];
+      else if (!strcmp(argv[i], "-jobs") && i+1 < argc) {
+        if ((Workers = atoi(argv[i+1])) < 1) Used = 0;
+      }
+      else if (!strcmp(argv[i], "-group") && i+1 < argc) {
+        if ((Group = atoi(argv[i+1])) < 1) Used = 0;
+      }
+      else if ((Used = MO_Option(m, argv[i], i+1 < argc ? argv[i+1] : NULL))
+               && OptCnt + Used < MAX_OPTS) {
+        if (!strcmp(argv[i], "-seed")) SeedSet = True;
+        if (!strcmp(argv[i], "-cols")) ColSpec = argv[i+1];
+        Opts[OptCnt++] = argv[i];
+        Opts[OptCnt++] = Used == 2 ? argv[i+1] : NULL;
+        OptCnt -= 2 - Used;
+      }
+      if (Used == 0) {
+        if (!strcmp(argv[i], "-jobs") || !strcmp(argv[i], "-group")) MO_Usage(m);
+        exit(1);
+      }
+    }
+    for (k=1; i<argc; ) argv[k++] = argv[i++];
+    argc = k;
+    if (Client && argc == 4 && !strcmp(argv[3], "-")) Out = Report_To_Stdout(m);
+    else if (!Manifest && !Group && !Serve && !Client && argc >= 3
+             && !strcmp(argv[2], "-"))
+      Report_To_Stdout(m);
+    printf("%s", MO_Banner());
+    if (Serve ? argc < 2 : Client ? argc != 4 : Manifest ? argc != 2
+        : Model ? argc != 3
+        : (argc < 3) || (argc > 5) || (argc > 3 && (Iters = atol(argv[3])) < 0)) {
+      MO_Usage(m);
       exit(1);
-#   endif
-    Load_Data(argv[1]);
-    if (argc > 3) {
-      if ((ItersAllowed = atoi(argv[3])) < 0) Info_Exit();
-    } else ItersAllowed = VectLen * XCnt;
-
-    if (Trace) Dump_Data("After Load");
-    if (argc == 5) Load_Parms(argv[4]); else Set_Default_Parms();
-    Make_Room();
-    if (!(f=fopen(argv[2],"w"))) Info_Exit();
-    fclose(f);
-    Set_c_and_b0();
-
-    XSave = _fmalloc(VectLen*XCnt*sizeof(double)); ALLCHK(XSave)
-    XWorking = _fmalloc(VectLen*XCnt*sizeof(double)); ALLCHK(XWorking)
-    BestC = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(BestC)
-    CSave = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(CSave)
-    PartC = malloc(VectLen*VectLen*2*sizeof(double)); ALLCHK(PartC)
-    PartBar = malloc(VectLen*sizeof(double)); ALLCHK(PartBar)
-    BestXBarJ = malloc(VectLen*sizeof(double)); ALLCHK(BestXBarJ)
-    Permutation = malloc(XCnt * sizeof(int)); ALLCHK(Permutation)
-
-    PartitionCnt = (int)(XCnt/Lambda); if (PartitionCnt <= 0) PartitionCnt = 1;
-    XCntSave = XCnt;
-    Copy(XSave, X, XCnt * VectLen);
-    /* randomize the rows of X to make X working */
-    /* column major is a pain....*/
-    Generate_Permutation(XCnt, Permutation);
-    for (j=1; j<=XCnt; j++) for (k=1; k<=VectLen; k++) 
-        XWorkingof(j,k) = Xof((*(Permutation+j-1)),k);
-
-    for (Part=0; Part<PartitionCnt; Part++) {
-        printf("Begin Partition Cell %d\n",Part+1);
-        XCnt = XCntSave / PartitionCnt;
-        /* this is where that ridiculous column major idea hurts a little ...*/
-        for (j=1; j<=XCnt; j++) for (k=1; k<=VectLen; k++) 
-            Xof(j,k) = XWorkingof(j+Part*XCntSave/PartitionCnt, k); 
-        Partition_Main(ItersAllowed/PartitionCnt);
-        /* now iterate from the optimal */
-        /* (remember that indexes in the local (random) X are not valid in X)*/
-        Copy(JBits, BestJBits, XCnt); 
-        JCnt = 0; for (i=0; i < XCnt; i++) JCnt += *(JBits+i);
-        Form_XJ();
-        Compute_XBarJ(JCnt);
-        Form_C(JCnt);
-        M_Iterate();
-        Copy(PartC, C, VectLen*VectLen*2);
-        Copy(PartBar, XBarJ, VectLen);
-        /*use entire sample to a get obj value and save the best C and XBARJ*/
-        Copy(X, XSave, XCnt * VectLen);
-        XCnt = XCntSave;
-
-        Forward(&JCnt);
-        M_Iterate();
-        Copy(CSave, C, VectLen*VectLen*2);
-        if (Trace) Dump_XBarJ("after iteration on all data");
-         InvertC(C, VectLen, &Determinant);
-         Compute_Distance_Vector();  /* needed to compute k */
-         ObjectiveValue = Determinant * pow((double)Compute_k(), (double)(2. * VectLen));
-        if (Trace) printf("Partition ObjectiveValue=%lf\n",ObjectiveValue);
-        if (ObjectiveValue < MainBestObj) {
-            MainBestObj = ObjectiveValue;
-            Copy(BestC, CSave, VectLen*VectLen*2);
-            Copy(BestXBarJ, XBarJ, VectLen);
-	}
-        Copy(C, PartC,VectLen*VectLen*2);
-        Copy(XBarJ, PartBar, VectLen);
-        /***** duplicate to allow with and without forward */
-        M_Iterate();
-        Copy(CSave, C, VectLen*VectLen*2);
-        if (Trace) Dump_XBarJ("after non-forward iteration on all data again");
-         InvertC(C, VectLen, &Determinant);
-         Compute_Distance_Vector();  /* needed to compute k */
-         ObjectiveValue = Determinant * pow((double)Compute_k(), (double)(2. * VectLen));
-        if (Trace) printf("Partition ObjectiveValue=%lf\n",ObjectiveValue);
-        if (ObjectiveValue < MainBestObj) {
-            MainBestObj = ObjectiveValue;
-            Copy(BestC, CSave, VectLen*VectLen*2);
-            Copy(BestXBarJ, XBarJ, VectLen);
-	}
-/*  end dupl */
     }
-    _ffree(XWorking);
-    Copy(C, BestC,VectLen*VectLen*2);
-    Copy(XBarJ, BestXBarJ, VectLen);
-    Copy(X, XSave, XCnt * VectLen);
-    _ffree(XSave);
-    XCnt = XCntSave;
-    if (Trace) Dump_XBarJ("best partition");
-    Write_First_Results(argv[2], argv[1]); /* needs C intact */
-    InvertC(C, VectLen, &Determinant);
-    Compute_Distance_Vector();   /* can get wrecked */
-    printf("Analysis report written to %s.\n",argv[2]);
-    printf("Beginning outlier detection.\n");
-    CutDist = ID_Good(Cut1, Cut2);
-    Write_Final_Results(argv[2], CutDist); /* wrecks C */
-    printf("Done.\nFinal report written to %s\n",argv[2]);
+    if (Serve) Run_Serve(Serve, argv + 1, argc - 1, Workers);
+    if (Client) {
+      Run_Client(m, Out, Client, argv[1], argv[2], argv[3]);
+      MO_Free(m);
+      return 0;
+    }
+    if (Model) {
+      if (Score(m, Model, argv[1], argv[2])) exit(1);
+      MO_Free(m);
+      return 0;
+    }
+    if (Manifest || Group) {
+      for (i = 0; i < OptCnt; i++)
+        if (Opts[i] && (!strcmp(Opts[i], "-results") || !strcmp(Opts[i], "-echo")
+                        || !strcmp(Opts[i], "-model")
+                        || (Group && !strcmp(Opts[i], "-stream")))) {
+          printf("\n*error* %s cannot be used with %s\n", Opts[i],
+                 Manifest ? "-batch" : "-group");
+          exit(1);
+        }
+      if (Manifest) Run_Batch(Manifest, argv[1], Workers, SeedSet);
+      else Run_Groups(argv[1], argv[2], Iters, argc == 5 ? argv[4] : NULL, Group,
+                      Workers, SeedSet, ColSpec);
+      MO_Free(m);
+      return Failed ? 1 : 0;
+    }
+
+    if (MO_Run_Files(m, argv[1], argv[2], Iters, argc == 5 ? argv[4] : NULL))
+      exit(1);
+    MO_Free(m);
+    return 0;
 }
@@ -0,0 +1,106 @@
+/* MULTOUT.H: libmultout, the multout estimator as a library */
+/* copyright 1992,1993,1994,1995,1996 by David L. Woodruff and David M. Rocke */
+
+/* Each analysis has a context of its own, so any number of them can */
+/* run at once, one per thread (a context is used by one thread at a */
+/* time). Calls return MO_OK or an error code, with the reason in */
+/* MO_Error; results are copied into buffers the caller supplies. */
+/* A typical run on data in memory: */
+/*   m = MO_New(); */
+/*   MO_Set_Data(m, x, p, n);       x is n rows of p values each */
+/*   if (MO_Run(m, -1) != MO_OK) puts(MO_Error(m)); */
+/*   MO_Estimate(m, Mean, Cov);     p and p by p doubles */
+/*   MO_Distances(m, Dist, Flag, NULL); */
+/*   MO_Free(m); */
+/* Nothing is written anywhere unless asked for (MO_Log, MO_Run_Files, */
+/* the -results option). A call that fails closes the files it opened */
+
+#ifndef MULTOUT_H
+#define MULTOUT_H
+#include <stdio.h>
+
+#define MO_OK 0
+#define MO_ERROR 1              /* the run failed: see MO_Error */
+#define MO_USAGE 2              /* a bad option, argument or parameter */
+
+struct MultOut;                 /* an analysis (opaque) */
+
+struct MultOut *MO_New(void);   /* NULL if out of memory */
+void MO_Free(struct MultOut *m);
+
+/* settings: they last until MO_Free */
+int MO_Option(struct MultOut *m, char *Name, char *Value);
+    /* a multout command line option, Name like "-cols", and Value the */
+    /* argument after it or NULL; returns the number of the two used */
+    /* (0 for an unknown option or a bad value). The strings are kept, */
+    /* not copied */
+int MO_Set_Parms(struct MultOut *m, int Lambda, int Trace, float Cut,
+                 float SimTol);
+    /* what a parms file gives (Lambda is the partition size itself, */
+    /* 0 for 5p); the defaults are 0, 0, 0.01 and 0.5 */
+int MO_Set_Data(struct MultOut *m, const double *x, int p, long n);
+    /* the data for MO_Run: n observations of p values, row major; x */
+    /* is copied by each run, and must last until the last one */
+int MO_Set_Name(struct MultOut *m, char *Name);
+    /* what the report calls the MO_Set_Data data (kept, not copied) */
+void MO_Log(struct MultOut *m, FILE *f);     /* progress and error messages */
+void MO_Report(struct MultOut *m, FILE *f);  /* the report for outfile "-" */
+
+/* runs: each one starts from scratch (the last run's results go) */
+int MO_Run(struct MultOut *m, long Iters);
+    /* estimate from the MO_Set_Data data; Iters < 0 is (n)(p). The seed */
+    /* is the -seed option, or a fixed default */
+int MO_Run_Files(struct MultOut *m, char *InFile, char *OutFile, long Iters,
+                 char *ParmsFile);
+    /* the multout program: InFile in any of its formats, the reports */
+    /* to OutFile; ParmsFile may be NULL. The seed is from -seed or the */
+    /* file SEED.DAT. A NULL InFile runs on the MO_Set_Data data, as */
+    /* MO_Run does */
+int MO_Load(struct MultOut *m, char *InFile, double **x, int *p, long *n);
+    /* just read InFile (any format but -stream; with -cols, only those */
+    /* columns) into *x, n rows of p values, for the caller to free */
+
+/* results of the last run that finished */
+int MO_Dims(struct MultOut *m, int *p, long *n);
+    /* n counts the rows used: with -collapse, the distinct points */
+int MO_Estimate(struct MultOut *m, double *Mean, double *Cov);
+    /* the final location (p) and scatter (p by p), from the points */
+    /* that are not potential outliers; either may be NULL */
+int MO_M_Estimate(struct MultOut *m, double *Mean, double *Cov);
+    /* the robust M-estimate the distances are measured from */
+int MO_Distances(struct MultOut *m, double *Dist, unsigned char *Flag,
+                 long *Row);
+    /* for each of the n rows: the squared distance, 1 for a potential */
+    /* outlier, and its number in the data (from one); any may be NULL */
+int MO_Cutoffs(struct MultOut *m, double *First, double *Final);
+    /* the first and second stage squared distance cutoffs */
+
+/* fitted models (the -model option writes them): a model is read only, */
+/* so any number of threads can score against one at once */
+struct MO_Model;
+int MO_Read_Model(struct MultOut *m, char *File, struct MO_Model **Model);
+    /* read a model file into *Model (the error, if any, is m's) */
+void MO_Free_Model(struct MO_Model *Mod);
+int MO_Model_Info(const struct MO_Model *Mod, int *p, int *FileCols,
+                  double *Cut);
+    /* its p, the number of columns of the data it was fitted to, and */
+    /* the squared distance cutoff for a potential outlier */
+int MO_Model_Cols(const struct MO_Model *Mod, int *Cols);
+    /* the data file column (from one) of each of its p variables */
+void MO_Score(const struct MO_Model *Mod, const double *x, long n,
+              double *Dist, unsigned char *Flag);
+    /* the squared distances of the n rows of x (row major, the model's */
+    /* p columns) and 1 for each potential outlier (Flag may be NULL); */
+    /* allocates nothing */
+int MO_Score_File(struct MultOut *m, struct MO_Model *Mod, char *InFile,
+                  char *OutFile);
+    /* score every row of InFile (any format; the model picks the */
+    /* columns it was fitted to) into OutFile: a line per row, or a */
+    /* binary matrix of distances and flags if the name ends in .bin. */
+    /* An InFile of "-" is stdin, read as text rows arrive; each read's */
+    /* rows are scored and their lines flushed before the next read */
+
+char *MO_Error(struct MultOut *m);  /* why the last call failed */
+char *MO_Banner(void);              /* the version and copyright lines */
+int MO_Usage(struct MultOut *m);    /* the usage message, to the log */
+#endif
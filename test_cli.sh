@@ -0,0 +1,145 @@
+# TEST_CLI.SH: checks of multout's files and messages (make test)
+# usage: sh test_cli.sh multout; it works on MULCROSS.DAT in a directory
+# of its own (removed at the end) and says ok or FAILED for each check
+
+M=`cd \`dirname $1\` && pwd`/`basename $1`
+D=test_cli.dir
+Fails=0
+
+check() {       # check what command...: ok if the command succeeds
+  What=$1; shift
+  if "$@" > /dev/null 2>&1; then echo "ok: $What"
+  else echo "FAILED: $What"; Fails=`expr $Fails + 1`
+  fi
+}
+
+rm -rf $D; mkdir $D
+cp MULCROSS.DAT SEED.DAT $D
+cd $D
+
+# the cutoff cache: a miss simulates and stores, a hit does not simulate,
+# and an entry for another version of the simulation is not taken
+check "a run with an empty cache" $M -cache cache MULCROSS.DAT c1.out 100
+check "simulates its cutoff" grep -q "cutoff .* taken from simulation" c1.out
+V=`head -1 cache/multout.cut | cut -d' ' -f1`
+check "and stores it" grep -q "^$V 200 10 " cache/multout.cut
+check "a second run" $M -cache cache MULCROSS.DAT c2.out 100
+check "takes it from the cache" grep -q "taken from the cutoff cache" c2.out
+check "a run with -pool" $M -pool -cache cache MULCROSS.DAT c3.out 100
+check "does not take it (version ${V}p)" grep -q "taken from simulation" c3.out
+check "and stores its own" grep -q "^${V}p 200 10 " cache/multout.cut
+sed "s/^$V /${V}old /" cache/multout.cut > old.cut
+mv old.cut cache/multout.cut
+check "a run with only an old version's entry" $M -cache cache MULCROSS.DAT c4.out 100
+check "simulates again" grep -q "taken from simulation" c4.out
+
+# the parser: each bad value is named, with its line, row and column
+for v in 1e . - 0x10 NaN inf 1e999; do
+  printf "2 4\n1 2\n3 $v\n5 6\n7 8\n" > bad.dat
+  $M bad.dat bad.out 10 > bad.log
+  check "the value $v is refused" \
+    grep -qxF "*error* bad.dat line 3: bad value \"$v\" for row 2, column 2" bad.log
+done
+mkdir re
+sed '2s/0.88574650469 -1.35611540314 -0.02460419786/0.885746504690000000000000 -135.611540314e-2 -2460419786e-11/' \
+  MULCROSS.DAT > re/MULCROSS.DAT
+cp SEED.DAT re
+$M MULCROSS.DAT p1.out 100 > /dev/null
+(cd re; $M MULCROSS.DAT ../p2.out 100 > /dev/null)
+check "the same values written another way give the same report" cmp p1.out p2.out
+
+# a file long enough to be cut into chunks parsed in parallel: an error
+# in a later chunk, or rows short or over, still names the right place
+awk 'BEGIN {srand(1); print "10 30000"
+            for (i = 1; i <= 30000; i++) {
+              for (j = 1; j <= 10; j++) printf " %.11f", rand() - .5
+              print ""}}' > big.dat
+export OMP_NUM_THREADS=4
+awk 'NR == 25001 {$7 = "1.2.3"} {print}' big.dat > bad.dat
+$M bad.dat bad.out 10 > bad.log
+check "a bad value in a later chunk is found" \
+  grep -qxF '*error* bad.dat line 25001: bad value "1.2.3" for row 25000, column 7' bad.log
+awk 'NR == 20001 {NF = 9} {print}' big.dat > bad.dat
+$M bad.dat bad.out 10 > bad.log
+check "a short row is found" \
+  grep -qxF '*error* bad.dat ends after 299999 of its 300000 values (row 30000, column 10 is missing)' bad.log
+sed '1s/.*/10 30001/' big.dat > bad.dat
+$M bad.dat bad.out 10 > bad.log
+check "a missing row is found" \
+  grep -qxF '*error* bad.dat ends after 300000 of its 300010 values (row 30001, column 1 is missing)' bad.log
+sed '1s/.*/10 29999/' big.dat > bad.dat
+$M bad.dat bad.out 10 > bad.log
+check "an extra row is found" \
+  grep -qxF '*error* bad.dat line 30001: more than the 29999 rows of 10 values in the header' bad.log
+unset OMP_NUM_THREADS
+
+# binary matrix files: the echo of a text file, read back, gives the same
+# report and echo; -verify refuses a file whose checksum does not match
+check "-echo writes the data as a binary matrix" \
+  $M -echo e1.bin MULCROSS.DAT e1.out 100
+check "which -verify passes" $M -verify -echo e2.bin e1.bin e2.out 100
+sed '/^Data read from/d; /Original Data: in/d' e1.out > e1.rep
+sed '/^Data read from/d; /Original Data: in/d' e2.out > e2.rep
+check "and which gives the text file's report" cmp e1.rep e2.rep
+check "and the same echo" cmp e1.bin e2.bin
+cp e1.bin bad.bin
+printf '\377' | dd of=bad.bin bs=1 seek=40 conv=notrunc 2> /dev/null
+$M -verify bad.bin bad.out 100 > bad.log
+check "a changed checksum is refused" grep -qxF '*error* bad.bin fails its checksum' bad.log
+cp e1.bin bad.bin
+printf '\377' | dd of=bad.bin bs=1 seek=100 conv=notrunc 2> /dev/null
+$M -verify bad.bin bad.out 100 > bad.log
+check "and so is a changed value" grep -qxF '*error* bad.bin fails its checksum' bad.log
+
+# the results file, read back with od, against the text report
+Off() {         # Off block: where block (0 to 8) of res.bin starts
+  od -An -t u8 -j $((88 + 8 * $1)) -N 8 res.bin | tr -d ' '
+}
+Vals() {        # Vals block n: its first n doubles, one a line
+  od -An -v -t f8 -j `Off $1` -N $(($2 * 8)) res.bin | tr -s ' ' '\n' | sed '/^$/d'
+}
+check "-results writes a results file" $M -results res.bin MULCROSS.DAT res.out 100
+check "with its magic" test "`head -c 8 res.bin`" = MOUTRES1
+check "p" test `od -An -t u4 -j 12 -N 4 res.bin` = 10
+check "and n" test `od -An -t u8 -j 16 -N 8 res.bin` = 200
+od -An -t f8 -j 32 -N 16 res.bin | awk '{printf "%.3E %.3E\n", $1, $2}' > cut.txt
+check "the first stage cutoff is the report's" \
+  grep -q "cutoff `cut -d' ' -f1 cut.txt` taken from" res.out
+check "and so is the final one" \
+  grep -q "determined to be `cut -d' ' -f2 cut.txt`\$" res.out
+Vals 0 10 | awk '{printf "%12.3E\n", $1}' > mean.txt
+awk '/^Robust M-Estimate Mean:/ {on = 1; next} on && /^$/ {exit} on' res.out > mean.rep
+check "the M-estimate location is the report's" cmp mean.txt mean.rep
+Vals 1 100 | awk '{printf "%12.3E", $1} NR % 10 == 0 {print ""}' > cov.txt
+awk '/^M-Estimate of Covariance/ {on = 1; next} on && /^$/ {exit} on' res.out > cov.rep
+check "and so is its scatter" cmp cov.txt cov.rep
+Vals 5 200 > dist.txt
+od -An -v -t u1 -j `Off 7` -N 200 res.bin | tr -s ' ' '\n' | sed '/^$/d' > flag.txt
+paste flag.txt dist.txt |
+  awk '{printf "%s point %3d: %.3E\n", $1 ? "*" : " ", NR, $2}' > list.txt
+grep "point .*:" res.out > list.rep
+check "the distances and flags are the report's" cmp list.txt list.rep
+
+# the model file: scoring the data with it gives the report's distances;
+# a model cut short, or read from a pipe, is refused
+check "-model writes a model file" $M -model fit.mod MULCROSS.DAT fit.out 100
+check "which -score reads back" $M -score fit.mod MULCROSS.DAT fit.sco
+awk '!/^#/ {printf "%s point %3d: %.3E\n", $3 ? "*" : " ", $1, $2}' fit.sco > list.txt
+grep "point .*:" fit.out > list.rep
+check "scoring the data gives the report's distances and flags" cmp list.txt list.rep
+head -c 1000 fit.mod > bad.mod
+$M -score bad.mod MULCROSS.DAT bad.sco > bad.log
+check "a model cut short is refused" \
+  grep -qxF '*error* bad.mod is cut short or has a bad header' bad.log
+head -c 30 fit.mod > bad.mod
+$M -score bad.mod MULCROSS.DAT bad.sco > bad.log
+check "as is one without a whole header" \
+  grep -qxF '*error* bad.mod is not a multout model file' bad.log
+cat fit.mod | $M -score /dev/stdin MULCROSS.DAT bad.sco > bad.log
+check "and one read from a pipe" \
+  grep -qxF '*error* /dev/stdin is not a multout model file' bad.log
+
+cd ..
+rm -rf $D
+if [ $Fails -ne 0 ]; then echo "test_cli FAILED"; exit 1; fi
+echo "test_cli passed"
@@ -0,0 +1,221 @@
+/* TEST_SERVE.C: checks of multout -serve over its socket (make test) */
+/* usage: test_serve multout model; it starts a server with two threads */
+/* on a socket of its own, sends it malformed and idle connections as */
+/* well as good requests, and checks that it keeps answering */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define SOCK "test_serve.sock"
+#define SERVE_MAX (1L << 28)    /* as in multout.c */
+#define True -1
+#define False 0
+
+struct Req {                    /* as in multout.c (see README.md) */
+    char Magic[4];
+    uint32_t Op, NameLen, p;
+    uint64_t n;
+};
+struct Rep {
+    char Magic[4];
+    int32_t Status;
+    uint32_t p, FileCols;
+    uint64_t n;
+    double Cut;
+};
+char *Model;                    /* its name, as the server knows it */
+int Fails = 0;
+
+/*------------------------------------------------------------------*/
+int Connect()
+{
+    struct sockaddr_un a;
+    int fd;
+
+    memset(&a, 0, sizeof(a));
+    a.sun_family = AF_UNIX;
+    strcpy(a.sun_path, SOCK);
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&a, sizeof(a))) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+}
+
+/*------------------------------------------------------------------*/
+int Get(int fd, void *Buf, size_t Len)
+{
+    char *p = Buf;
+    ssize_t r;
+
+    for (; Len; p += r, Len -= r)
+      if ((r = read(fd, p, Len)) <= 0) return False;
+    return True;
+}
+
+/*------------------------------------------------------------------*/
+void Send(int fd, uint32_t Op, uint32_t NameLen, uint32_t p, uint64_t n,
+          void *Data, size_t Len)
+/* a request header as given, whatever Data follows, and no more */
+{
+    struct Req q;
+
+    memcpy(q.Magic, "MOSQ", 4);
+    q.Op = Op; q.NameLen = NameLen; q.p = p; q.n = n;
+    if (write(fd, &q, sizeof(q)) == sizeof(q) && Len) write(fd, Data, Len);
+}
+
+/*------------------------------------------------------------------*/
+int Ask(int fd, char *Magic, uint32_t Op, char *Name, uint32_t p,
+        uint64_t n, double *x, struct Rep *r)
+/* send a request (x may be NULL to send no values) and read the reply */
+/* header and what follows it; False if there is no reply. A server */
+/* that refuses a request may close before it has all been sent, so */
+/* the writes are not checked */
+{
+    struct Req q;
+    char Tail[1 << 16];
+
+    memcpy(q.Magic, Magic, 4);
+    q.Op = Op; q.NameLen = strlen(Name); q.p = p; q.n = n;
+    if (write(fd, &q, sizeof(q)) == sizeof(q)
+        && write(fd, Name, q.NameLen) == (ssize_t)q.NameLen && x)
+      write(fd, x, n * p * sizeof(double));
+    if (!Get(fd, r, sizeof(*r)) || memcmp(r->Magic, "MOSR", 4)) return False;
+    if (r->Status) return r->n < sizeof(Tail) && Get(fd, Tail, r->n);
+    if (Op == 2) return Get(fd, Tail, r->p * sizeof(int));
+    return Get(fd, Tail, r->n * 9);
+}
+
+/*------------------------------------------------------------------*/
+void Check(int Ok, char *What)
+{
+    printf("%s: %s\n", Ok ? "ok" : "FAILED", What);
+    if (!Ok) Fails++;
+}
+
+/*------------------------------------------------------------------*/
+int Alive()
+/* a good info request on a new connection is answered */
+{
+    struct Rep r;
+    int fd, Ok;
+
+    if ((fd = Connect()) < 0) return False;
+    Ok = Ask(fd, "MOSQ", 2, Model, 0, 0, NULL, &r) && r.Status == 0;
+    close(fd);
+    return Ok;
+}
+
+/*------------------------------------------------------------------*/
+int Refused(char *Magic, uint32_t Op, char *Name, uint32_t p, uint64_t n)
+/* a request is refused, and the connection closed after it */
+{
+    struct Rep r;
+    char c;
+    int fd, Ok;
+
+    if ((fd = Connect()) < 0) return False;
+    Ok = Ask(fd, Magic, Op, Name, p, n, NULL, &r) && r.Status != 0
+         && read(fd, &c, 1) == 0;
+    close(fd);
+    return Ok;
+}
+
+/*------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    struct Rep r;
+    char Long[300];
+    double x[20], t;
+    int fd, Idle[3], i;
+    pid_t Pid;
+    struct timespec t0, t1;
+
+    if (argc != 3) {
+      printf("Usage: test_serve multout model\n");
+      exit(1);
+    }
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    Model = strrchr(argv[2], '/') ? strrchr(argv[2], '/') + 1 : argv[2];
+    unlink(SOCK);
+    if ((Pid = fork()) == 0) {
+      freopen("/dev/null", "w", stdout);
+      execl(argv[1], argv[1], "-jobs", "2", "-serve", SOCK, argv[2], (char *)NULL);
+      exit(1);
+    }
+    for (i = 0; i < 100 && (fd = Connect()) < 0; i++) usleep(50000);
+    if (fd < 0) {
+      printf("FAILED: the server did not start\n");
+      kill(Pid, SIGTERM);
+      exit(1);
+    }
+    close(fd);
+
+    Check(Alive(), "an info request is answered");
+    Check(Refused("XXXX", 1, Model, 10, 1), "a bad magic is refused");
+    Check(Refused("MOSQ", 7, Model, 10, 1), "an unknown operation is refused");
+    Check(Refused("MOSQ", 2, Model, 0, (uint64_t)1 << 60),
+          "an info request with rows is refused");
+    Check(Refused("MOSQ", 1, Model, 10, (uint64_t)1 << 60),
+          "a score request over the size limit is refused");
+    Check(Refused("MOSQ", 1, Model, 10, SERVE_MAX / 80 + 1),
+          "and one just over it");
+    Check(Refused("MOSQ", 1, Model, 0xffffffff, 1),
+          "and one row too long for it");
+    Check(Refused("MOSQ", 1, Model, 0, 1), "a score request with p = 0 is refused");
+    memset(Long, 'a', sizeof(Long) - 1); Long[sizeof(Long) - 1] = 0;
+    Check(Refused("MOSQ", 2, Long, 0, 0), "a name of 299 bytes is refused");
+    if ((fd = Connect()) >= 0) {       /* half a header, then gone */
+      write(fd, "MOSQ\1", 5);
+      close(fd);
+    }
+    if ((fd = Connect()) >= 0) {       /* part of the name */
+      Send(fd, 1, 20, 10, 2, "abc", 3);
+      close(fd);
+    }
+    if ((fd = Connect()) >= 0) {       /* half of the values */
+      for (i = 0; i < 20; i++) x[i] = i;
+      Send(fd, 1, strlen(Model), 10, 2, Model, strlen(Model));
+      write(fd, x, 10 * sizeof(double));
+      close(fd);
+    }
+    if ((fd = Connect()) >= 0) {       /* junk in place of a header */
+      memset(Long, 0xff, sizeof(Long));
+      write(fd, Long, sizeof(Long));
+      close(fd);
+    }
+    Check(Alive(), "the server is still up after requests cut short or garbled");
+
+    if ((fd = Connect()) >= 0) {
+      for (i = 0; i < 20; i++) x[i] = i % 3;
+      Check(Ask(fd, "MOSQ", 1, "nosuch.mod", 10, 2, x, &r) && r.Status != 0
+            && Ask(fd, "MOSQ", 1, Model, 10, 2, x, &r) && r.Status == 0
+            && r.n == 2, "an unknown model is refused, and the connection kept");
+      close(fd);
+    } else Check(False, "connect");
+
+    for (i = 0; i < 3; i++) Idle[i] = Connect();
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    Check(Alive(), "three idle connections do not hold up a fourth");
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    t = t1.tv_sec - t0.tv_sec + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+    Check(t < 0.5, "and it is answered at once");
+    for (i = 0; i < 3; i++) close(Idle[i]);
+
+    kill(Pid, SIGTERM);
+    waitpid(Pid, NULL, 0);
+    Check(access(SOCK, F_OK) != 0, "the socket is removed when the server stops");
+    printf("%s\n", Fails ? "test_serve FAILED" : "test_serve passed");
+    return Fails ? 1 : 0;
+}